@@ -3,8 +3,16 @@ TEMPLATE = subdirs
 SUBDIRS += \
     gallerycore \
     gallerydesktop \
-    gallerymobile
+    gallerymobile \
+    gallerybench \
+    gallerygen \
+    gallerycli \
+    galleryreplay
 
 
 
 gallerydesktop.depends = gallerycore
+gallerybench.depends = gallerycore
+gallerygen.depends = gallerycore
+gallerycli.depends = gallerycore
+galleryreplay.depends = gallerycore
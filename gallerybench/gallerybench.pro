@@ -0,0 +1,28 @@
+QT       += testlib sql gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = gallerybench
+
+# Microbenchmarks de gallerycore y del camino de los thumbnails (QBENCHMARK)
+#
+# Resultados legibles por máquina, por ejemplo:
+#   ./gallerybench -o results.xml,xml
+#   ./gallerybench -o results.csv,csv -o -,txt
+
+SOURCES += \
+    tst_gallerybench.cpp \
+    ../gallerydesktop/picturedelegate.cpp \
+    ../gallerydesktop/thumbnailproxymodel.cpp
+
+HEADERS += \
+    ../gallerydesktop/picturedelegate.h \
+    ../gallerydesktop/thumbnailproxymodel.h
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/release/ -lgallerycore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/debug/ -lgallerycore
+else:unix: LIBS += -L$$OUT_PWD/../gallerycore/ -lgallerycore
+
+INCLUDEPATH += $$PWD/../gallerycore $$PWD/../gallerydesktop
+DEPENDPATH += $$PWD/../gallerycore
@@ -0,0 +1,431 @@
+#include <QtTest>
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QSqlDatabase>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <map>
+#include <memory>
+#include "Albumdao.h"
+#include "AlbumModel.h"
+#include "DatabaseManager.h"
+#include "Picture.h"
+#include "PictureDao.h"
+#include "Picturemodel.h"
+#include "ThumbnailCache.h"
+#include "picturedelegate.h"
+#include "thumbnailproxymodel.h"
+
+// Tamaños de catálogo medidos (número de imágenes del álbum principal)
+const QList<int> CATALOG_SIZES = { 1000, 10000, 100000 };
+
+// Imágenes por álbum en la lista de álbumes: un catálogo de N imágenes tiene
+// N / PICTURES_PER_ALBUM álbumes
+const int PICTURES_PER_ALBUM = 100;
+
+// Imágenes por lote en addPictureInAlbum por lotes
+const int INSERT_BATCH_SIZE = 500;
+
+// Imágenes JPEG reales para medir los thumbnails y el delegate
+const int THUMBNAIL_FILES = 24;
+const QSize THUMBNAIL_SOURCE_SIZE(2048, 1536);
+const int THUMBNAIL_SIZE = 350;
+
+// Superficie donde se pinta el delegate (una pantalla típica)
+const QSize PAINT_SURFACE_SIZE(1920, 1080);
+
+/**
+ * Catálogo de prueba en su propio archivo y conexión
+ *
+ * Se crea con su propio DatabaseManager, así que tiene el mismo esquema
+ * (índice de búsqueda y triggers incluidos) y los mismos PRAGMAs que el
+ * catálogo de la aplicación, y cada tamaño es independiente del singleton.
+ */
+struct BenchCatalog
+{
+    explicit BenchCatalog(const QString& path) :
+        manager(path),
+        database(QSqlDatabase::database(manager.connectionName())),
+        albumDao(manager.albumDao),
+        pictureDao(manager.pictureDao)
+    {
+    }
+
+    DatabaseManager manager;
+    QSqlDatabase database;      // Se destruye antes de cerrar la conexión del manager
+    const AlbumDao& albumDao;
+    const PictureDao& pictureDao;
+    int albumId = -1;           // Álbum con todas las imágenes
+    int scratchAlbumId = -1;    // Álbum donde se insertan las imágenes de los benchmarks
+};
+
+/**
+ * Microbenchmarks de gallerycore y del camino de los thumbnails
+ *
+ * Los catálogos y las imágenes se generan una vez en una carpeta temporal;
+ * la carpeta de trabajo y la caché de la aplicación apuntan a ella, así que
+ * el benchmark no toca la galería del usuario.
+ */
+class GalleryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void albums_data();
+    void albums();
+    void picturesForAlbum_data();
+    void picturesForAlbum();
+    void addPictureSingle_data();
+    void addPictureSingle();
+    void addPictureBatch_data();
+    void addPictureBatch();
+    void setAlbumId_data();
+    void setAlbumId();
+    void generateThumbnail();
+    void loadThumbnails();
+    void paintDelegate();
+
+private:
+    BenchCatalog& catalog(int size);
+    void addCatalogSizes();
+    static void fillAlbum(const PictureDao& pictureDao, QSqlDatabase& database,
+                          int albumId, const QString& directory, int count);
+    int managerAlbum(int size);
+
+    QTemporaryDir mDirectory;
+    QStringList mImageFiles;
+    std::map<int, std::unique_ptr<BenchCatalog>> mCatalogs;
+    std::unique_ptr<DatabaseManager> mManager;  // Catálogo de los modelos
+    QHash<int, int> mManagerAlbums;     // Tamaño -> álbum en el catálogo de los modelos
+    int mImageAlbumId = -1;             // Álbum de los modelos con las imágenes JPEG
+    int mInsertCount = 0;
+};
+
+/**
+ * Prepara la carpeta temporal y genera las imágenes JPEG de prueba
+ */
+void GalleryBenchmark::initTestCase()
+{
+    QVERIFY(mDirectory.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Por si algo abre el catálogo de la aplicación (gallery.db en la carpeta
+    // de trabajo); los modelos usan su propio DatabaseManager
+    QDir::setCurrent(mDirectory.path());
+
+    // Degradado con algo de detalle: el decodificador JPEG trabaja como con una foto
+    QImage image(THUMBNAIL_SOURCE_SIZE, QImage::Format_RGB32);
+    for (int i = 0; i < THUMBNAIL_FILES; ++i) {
+        for (int y = 0; y < image.height(); ++y) {
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                line[x] = qRgb((x + i * 17) & 0xff, (y + i * 31) & 0xff, ((x ^ y) + i) & 0xff);
+            }
+        }
+        QString filePath = mDirectory.filePath(QString("image-%1.jpg").arg(i));
+        QVERIFY(image.save(filePath, "JPEG", 90));
+        mImageFiles << filePath;
+    }
+
+    mManager = std::make_unique<DatabaseManager>(mDirectory.filePath("models.db"));
+    DatabaseManager& db = *mManager;
+    Album album("Benchmark images");
+    db.albumDao.addAlbum(album);
+    mImageAlbumId = album.id();
+    for (const QString& filePath : std::as_const(mImageFiles)) {
+        Picture picture(filePath);
+        db.pictureDao.addPictureInAlbum(mImageAlbumId, picture);
+    }
+}
+
+/**
+ * Cierra las conexiones de los catálogos de prueba
+ */
+void GalleryBenchmark::cleanupTestCase()
+{
+    // Cada DatabaseManager cierra y quita su conexión al destruirse
+    mCatalogs.clear();
+    mManager.reset();
+}
+
+/**
+ * Añade una fila de datos por tamaño de catálogo
+ */
+void GalleryBenchmark::addCatalogSizes()
+{
+    QTest::addColumn<int>("size");
+    for (int size : CATALOG_SIZES) {
+        QTest::newRow(qPrintable(QString::number(size))) << size;
+    }
+}
+
+/**
+ * Inserta imágenes ficticias en un álbum, en una sola transacción
+ * Las rutas no existen: las consultas no leen los archivos.
+ */
+void GalleryBenchmark::fillAlbum(const PictureDao& pictureDao, QSqlDatabase& database,
+                                 int albumId, const QString& directory, int count)
+{
+    database.transaction();
+    for (int i = 0; i < count; ++i) {
+        Picture picture(QString("%1/picture-%2.jpg").arg(directory).arg(i, 6, 10, QChar('0')));
+        pictureDao.addPictureInAlbum(albumId, picture);
+    }
+    database.commit();
+}
+
+/**
+ * Obtiene (y la primera vez genera) el catálogo de un tamaño
+ * @param size Número de imágenes del álbum principal
+ */
+BenchCatalog& GalleryBenchmark::catalog(int size)
+{
+    auto it = mCatalogs.find(size);
+    if (it != mCatalogs.end()) {
+        return *it->second;
+    }
+
+    auto catalog = std::make_unique<BenchCatalog>(mDirectory.filePath(QString("catalog-%1.db").arg(size)));
+
+    catalog->database.transaction();
+    for (int i = 0; i < qMax(1, size / PICTURES_PER_ALBUM); ++i) {
+        Album album(QString("Album %1").arg(i));
+        catalog->albumDao.addAlbum(album);
+        if (catalog->albumId < 0) {
+            catalog->albumId = album.id();
+        }
+    }
+    Album scratch("Scratch");
+    catalog->albumDao.addAlbum(scratch);
+    catalog->scratchAlbumId = scratch.id();
+    catalog->database.commit();
+
+    fillAlbum(catalog->pictureDao, catalog->database, catalog->albumId, "/bench/main", size);
+
+    return *(mCatalogs[size] = std::move(catalog));
+}
+
+/**
+ * Obtiene (y la primera vez genera) un álbum de un tamaño en el catálogo
+ * que usan los modelos
+ */
+int GalleryBenchmark::managerAlbum(int size)
+{
+    if (mManagerAlbums.contains(size)) {
+        return mManagerAlbums.value(size);
+    }
+
+    DatabaseManager& db = *mManager;
+    Album album(QString("Benchmark %1").arg(size));
+    db.albumDao.addAlbum(album);
+    QSqlDatabase database = QSqlDatabase::database(db.connectionName());
+    fillAlbum(db.pictureDao, database, album.id(),
+              QString("/bench/model-%1").arg(size), size);
+
+    mManagerAlbums.insert(size, album.id());
+    return album.id();
+}
+
+void GalleryBenchmark::albums_data()
+{
+    addCatalogSizes();
+}
+
+/**
+ * AlbumDao::albums(): lista completa de álbumes (N / 100 álbumes)
+ */
+void GalleryBenchmark::albums()
+{
+    QFETCH(int, size);
+    BenchCatalog& bench = catalog(size);
+
+    QBENCHMARK {
+        QVector<Album> result = bench.albumDao.albums();
+        QVERIFY(!result.isEmpty());
+    }
+}
+
+void GalleryBenchmark::picturesForAlbum_data()
+{
+    addCatalogSizes();
+}
+
+/**
+ * PictureDao::picturesForAlbum(): todas las imágenes de un álbum de N imágenes
+ */
+void GalleryBenchmark::picturesForAlbum()
+{
+    QFETCH(int, size);
+    BenchCatalog& bench = catalog(size);
+
+    QBENCHMARK {
+        QVector<Picture*> pictures = bench.pictureDao.picturesForAlbum(bench.albumId);
+        QCOMPARE(pictures.count(), size);
+        qDeleteAll(pictures);
+    }
+}
+
+void GalleryBenchmark::addPictureSingle_data()
+{
+    addCatalogSizes();
+}
+
+/**
+ * PictureDao::addPictureInAlbum(): una imagen, con su propia transacción
+ */
+void GalleryBenchmark::addPictureSingle()
+{
+    QFETCH(int, size);
+    BenchCatalog& bench = catalog(size);
+
+    QBENCHMARK {
+        Picture picture(QString("/bench/single/picture-%1.jpg").arg(mInsertCount++));
+        bench.pictureDao.addPictureInAlbum(bench.scratchAlbumId, picture);
+    }
+}
+
+void GalleryBenchmark::addPictureBatch_data()
+{
+    addCatalogSizes();
+}
+
+/**
+ * PictureDao::addPictureInAlbum(): INSERT_BATCH_SIZE imágenes en una transacción
+ */
+void GalleryBenchmark::addPictureBatch()
+{
+    QFETCH(int, size);
+    BenchCatalog& bench = catalog(size);
+
+    QBENCHMARK {
+        fillAlbum(bench.pictureDao, bench.database, bench.scratchAlbumId,
+                  QString("/bench/batch-%1").arg(mInsertCount++), INSERT_BATCH_SIZE);
+    }
+}
+
+void GalleryBenchmark::setAlbumId_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("cached");
+    for (int size : CATALOG_SIZES) {
+        QTest::newRow(qPrintable(QString("%1 cold").arg(size))) << size << false;
+        QTest::newRow(qPrintable(QString("%1 cached").arg(size))) << size << true;
+    }
+}
+
+/**
+ * PictureModel::setAlbumId(): abrir un álbum de N imágenes (primera página)
+ *
+ * "cold" descarta antes la instantánea del álbum, así que consulta la base
+ * de datos; "cached" mide el cambio entre dos álbumes ya visitados.
+ */
+void GalleryBenchmark::setAlbumId()
+{
+    QFETCH(int, size);
+    QFETCH(bool, cached);
+    int albumId = managerAlbum(size);
+
+    AlbumModel albumModel(*mManager);
+    PictureModel pictureModel(albumModel);
+
+    QBENCHMARK {
+        if (!cached) {
+            pictureModel.invalidateAlbum(albumId);
+        }
+        pictureModel.setAlbumId(albumId);
+        pictureModel.setAlbumId(mImageAlbumId);
+    }
+    QVERIFY(pictureModel.rowCount() > 0);
+}
+
+/**
+ * ThumbnailCache::generate(): decodificar una imagen al tamaño del thumbnail
+ */
+void GalleryBenchmark::generateThumbnail()
+{
+    const ThumbnailCache cache(THUMBNAIL_SIZE, mDirectory.filePath("thumbnails"));
+    int file = 0;
+
+    QBENCHMARK {
+        QImage thumbnail = cache.generate(mImageFiles[file++ % mImageFiles.count()]);
+        QVERIFY(!thumbnail.isNull());
+    }
+}
+
+/**
+ * Carga de los thumbnails de un álbum en un ThumbnailProxyModel nuevo
+ *
+ * generateThumbnails() es privado; se mide el mismo camino (loadThumbnail)
+ * pidiendo DecorationRole de cada fila, como hace la vista. La caché de
+ * disco ya está caliente después de la primera iteración.
+ */
+void GalleryBenchmark::loadThumbnails()
+{
+    AlbumModel albumModel(*mManager);
+    PictureModel pictureModel(albumModel);
+    pictureModel.setAlbumId(mImageAlbumId);
+    QCOMPARE(pictureModel.rowCount(), THUMBNAIL_FILES);
+
+    QBENCHMARK {
+        ThumbnailProxyModel proxy(*mManager);
+        proxy.setSourceModel(&pictureModel);
+        for (int row = 0; row < proxy.rowCount(); ++row) {
+            QVERIFY(!proxy.data(proxy.index(row, 0), Qt::DecorationRole).isNull());
+        }
+    }
+}
+
+/**
+ * PictureDelegate::paint(): pintar una pantalla de thumbnails en una
+ * superficie fuera de pantalla (los thumbnails ya están en memoria)
+ */
+void GalleryBenchmark::paintDelegate()
+{
+    AlbumModel albumModel(*mManager);
+    PictureModel pictureModel(albumModel);
+    pictureModel.setAlbumId(mImageAlbumId);
+    ThumbnailProxyModel proxy(*mManager);
+    proxy.setSourceModel(&pictureModel);
+
+    PictureDelegate delegate;
+    QStyleOptionViewItem option;
+    QSize itemSize = delegate.sizeHint(option, proxy.index(0, 0));
+    QImage surface(PAINT_SURFACE_SIZE, QImage::Format_ARGB32_Premultiplied);
+
+    // Rellena la caché de thumbnails antes de medir
+    for (int row = 0; row < proxy.rowCount(); ++row) {
+        proxy.data(proxy.index(row, 0), Qt::DecorationRole);
+    }
+
+    QBENCHMARK {
+        QPainter painter(&surface);
+        int row = 0;
+        for (int y = 0; y + itemSize.height() <= surface.height(); y += itemSize.height()) {
+            for (int x = 0; x + itemSize.width() <= surface.width(); x += itemSize.width()) {
+                option.rect = QRect(QPoint(x, y), itemSize);
+                option.state = (row % 7 == 0) ? QStyle::State_Selected : QStyle::State_None;
+                delegate.paint(&painter, option, proxy.index(row++ % proxy.rowCount(), 0));
+            }
+        }
+    }
+}
+
+/**
+ * Punto de entrada: la plataforma "offscreen" permite pintar sin pantalla
+ * (por ejemplo, en integración continua)
+ */
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    GalleryBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "tst_gallerybench.moc"
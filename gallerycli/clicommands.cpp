@@ -0,0 +1,605 @@
+#include "clicommands.h"
+#include <atomic>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPair>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include "DatabaseManager.h"
+#include "ImportPipeline.h"
+#include "MetadataExtractor.h"
+#include "PerceptualHash.h"
+#include "ThumbnailCache.h"
+
+// Mismo tamaño que los thumbnails de gallerydesktop, para rellenar su caché
+const int THUMBNAIL_SIZE = 350;
+
+// Intervalo de actualización de la línea de progreso
+const int PROGRESS_INTERVAL_MS = 250;
+
+/**
+ * Archivo del catálogo con su ruta completa
+ */
+struct CatalogFile
+{
+    int directoryId;
+    QString name;
+    QString path;
+    qint64 byteSize;
+    qint64 modifiedAt;
+    quint64 perceptualHash;
+    QList<int> albumIds;
+};
+
+/**
+ * Obtiene los archivos del catálogo, carpeta a carpeta
+ * @param db Catálogo
+ * @param albumId Solo los archivos de este álbum (-1 = todos)
+ * @return Archivos, una sola vez aunque estén en varios álbumes
+ */
+static QVector<CatalogFile> catalogFiles(const DatabaseManager& db, int albumId)
+{
+    QVector<CatalogFile> files;
+    for (int directoryId : db.directoryDao.directoryIds()) {
+        const QString directory = db.directoryDao.path(directoryId);
+        for (const PictureFile& file : db.pictureDao.filesInDirectory(directoryId)) {
+            if (albumId > 0 && !file.albumIds.contains(albumId)) {
+                continue;
+            }
+            files.append({ directoryId, file.name, DirectoryDao::joinPath(directory, file.name),
+                           file.byteSize, file.modifiedAt, file.perceptualHash, file.albumIds });
+        }
+    }
+    return files;
+}
+
+/**
+ * Muestra el progreso en una sola línea de stderr (stdout queda para los resultados)
+ */
+static void printProgress(qint64 done, qint64 total)
+{
+    QTextStream(stderr) << "\r  " << done << " / " << total << "   ";
+}
+
+/**
+ * Termina la línea de progreso
+ */
+static void endProgress()
+{
+    QTextStream(stderr) << "\n";
+}
+
+/**
+ * Espera a que termine una operación de QtConcurrent mostrando su progreso
+ */
+template <typename T>
+static void waitWithProgress(const QFuture<T>& future)
+{
+    while (!future.isFinished()) {
+        printProgress(future.progressValue(), future.progressMaximum());
+        QThread::msleep(PROGRESS_INTERVAL_MS);
+    }
+    printProgress(future.progressMaximum(), future.progressMaximum());
+    endProgress();
+}
+
+/**
+ * Muestra el rendimiento de un subcomando
+ * @param command Nombre del subcomando
+ * @param count Elementos procesados
+ * @param unit Nombre de los elementos ("archivos", "imágenes"...)
+ * @param elapsedMs Duración en milisegundos
+ * @param bytes Bytes leídos, o -1 si no se miden
+ */
+static void printThroughput(const QString& command, qint64 count, const QString& unit,
+                            qint64 elapsedMs, qint64 bytes = -1)
+{
+    const double seconds = qMax<qint64>(elapsedMs, 1) / 1000.0;
+    QTextStream out(stdout);
+    out << command << ": " << count << ' ' << unit
+        << " en " << QString::number(seconds, 'f', 1) << " s ("
+        << QString::number(count / seconds, 'f', 1) << ' ' << unit << "/s";
+    if (bytes >= 0) {
+        out << ", " << QString::number(bytes / seconds / (1024 * 1024), 'f', 1) << " MB/s";
+    }
+    out << ")\n";
+}
+
+/**
+ * Lee la opción --album de un subcomando
+ * @return ID del álbum, -1 si no se ha indicado, o 0 si no existe
+ */
+static int albumArgument(const QCommandLineParser& parser, const QCommandLineOption& option)
+{
+    if (!parser.isSet(option)) {
+        return -1;
+    }
+    const int albumId = parser.value(option).toInt();
+    if (albumId <= 0 || DatabaseManager::instance().albumDao.album(albumId).id() != albumId) {
+        QTextStream(stderr) << "El álbum " << parser.value(option) << " no existe\n";
+        return 0;
+    }
+    return albumId;
+}
+
+/**
+ * gallerycli import <carpeta>: importa una carpeta con ImportPipeline
+ *
+ * Es la misma importación que la de gallerydesktop (metadatos, hashes,
+ * thumbnails y escritura por lotes en paralelo), con un bucle de eventos
+ * propio para recibir sus señales.
+ */
+int CliCommands::importFolder(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Importa una carpeta y sus subcarpetas en el catálogo.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("folder", "Carpeta a importar.");
+    QCommandLineOption albumOption("album", "Álbum de destino (por defecto, uno nuevo con el nombre de la carpeta).", "id");
+    QCommandLineOption perFolderOption("album-per-folder", "Crea un álbum por cada subcarpeta.");
+    QCommandLineOption thumbnailOption("thumbnail-size", "Tamaño de los thumbnails a generar (0 = ninguno).",
+                                       "pixels", QString::number(THUMBNAIL_SIZE));
+    QCommandLineOption duplicatesOption("duplicates", "Archivos ya catalogados: link, skip o keep.", "policy", "link");
+    parser.addOptions({ albumOption, perFolderOption, thumbnailOption, duplicatesOption });
+    parser.process(arguments);
+
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+
+    QTextStream err(stderr);
+    ImportOptions options;
+    options.rootPath = parser.positionalArguments().first();
+    options.albumPerFolder = parser.isSet(perFolderOption);
+    options.thumbnailSize = qMax(0, parser.value(thumbnailOption).toInt());
+
+    const QString duplicates = parser.value(duplicatesOption);
+    if (duplicates == "link") {
+        options.duplicates = ImportOptions::LinkDuplicates;
+    } else if (duplicates == "skip") {
+        options.duplicates = ImportOptions::SkipDuplicates;
+    } else if (duplicates == "keep") {
+        options.duplicates = ImportOptions::KeepDuplicates;
+    } else {
+        err << "Política de duplicados desconocida: " << duplicates << "\n";
+        return 1;
+    }
+
+    // Abre el catálogo: la importación clona su conexión
+    DatabaseManager& db = DatabaseManager::instance();
+    options.albumId = albumArgument(parser, albumOption);
+    if (options.albumId == 0) {
+        return 1;
+    }
+
+    ImportPipeline pipeline(db);
+    QEventLoop loop;
+    int imported = 0;
+    int duplicateCount = 0;
+    bool cancelled = false;
+    QObject::connect(&pipeline, &ImportPipeline::progress, [] (int processed, int discovered) {
+        printProgress(processed, discovered);
+    });
+    QObject::connect(&pipeline, &ImportPipeline::finished,
+                     [&] (int importedFiles, int duplicateFiles, bool wasCancelled) {
+        imported = importedFiles;
+        duplicateCount = duplicateFiles;
+        cancelled = wasCancelled;
+        loop.quit();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!pipeline.start(options)) {
+        err << "No se puede importar " << options.rootPath << "\n";
+        return 1;
+    }
+    loop.exec();
+    endProgress();
+
+    printThroughput("import", imported + duplicateCount, "archivos", timer.elapsed());
+    QTextStream(stdout) << imported << " importados, " << duplicateCount << " duplicados\n";
+    return cancelled ? 1 : 0;
+}
+
+/**
+ * gallerycli prewarm: genera los thumbnails que faltan en la caché en disco
+ *
+ * Usa la misma ThumbnailCache (carpeta y tamaño) que gallerydesktop, así que
+ * al abrir la aplicación los álbumes se muestran sin decodificar imágenes.
+ * Las imágenes ya en caché solo cuestan una comprobación de existencia.
+ *
+ * Las imágenes sin hash perceptual (catálogos anteriores al hash) lo
+ * obtienen del thumbnail y se guarda al terminar, así que "mostrar
+ * similares" encuentra todo el catálogo.
+ */
+int CliCommands::prewarmThumbnails(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Genera los thumbnails del catálogo que aún no están en caché y los hashes perceptuales que faltan.");
+    parser.addHelpOption();
+    QCommandLineOption albumOption("album", "Solo las imágenes de este álbum.", "id");
+    QCommandLineOption sizeOption("size", "Tamaño de los thumbnails.", "pixels", QString::number(THUMBNAIL_SIZE));
+    QCommandLineOption threadsOption("threads", "Hilos de decodificación (0 = uno por núcleo).", "count", "0");
+    parser.addOptions({ albumOption, sizeOption, threadsOption });
+    parser.process(arguments);
+
+    const int albumId = albumArgument(parser, albumOption);
+    if (albumId == 0) {
+        return 1;
+    }
+
+    DatabaseManager& db = DatabaseManager::instance();
+    QVector<CatalogFile> files = catalogFiles(db, albumId);
+    const ThumbnailCache cache(qMax(1, parser.value(sizeOption).toInt()));
+
+    QThreadPool pool;
+    if (parser.value(threadsOption).toInt() > 0) {
+        pool.setMaxThreadCount(parser.value(threadsOption).toInt());
+    }
+
+    std::atomic<int> generated(0);
+    std::atomic<int> cached(0);
+    std::atomic<int> failed(0);
+    std::atomic<qint64> bytesRead(0);
+
+    // Hashes perceptuales calculados, por archivo
+    QMutex hashesMutex;
+    QVector<QPair<const CatalogFile*, quint64>> hashes;
+
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<void> future = QtConcurrent::map(&pool, files, [&] (const CatalogFile& file) {
+        if (cache.contains(file.path) && file.perceptualHash != 0) {
+            ++cached;
+            return;
+        }
+
+        bool wasCached = cache.contains(file.path);
+        QImage thumbnail = cache.thumbnail(file.path);
+        if (thumbnail.isNull()) {
+            ++failed;
+            return;
+        }
+        if (wasCached) {
+            ++cached;
+        } else {
+            ++generated;
+            bytesRead += file.byteSize;
+        }
+
+        if (file.perceptualHash == 0) {
+            quint64 hash = PerceptualHash::image(thumbnail);
+            if (hash != 0) {
+                QMutexLocker locker(&hashesMutex);
+                hashes.append(qMakePair(&file, hash));
+            }
+        }
+    });
+    waitWithProgress(future);
+
+    QSqlDatabase database = QSqlDatabase::database(db.connectionName());
+    database.transaction();
+    for (const auto& entry : std::as_const(hashes)) {
+        db.pictureDao.setPerceptualHash(entry.first->directoryId, entry.first->name, entry.second);
+    }
+    if (!database.commit()) {
+        QTextStream(stderr) << "No se pudieron guardar los hashes perceptuales: "
+                            << database.lastError().text() << "\n";
+        database.rollback();
+        return 1;
+    }
+
+    printThroughput("prewarm", files.count(), "imágenes", timer.elapsed(), bytesRead.load());
+    QTextStream(stdout) << generated.load() << " generados, " << cached.load() << " ya en caché, "
+                        << failed.load() << " ilegibles, " << hashes.count()
+                        << " hashes perceptuales\n";
+    return 0;
+}
+
+/**
+ * gallerycli verify: comprueba que los archivos del catálogo siguen en disco
+ *
+ * Un archivo está modificado si su tamaño o su fecha no coinciden con los
+ * del catálogo (el mismo criterio que LibraryWatcher). Las comprobaciones
+ * se hacen en paralelo, lo que ayuda mucho en unidades de red; los cambios
+ * en el catálogo (--fix, --remove-missing) se escriben en una transacción.
+ *
+ * @return 0 si no quedan problemas sin corregir
+ */
+int CliCommands::verifyFiles(const QStringList& arguments)
+{
+    enum FileStatus { FileOk, FileModified, FileMissing };
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Comprueba que los archivos del catálogo existen y no han cambiado.");
+    parser.addHelpOption();
+    QCommandLineOption albumOption("album", "Solo las imágenes de este álbum.", "id");
+    QCommandLineOption fixOption("fix", "Actualiza los metadatos de los archivos modificados.");
+    QCommandLineOption removeOption("remove-missing", "Elimina del catálogo los archivos que ya no existen.");
+    parser.addOptions({ albumOption, fixOption, removeOption });
+    parser.process(arguments);
+
+    const int albumId = albumArgument(parser, albumOption);
+    if (albumId == 0) {
+        return 1;
+    }
+
+    DatabaseManager& db = DatabaseManager::instance();
+    const QVector<CatalogFile> files = catalogFiles(db, albumId);
+
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<int> future = QtConcurrent::mapped(files, [] (const CatalogFile& file) -> int {
+        QFileInfo info(file.path);
+        if (!info.exists()) {
+            return FileMissing;
+        }
+        if (info.size() != file.byteSize
+            || info.lastModified().toSecsSinceEpoch() != file.modifiedAt) {
+            return FileModified;
+        }
+        return FileOk;
+    });
+    waitWithProgress(future);
+    const QList<int> statuses = future.results();
+
+    QTextStream out(stdout);
+    int modified = 0;
+    int missing = 0;
+    int remaining = 0;
+    QSqlDatabase database = QSqlDatabase::database();
+    database.transaction();
+    for (int i = 0; i < files.count(); ++i) {
+        const CatalogFile& file = files[i];
+        if (statuses[i] == FileModified) {
+            ++modified;
+            out << "modificado: " << file.path << "\n";
+            if (!parser.isSet(fixOption)
+                || !db.pictureDao.updateFileMetadata(file.directoryId, file.name,
+                                                     MetadataExtractor::extract(file.path))) {
+                ++remaining;
+            }
+        } else if (statuses[i] == FileMissing) {
+            ++missing;
+            out << "no existe: " << file.path << "\n";
+            if (!parser.isSet(removeOption)
+                || !db.pictureDao.removeFile(file.directoryId, file.name)) {
+                ++remaining;
+            }
+        }
+    }
+    database.commit();
+
+    printThroughput("verify", files.count(), "archivos", timer.elapsed());
+    out << files.count() - modified - missing << " correctos, " << modified << " modificados, "
+        << missing << " no existen, " << remaining << " sin corregir\n";
+    return remaining > 0 ? 1 : 0;
+}
+
+/**
+ * gallerycli vacuum: mantenimiento del archivo del catálogo
+ *
+ * Fusiona los segmentos del índice de búsqueda, reescribe la base de datos
+ * sin páginas libres (VACUUM), vacía el WAL y actualiza las estadísticas
+ * que usa el planificador de consultas. Puede ejecutarse con gallerydesktop
+ * abierto: espera a que terminen sus escrituras (busy_timeout).
+ */
+int CliCommands::vacuumCatalog(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compacta el catálogo y optimiza sus índices.");
+    parser.addHelpOption();
+    parser.process(arguments);
+
+    DatabaseManager& db = DatabaseManager::instance();
+    QSqlDatabase database = QSqlDatabase::database();
+    const QString path = database.databaseName();
+    auto catalogSize = [&path] {
+        return QFileInfo(path).size() + QFileInfo(path + "-wal").size();
+    };
+
+    const qint64 sizeBefore = catalogSize();
+    QElapsedTimer timer;
+    timer.start();
+
+    db.searchDao.optimize();
+    QSqlQuery query(database);
+    if (!query.exec("VACUUM")) {
+        QTextStream(stderr) << "Error al compactar el catálogo: " << query.lastError().text() << "\n";
+        return 1;
+    }
+    query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    query.exec("PRAGMA optimize");
+
+    const qint64 sizeAfter = catalogSize();
+    const double seconds = qMax<qint64>(timer.elapsed(), 1) / 1000.0;
+    const double megabyte = 1024 * 1024;
+    QTextStream(stdout) << "vacuum: " << QString::number(sizeBefore / megabyte, 'f', 1) << " MB -> "
+                        << QString::number(sizeAfter / megabyte, 'f', 1) << " MB en "
+                        << QString::number(seconds, 'f', 1) << " s ("
+                        << QString::number(sizeBefore / megabyte / seconds, 'f', 1) << " MB/s)\n";
+    return 0;
+}
+
+/**
+ * Escapa un campo CSV (RFC 4180)
+ */
+static QString csvField(const QString& value)
+{
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"'))
+        && !value.contains(QLatin1Char('\n')) && !value.contains(QLatin1Char('\r'))) {
+        return value;
+    }
+    QString escaped = value;
+    escaped.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+/**
+ * gallerycli export <archivo>: exporta el catálogo a CSV o JSON
+ *
+ * Una fila por imagen y álbum (un archivo copiado a dos álbumes aparece dos
+ * veces). Se escribe con QSaveFile: un export interrumpido no deja un
+ * archivo a medias.
+ */
+int CliCommands::exportCatalog(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Exporta los álbumes y sus archivos a CSV o JSON.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "Archivo de destino.");
+    QCommandLineOption albumOption("album", "Solo las imágenes de este álbum.", "id");
+    QCommandLineOption formatOption("format", "csv o json (por defecto, según la extensión).", "format");
+    parser.addOptions({ albumOption, formatOption });
+    parser.process(arguments);
+
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+
+    QTextStream err(stderr);
+    const QString filePath = parser.positionalArguments().first();
+    const QString format = parser.isSet(formatOption)
+        ? parser.value(formatOption)
+        : (QFileInfo(filePath).suffix().compare("json", Qt::CaseInsensitive) == 0 ? "json" : "csv");
+    if (format != "csv" && format != "json") {
+        err << "Formato desconocido: " << format << "\n";
+        return 1;
+    }
+
+    const int albumId = albumArgument(parser, albumOption);
+    if (albumId == 0) {
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    DatabaseManager& db = DatabaseManager::instance();
+    QHash<int, QString> albumNames;
+    for (const Album& album : db.albumDao.albums()) {
+        albumNames.insert(album.id(), album.name());
+    }
+    const QVector<CatalogFile> files = catalogFiles(db, albumId);
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        err << "No se puede escribir " << filePath << "\n";
+        return 1;
+    }
+
+    QTextStream stream(&file);
+    const bool json = format == "json";
+    stream << (json ? "[\n" : "album_id,album,path,byte_size,modified_at\n");
+
+    int rows = 0;
+    for (const CatalogFile& catalogFile : files) {
+        const QString modifiedAt = QDateTime::fromSecsSinceEpoch(catalogFile.modifiedAt)
+                                       .toUTC().toString(Qt::ISODate);
+        for (int fileAlbumId : catalogFile.albumIds) {
+            if (albumId > 0 && fileAlbumId != albumId) {
+                continue;
+            }
+            if (json) {
+                QJsonObject row;
+                row.insert("albumId", fileAlbumId);
+                row.insert("album", albumNames.value(fileAlbumId));
+                row.insert("path", catalogFile.path);
+                row.insert("byteSize", catalogFile.byteSize);
+                row.insert("modifiedAt", modifiedAt);
+                stream << (rows ? ",\n" : "")
+                       << QString::fromUtf8(QJsonDocument(row).toJson(QJsonDocument::Compact));
+            } else {
+                stream << fileAlbumId << ',' << csvField(albumNames.value(fileAlbumId)) << ','
+                       << csvField(catalogFile.path) << ',' << catalogFile.byteSize << ','
+                       << modifiedAt << '\n';
+            }
+            ++rows;
+        }
+    }
+    if (json) {
+        stream << "\n]\n";
+    }
+    stream.flush();
+
+    if (!file.commit()) {
+        err << "No se puede escribir " << filePath << "\n";
+        return 1;
+    }
+
+    printThroughput("export", rows, "filas", timer.elapsed());
+    return 0;
+}
+
+/**
+ * gallerycli relocate <carpeta> <nueva-ruta>
+ *
+ * Cambia la ruta de una carpeta del catálogo y de sus subcarpetas, por
+ * ejemplo al mover una colección a otro disco o cambiar su punto de
+ * montaje. Es una sola sentencia sobre la tabla de carpetas (y una fila del
+ * índice de búsqueda por carpeta): las imágenes conservan sus IDs, álbumes y
+ * metadatos, y no se vuelve a leer ningún archivo.
+ */
+int CliCommands::relocateFolder(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Cambia la ruta de una carpeta del catálogo y de sus subcarpetas.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("folder", "Ruta actual en el catálogo (no hace falta que exista).");
+    parser.addPositionalArgument("new-path", "Nueva ruta de la carpeta.");
+    parser.process(arguments);
+
+    if (parser.positionalArguments().count() != 2) {
+        parser.showHelp(1);
+    }
+
+    // Mismo formato que las rutas guardadas: absolutas y con '/'
+    const QString oldPath = QDir::cleanPath(QFileInfo(parser.positionalArguments().at(0)).absoluteFilePath());
+    const QString newPath = QDir::cleanPath(QFileInfo(parser.positionalArguments().at(1)).absoluteFilePath());
+    QTextStream err(stderr);
+    if (!QFileInfo(newPath).isDir()) {
+        err << "No existe la carpeta " << newPath << "\n";
+        return 1;
+    }
+
+    DatabaseManager& db = DatabaseManager::instance();
+    QSqlDatabase database = QSqlDatabase::database(db.connectionName());
+    QElapsedTimer timer;
+    timer.start();
+
+    database.transaction();
+    const int relocated = db.directoryDao.relocateDirectory(oldPath, newPath);
+    if (relocated < 0 || !database.commit()) {
+        database.rollback();
+        db.directoryDao.clearCache();
+        err << "Error al reubicar " << oldPath << "\n";
+        return 1;
+    }
+
+    // Las demás conexiones solo ven las rutas nuevas una vez confirmadas
+    DirectoryDao::invalidateAllCaches();
+    if (relocated == 0) {
+        err << "El catálogo no tiene ninguna carpeta en " << oldPath << "\n";
+        return 1;
+    }
+    emit db.notifier.directoriesRelocated(oldPath, newPath);
+
+    printThroughput("relocate", relocated, "carpetas", timer.elapsed());
+    return 0;
+}
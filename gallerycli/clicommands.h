@@ -0,0 +1,31 @@
+#ifndef CLICOMMANDS_H
+#define CLICOMMANDS_H
+
+#include <QStringList>
+
+/**
+ * Subcomandos de gallerycli
+ *
+ * Cada uno recibe los argumentos de la línea de comandos sin el nombre del
+ * subcomando (el primero sigue siendo el ejecutable), los interpreta con su
+ * propio QCommandLineParser y devuelve el código de salida del proceso.
+ *
+ * Todos trabajan sobre el catálogo de DatabaseManager y terminan mostrando
+ * su rendimiento (elementos por segundo), para poder planificar tareas
+ * nocturnas y comparar máquinas.
+ */
+class CliCommands
+{
+public:
+    static int importFolder(const QStringList& arguments);
+    static int prewarmThumbnails(const QStringList& arguments);
+    static int verifyFiles(const QStringList& arguments);
+    static int vacuumCatalog(const QStringList& arguments);
+    static int exportCatalog(const QStringList& arguments);
+    static int relocateFolder(const QStringList& arguments);
+
+private:
+    CliCommands() = delete;
+};
+
+#endif // CLICOMMANDS_H
@@ -0,0 +1,21 @@
+QT       += core gui sql concurrent
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = gallerycli
+
+SOURCES += \
+    clicommands.cpp \
+    main.cpp
+
+HEADERS += \
+    clicommands.h
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/release/ -lgallerycore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/debug/ -lgallerycore
+else:unix: LIBS += -L$$OUT_PWD/../gallerycore/ -lgallerycore
+
+INCLUDEPATH += $$PWD/../gallerycore
+DEPENDPATH += $$PWD/../gallerycore
@@ -0,0 +1,83 @@
+#include <QCoreApplication>
+#include <QTextStream>
+#include "clicommands.h"
+#include "DatabaseManager.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "Trace.h"
+
+/**
+ * Subcomando de gallerycli
+ */
+struct Command
+{
+    const char* name;
+    int (*run)(const QStringList& arguments);
+    const char* description;
+};
+
+static const Command COMMANDS[] = {
+    { "import", &CliCommands::importFolder, "Importa una carpeta en el catálogo" },
+    { "prewarm", &CliCommands::prewarmThumbnails, "Genera los thumbnails y hashes perceptuales que faltan" },
+    { "verify", &CliCommands::verifyFiles, "Comprueba que los archivos del catálogo siguen en disco" },
+    { "vacuum", &CliCommands::vacuumCatalog, "Compacta el catálogo y optimiza sus índices" },
+    { "export", &CliCommands::exportCatalog, "Exporta el catálogo a CSV o JSON" },
+    { "relocate", &CliCommands::relocateFolder, "Cambia la ruta de una carpeta movida (unidad o montaje)" },
+};
+
+/**
+ * Muestra los subcomandos disponibles
+ */
+static void printUsage()
+{
+    QTextStream err(stderr);
+    err << "Uso: gallerycli [--catalog <archivo>] <subcomando> [opciones]\n\nSubcomandos:\n";
+    for (const Command& command : COMMANDS) {
+        err << "  " << QString(command.name).leftJustified(10) << command.description << "\n";
+    }
+    err << "\n'gallerycli <subcomando> --help' muestra las opciones de cada subcomando.\n";
+}
+
+/**
+ * Punto de entrada de gallerycli, la versión sin interfaz de la galería
+ *
+ * Permite programar las operaciones pesadas (importar, generar thumbnails,
+ * verificar y mantener el catálogo) en servidores o por la noche. Trabaja
+ * sobre el mismo catálogo que gallerydesktop (ver DatabaseManager::catalogPath();
+ * --catalog, antes del subcomando, lo cambia) y la misma caché de thumbnails.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // La caché de thumbnails está en la carpeta de caché de la aplicación,
+    // que depende de su nombre: se usa el de gallerydesktop para compartirla
+    QCoreApplication::setApplicationName("gallerydesktop");
+
+    // Traza de rendimiento (GALLERY_TRACE=archivo.json): se escribe al salir
+    Trace::startFromEnvironment();
+
+    // Métricas (GALLERY_METRICS=archivo.json): se escriben al salir
+    Metrics::instance().startFromEnvironment();
+
+    // Consultas SQL lentas y estadísticas por sentencia (ver QueryProfiler)
+    QueryProfiler::startFromEnvironment();
+
+    QStringList arguments = app.arguments();
+    if (arguments.value(1) == "--catalog" && arguments.size() > 2) {
+        DatabaseManager::setCatalogPath(arguments.at(2));
+        arguments.remove(1, 2);
+    }
+
+    const QString name = arguments.value(1);
+    for (const Command& command : COMMANDS) {
+        if (name == command.name) {
+            // Cada subcomando ve sus opciones como si fuera el programa
+            arguments.removeAt(1);
+            return command.run(arguments);
+        }
+    }
+
+    printUsage();
+    return name == "--help" || name == "-h" ? 0 : 1;
+}
@@ -1,31 +1,108 @@
 #include "AlbumModel.h"
 #include "DatabaseManager.h"
 #include "Album.h"
+#include "Picturemodel.h"
+#include "Trace.h"
+#include <QDataStream>
 #include <QDebug>
+#include <QMimeData>
+#include <utility>
+
+/**
+ * Constructor de AlbumModel sobre el catálogo de la aplicación
+ * @param parent Objeto padre para la jerarquía de Qt (gestión automática de memoria)
+ */
+AlbumModel::AlbumModel(QObject* parent) :
+    AlbumModel(DatabaseManager::instance(), parent)  // Usa la instancia singleton del DatabaseManager
+{
+}
 
 /**
  * Constructor de AlbumModel
+ * @param database Catálogo del modelo (debe vivir más que el modelo)
  * @param parent Objeto padre para la jerarquía de Qt (gestión automática de memoria)
  * Inicializa el modelo de álbumes heredando de QAbstractListModel y carga
  * todos los álbumes existentes desde la base de datos
  */
-AlbumModel::AlbumModel(QObject* parent) :
+AlbumModel::AlbumModel(DatabaseManager& database, QObject* parent) :
     QAbstractListModel(parent),  // Llama al constructor de la clase base
-    mDb(DatabaseManager::instance())  // Obtiene la instancia singleton del DatabaseManager
+    mDb(database)
 {
     // Cargar los álbumes desde el DAO (Data Access Object)
-    auto albumsFromDao = mDb.albumDao.albums(); // Retorna QVector<Album*>
-    mAlbums = albumsFromDao; // Copia directa de los punteros al vector del modelo
+    // El vector se mueve al modelo sin copiar los álbumes
+    mAlbums = mDb.albumDao.albums();
+    reindexFrom(0);
+
+    // Álbumes creados fuera del modelo (importación de carpetas)
+    connect(&mDb.notifier, &CatalogNotifier::albumAdded,
+            this, &AlbumModel::onAlbumAdded);
+
+    // Álbumes renombrados desde otro modelo del mismo catálogo
+    connect(&mDb.notifier, &CatalogNotifier::albumRenamed,
+            this, &AlbumModel::onAlbumRenamed);
+}
+
+/**
+ * Constructor de AlbumModel a partir de una lista de álbumes ya conocida
+ * @param database Catálogo del modelo (debe vivir más que el modelo)
+ * @param albums Álbumes a mostrar (por ejemplo, de la instantánea de arranque)
+ * @param parent Objeto padre para la jerarquía de Qt
+ *
+ * No consulta la base de datos; si la lista puede estar desactualizada,
+ * reload() la sustituye después por la del catálogo.
+ */
+AlbumModel::AlbumModel(DatabaseManager& database, const QVector<Album>& albums, QObject* parent) :
+    QAbstractListModel(parent),
+    mDb(database),
+    mAlbums(albums)
+{
+    reindexFrom(0);
+
+    connect(&mDb.notifier, &CatalogNotifier::albumAdded,
+            this, &AlbumModel::onAlbumAdded);
+    connect(&mDb.notifier, &CatalogNotifier::albumRenamed,
+            this, &AlbumModel::onAlbumRenamed);
+}
+
+/**
+ * Retorna el catálogo del modelo; los modelos que dependen de este
+ * (PictureModel) trabajan sobre el mismo
+ */
+DatabaseManager& AlbumModel::database() const
+{
+    return mDb;
+}
+
+/**
+ * Retorna los álbumes del modelo, en el orden de sus filas
+ */
+const QVector<Album>& AlbumModel::albums() const
+{
+    return mAlbums;
+}
+
+/**
+ * Vuelve a cargar todos los álbumes desde la base de datos
+ *
+ * Reinicia el modelo sin emitir rowsRemoved, así que las imágenes de los
+ * álbumes no se tocan; la selección de las vistas se pierde.
+ */
+void AlbumModel::reload()
+{
+    beginResetModel();
+    mAlbums = mDb.albumDao.albums();
+    mRowForAlbumId.clear();
+    reindexFrom(0);
+    endResetModel();
 }
 
 /**
  * Destructor de AlbumModel
- * Nota: Actualmente vacío, pero necesario para evitar errores del compilador
- * La liberación de memoria de los álbumes se realiza en removeRows()
+ * Los álbumes se guardan por valor, así que el vector los destruye
+ * automáticamente; no hay memoria que liberar a mano
  */
 AlbumModel::~AlbumModel()
 {
-    // Destructor vacío para evitar el error del compilador
 }
 
 /**
@@ -57,7 +134,7 @@ QVariant AlbumModel::data(const QModelIndex& index, int role) const
     }
 
     // Obtiene una referencia constante al álbum en la posición especificada
-    const Album& album = *mAlbums.at(index.row());
+    const Album& album = mAlbums.at(index.row());
 
     // Retorna el dato correspondiente según el rol solicitado
     switch (role) {
@@ -84,6 +161,40 @@ int AlbumModel::rowCount(const QModelIndex& parent) const
     return mAlbums.size();  // Retorna el tamaño del vector de álbumes
 }
 
+/**
+ * Busca la fila de un álbum por su ID
+ * @param albumId ID del álbum en la base de datos
+ * @return Fila del álbum, o -1 si no existe
+ * Usa el índice id -> fila, sin recorrer el vector
+ */
+int AlbumModel::rowForAlbumId(int albumId) const
+{
+    return mRowForAlbumId.value(albumId, -1);
+}
+
+/**
+ * Busca el índice del modelo de un álbum por su ID
+ * @param albumId ID del álbum en la base de datos
+ * @return QModelIndex del álbum, o índice inválido si no existe
+ */
+QModelIndex AlbumModel::indexForAlbumId(int albumId) const
+{
+    int row = rowForAlbumId(albumId);
+    return row < 0 ? QModelIndex() : index(row, 0);
+}
+
+/**
+ * Actualiza el índice id -> fila a partir de una fila
+ * @param row Primera fila cuya posición ha cambiado
+ * Las filas anteriores no cambian, así que solo se recorren las siguientes
+ */
+void AlbumModel::reindexFrom(int row)
+{
+    for (int i = row; i < mAlbums.size(); ++i) {
+        mRowForAlbumId.insert(mAlbums.at(i).id(), i);
+    }
+}
+
 /**
  * Valida si un índice del modelo es válido
  * @param index Índice a validar
@@ -110,14 +221,15 @@ QModelIndex AlbumModel::addAlbum(const Album& album)
     // Notifica a las vistas que se van a insertar filas
     beginInsertRows(QModelIndex(), rowIndex, rowIndex);
 
-    // Crear un nuevo Album dinámicamente en el heap (copia del álbum recibido)
-    Album* newAlbum = new Album(album);
+    // Copia del álbum recibido, que se guardará por valor en el modelo
+    Album newAlbum(album);
 
     // Añade el álbum a la base de datos y actualiza su ID
-    mDb.albumDao.addAlbum(*newAlbum);
+    mDb.albumDao.addAlbum(newAlbum);
 
-    // Añadir el puntero al QVector del modelo
-    mAlbums.push_back(newAlbum);
+    // Registra la fila en el índice y mueve el álbum al QVector del modelo
+    mRowForAlbumId.insert(newAlbum.id(), rowIndex);
+    mAlbums.push_back(std::move(newAlbum));
 
     // Notifica a las vistas que la inserción ha terminado
     endInsertRows();
@@ -125,6 +237,54 @@ QModelIndex AlbumModel::addAlbum(const Album& album)
     return index(rowIndex, 0);  // Retorna el índice del nuevo álbum
 }
 
+/**
+ * Añade al modelo un álbum que ya existe en la base de datos
+ * @param albumId ID del álbum creado fuera del modelo
+ * Lee solo ese álbum en lugar de recargar la lista completa
+ */
+void AlbumModel::onAlbumAdded(int albumId)
+{
+    if (mRowForAlbumId.contains(albumId)) {
+        return;
+    }
+
+    Album album = mDb.albumDao.album(albumId);
+    if (album.id() < 0) {
+        return;
+    }
+
+    int rowIndex = rowCount();
+    beginInsertRows(QModelIndex(), rowIndex, rowIndex);
+    mRowForAlbumId.insert(albumId, rowIndex);
+    mAlbums.push_back(std::move(album));
+    endInsertRows();
+}
+
+/**
+ * Actualiza el nombre de un álbum renombrado fuera del modelo
+ * @param albumId ID del álbum renombrado
+ *
+ * Lee solo ese álbum. Las vistas reciben dataChanged con el rol del nombre,
+ * así que AlbumWidget actualiza el título si es el álbum abierto. El propio
+ * modelo que lo ha renombrado ya tiene el nombre nuevo y no emite nada.
+ */
+void AlbumModel::onAlbumRenamed(int albumId)
+{
+    int row = rowForAlbumId(albumId);
+    if (row < 0) {
+        return;
+    }
+
+    Album album = mDb.albumDao.album(albumId);
+    if (album.id() < 0 || album.name() == mAlbums.at(row).name()) {
+        return;
+    }
+
+    mAlbums[row].setName(album.name());
+    QModelIndex changed = index(row, 0);
+    emit dataChanged(changed, changed, { Roles::NameRole, Qt::DisplayRole });
+}
+
 /**
  * Modifica los datos de un álbum existente en el modelo
  * @param index Índice del álbum a modificar
@@ -132,6 +292,7 @@ QModelIndex AlbumModel::addAlbum(const Album& album)
  * @param role Rol que especifica qué dato modificar
  * @return true si la modificación fue exitosa, false en caso contrario
  * Actualiza tanto el modelo como la base de datos y notifica a las vistas del cambio
+ * indicando los roles afectados, para que solo se actualice el nombre mostrado
  */
 bool AlbumModel::setData(const QModelIndex& index, const QVariant& value, int role)
 {
@@ -141,7 +302,7 @@ bool AlbumModel::setData(const QModelIndex& index, const QVariant& value, int ro
     }
 
     // Obtiene una referencia al álbum a modificar
-    Album& album = *mAlbums.at(index.row());
+    Album& album = mAlbums[index.row()];
 
     // Establece el nuevo nombre del álbum
     album.setName(value.toString());
@@ -149,8 +310,9 @@ bool AlbumModel::setData(const QModelIndex& index, const QVariant& value, int ro
     // Actualiza el álbum en la base de datos
     mDb.albumDao.updateAlbum(album);
 
-    // Notifica a las vistas que los datos han cambiado
-    emit dataChanged(index, index);
+    // Notifica a las vistas que solo ha cambiado el nombre
+    emit dataChanged(index, index, { Roles::NameRole, Qt::DisplayRole });
+    emit mDb.notifier.albumRenamed(album.id());
 
     return true;  // Modificación exitosa
 }
@@ -161,7 +323,7 @@ bool AlbumModel::setData(const QModelIndex& index, const QVariant& value, int ro
  * @param count Número de filas a eliminar
  * @param parent Índice padre (no usado en modelos de lista)
  * @return true si la eliminación fue exitosa, false en caso contrario
- * Libera la memoria de los álbumes eliminados y actualiza la base de datos
+ * Elimina los álbumes de la base de datos y actualiza el índice id -> fila
  */
 bool AlbumModel::removeRows(int row, int count, const QModelIndex& parent)
 {
@@ -173,24 +335,117 @@ bool AlbumModel::removeRows(int row, int count, const QModelIndex& parent)
     // Notifica a las vistas que se van a eliminar filas
     beginRemoveRows(parent, row, row + count - 1);
 
-    // Eliminar álbumes de la base de datos y liberar memoria
+    // Eliminar álbumes de la base de datos y del índice
     for (int i = 0; i < count; ++i) {
-        // Obtiene el puntero al álbum a eliminar
-        Album* album = mAlbums.at(row + i);
+        int albumId = mAlbums.at(row + i).id();
 
         // Elimina el álbum de la base de datos usando su ID
-        mDb.albumDao.removeAlbum(album->id());
-
-        // Libera la memoria del objeto Album
-        delete album;
+        mDb.albumDao.removeAlbum(albumId);
+        mRowForAlbumId.remove(albumId);
+        emit mDb.notifier.albumRemoved(albumId);
     }
 
-    // Quitar los punteros del QVector
+    // Quitar los álbumes del QVector (se destruyen automáticamente)
     // Usa erase() con iteradores para eliminar un rango de elementos
     mAlbums.erase(mAlbums.begin() + row, mAlbums.begin() + row + count);
 
+    // Las filas siguientes se han desplazado
+    reindexFrom(row);
+
     // Notifica a las vistas que la eliminación ha terminado
     endRemoveRows();
 
     return true;  // Eliminación exitosa
 }
+
+/**
+ * Retorna las propiedades de un elemento del modelo
+ * @param index Índice del elemento
+ * @return Flags por defecto más ItemIsDropEnabled para los álbumes
+ *
+ * Se pueden soltar imágenes sobre un álbum para moverlas o copiarlas a él.
+ */
+Qt::ItemFlags AlbumModel::flags(const QModelIndex& index) const
+{
+    Qt::ItemFlags defaultFlags = QAbstractListModel::flags(index);
+    return isIndexValid(index) ? defaultFlags | Qt::ItemIsDropEnabled : defaultFlags;
+}
+
+/**
+ * Retorna los tipos MIME que acepta el modelo (IDs de imágenes)
+ */
+QStringList AlbumModel::mimeTypes() const
+{
+    return { PICTURE_IDS_MIME_TYPE };
+}
+
+/**
+ * Acciones aceptadas al soltar imágenes: mover (por defecto) o copiar
+ */
+Qt::DropActions AlbumModel::supportedDropActions() const
+{
+    return Qt::MoveAction | Qt::CopyAction;
+}
+
+/**
+ * Indica si se pueden soltar los datos arrastrados en una posición
+ * Solo se aceptan imágenes soltadas directamente sobre un álbum.
+ */
+bool AlbumModel::canDropMimeData(const QMimeData* data, Qt::DropAction action,
+                                 int row, int column, const QModelIndex& parent) const
+{
+    Q_UNUSED(row)
+    Q_UNUSED(column)
+    return data && data->hasFormat(PICTURE_IDS_MIME_TYPE)
+        && (action == Qt::MoveAction || action == Qt::CopyAction)
+        && isIndexValid(parent);
+}
+
+/**
+ * Mueve o copia las imágenes soltadas sobre un álbum
+ * @param data Datos arrastrados (generados por PictureModel::mimeData)
+ * @param action MoveAction o CopyAction
+ * @param row Fila entre elementos (no se usa: se suelta sobre un álbum)
+ * @param column Columna (no se usa)
+ * @param parent Álbum de destino
+ * @return true si la operación se ha realizado
+ *
+ * Toda la operación es una única transacción en bloque (PictureDao) y, al
+ * terminar, se emite una única notificación con todos los álbumes afectados
+ * para que los modelos de imágenes se actualicen con un único reset.
+ */
+bool AlbumModel::dropMimeData(const QMimeData* data, Qt::DropAction action,
+                              int row, int column, const QModelIndex& parent)
+{
+    if (!canDropMimeData(data, action, row, column, parent)) {
+        return false;
+    }
+
+    QVector<int> pictureIds;
+    QList<int> sourceAlbumIds;
+    QDataStream stream(data->data(PICTURE_IDS_MIME_TYPE));
+    stream >> pictureIds >> sourceAlbumIds;
+    if (pictureIds.isEmpty()) {
+        return false;
+    }
+
+    int targetAlbumId = mAlbums.at(parent.row()).id();
+    int affected = action == Qt::MoveAction
+        ? mDb.pictureDao.movePictures(pictureIds, targetAlbumId)
+        : mDb.pictureDao.copyPictures(pictureIds, targetAlbumId);
+    if (affected < 0) {
+        return false;
+    }
+
+    qCDebug(lcModel) << "Imágenes" << (action == Qt::MoveAction ? "movidas:" : "copiadas:")
+                     << affected << "al álbum" << targetAlbumId;
+
+    // Notifica en una sola señal el álbum de destino y, si se han movido,
+    // los de origen
+    if (action == Qt::CopyAction) {
+        sourceAlbumIds.clear();
+    }
+    sourceAlbumIds.removeAll(targetAlbumId);
+    emit mDb.notifier.picturesMoved(targetAlbumId, sourceAlbumIds);
+    return true;
+}
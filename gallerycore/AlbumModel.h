@@ -14,20 +14,44 @@ public:
     };
 
     AlbumModel(QObject* parent = 0);
+    explicit AlbumModel(DatabaseManager& database, QObject* parent = 0);
+    AlbumModel(DatabaseManager& database, const QVector<Album>& albums, QObject* parent = 0);
     ~AlbumModel();
 
+    DatabaseManager& database() const;
+    const QVector<Album>& albums() const;
+    void reload();
+
     QModelIndex addAlbum(const Album& album);
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int rowForAlbumId(int albumId) const;
+    QModelIndex indexForAlbumId(int albumId) const;
     bool setData(const QModelIndex& index, const QVariant& value, int role) override;
     bool removeRows(int row, int count, const QModelIndex& parent)  override;
 
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QStringList mimeTypes() const override;
+    Qt::DropActions supportedDropActions() const override;
+    bool canDropMimeData(const QMimeData* data, Qt::DropAction action,
+                         int row, int column, const QModelIndex& parent) const override;
+    bool dropMimeData(const QMimeData* data, Qt::DropAction action,
+                      int row, int column, const QModelIndex& parent) override;
+
+private slots:
+    void onAlbumAdded(int albumId);
+    void onAlbumRenamed(int albumId);
+
 private:
     bool isIndexValid(const QModelIndex& index) const;
+    void reindexFrom(int row);
 
 private:
     DatabaseManager& mDb;
-    QVector<Album*> mAlbums;
+    QVector<Album> mAlbums;
+
+    // Índice id de álbum -> fila, para búsquedas O(1)
+    QHash<int, int> mRowForAlbumId;
 };
@@ -3,7 +3,10 @@
 #include "DatabaseManager.h"
 #include <QVariant>
 #include "Album.h"
-#include <memory>
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "Trace.h"
+#include <utility>
 
 /**
  * Constructor de AlbumDao
@@ -11,7 +14,8 @@
  * Inicializa el objeto AlbumDao con una referencia a la base de datos
  */
 AlbumDao::AlbumDao(QSqlDatabase& database) :
-    mDatabase(database)
+    mDatabase(database),
+    mStatements(database)
 {
 }
 
@@ -27,7 +31,7 @@ void AlbumDao::init() const
     // Verifica si la tabla "albums" ya existe en la base de datos
     if (!mDatabase.tables().contains("albums")) {
         // Crea un objeto query para ejecutar comandos SQL
-        QSqlQuery query(mDatabase);
+        ProfiledQuery query(mDatabase);
         // Ejecuta la consulta SQL para crear la tabla albums
         query.exec("CREATE TABLE albums (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT)");
     }
@@ -35,33 +39,51 @@ void AlbumDao::init() const
 
 /**
  * Obtiene todos los álbumes de la base de datos
- * @return QVector con punteros a objetos Album que contienen todos los álbumes almacenados
- * Nota: El llamador es responsable de liberar la memoria de los punteros devueltos
+ * @return QVector con los álbumes almacenados, por valor y en memoria contigua
+ * El vector se devuelve por movimiento; no hay punteros que liberar
  */
-QVector<Album*> AlbumDao::albums() const
+QVector<Album> AlbumDao::albums() const
 {
+    GALLERY_TRACE_SCOPE(lcDatabase, "AlbumDao::albums");
+    GALLERY_METRIC_TIMER("db.albums.us");
+
     // Prepara y ejecuta una consulta para obtener todos los álbumes
-    QSqlQuery query("SELECT * FROM albums", mDatabase);
+    ProfiledQuery query("SELECT id, name FROM albums", mDatabase);
     query.exec();
 
-    // Vector que almacenará los punteros a los álbumes recuperados
-    QVector<Album*> list;
+    // Vector que almacenará los álbumes recuperados
+    QVector<Album> list;
 
     // Itera sobre cada fila del resultado de la consulta
     while (query.next()) {
-        // Crea un nuevo objeto Album en el heap
-        Album* album = new Album();
-        // Establece el ID del álbum desde la columna "id" de la consulta
-        album->setID(query.value("id").toInt());
-        // Establece el nombre del álbum desde la columna "name" de la consulta
-        album->setName(query.value("name").toString());
-        // Añade el puntero al álbum en el vector
-        list.push_back(album);
+        Album album(query.value(1).toString());  // Columna "name"
+        album.setID(query.value(0).toInt());     // Columna "id"
+        // Mueve el álbum al vector (sin copiar el nombre)
+        list.push_back(std::move(album));
     }
 
     return list;
 }
 
+/**
+ * Obtiene un álbum por su ID
+ * @param id ID del álbum
+ * @return El álbum, o un álbum con ID -1 si no existe
+ */
+Album AlbumDao::album(int id) const
+{
+    CachedQuery query = mStatements.prepared("SELECT name FROM albums WHERE id = :id");
+    query->bindValue(":id", id);
+    query->exec();
+
+    Album album;
+    if (query->next()) {
+        album.setName(query->value(0).toString());
+        album.setID(id);
+    }
+    return album;
+}
+
 /**
  * Añade un nuevo álbum a la base de datos
  * @param album Referencia al objeto Album que se desea añadir
@@ -69,16 +91,14 @@ QVector<Album*> AlbumDao::albums() const
  */
 void AlbumDao::addAlbum(Album& album) const
 {
-    // Crea un objeto query para la base de datos
-    QSqlQuery query(mDatabase);
     // Prepara la consulta SQL con un parámetro nombrado para evitar inyección SQL
-    query.prepare("INSERT INTO albums (name) VALUES (:name)");
+    CachedQuery query = mStatements.prepared("INSERT INTO albums (name) VALUES (:name)");
     // Vincula el valor del nombre del álbum al parámetro :name
-    query.bindValue(":name", album.name());
+    query->bindValue(":name", album.name());
     // Ejecuta la consulta INSERT
-    query.exec();
+    query->exec();
     // Actualiza el ID del álbum con el ID generado automáticamente por la base de datos
-    album.setID(query.lastInsertId().toInt());
+    album.setID(query->lastInsertId().toInt());
 }
 
 /**
@@ -88,16 +108,14 @@ void AlbumDao::addAlbum(Album& album) const
  */
 void AlbumDao::updateAlbum(const Album& album) const
 {
-    // Crea un objeto query para la base de datos
-    QSqlQuery query(mDatabase);
     // Prepara la consulta SQL UPDATE con parámetros nombrados
-    query.prepare("UPDATE albums SET name = :name WHERE id = :id");
+    CachedQuery query = mStatements.prepared("UPDATE albums SET name = :name WHERE id = :id");
     // Vincula el nuevo nombre del álbum al parámetro :name
-    query.bindValue(":name", album.name());
+    query->bindValue(":name", album.name());
     // Vincula el ID del álbum al parámetro :id para identificar qué álbum actualizar
-    query.bindValue(":id", album.id());
+    query->bindValue(":id", album.id());
     // Ejecuta la consulta UPDATE
-    query.exec();
+    query->exec();
 }
 
 /**
@@ -107,32 +125,30 @@ void AlbumDao::updateAlbum(const Album& album) const
  */
 void AlbumDao::removeAlbum(int albumId) const
 {
-    // Crea un objeto query para la base de datos
-    QSqlQuery query(mDatabase);
     // Prepara la consulta SQL DELETE con parámetro nombrado
-    query.prepare("DELETE FROM albums WHERE id = :id");
+    CachedQuery query = mStatements.prepared("DELETE FROM albums WHERE id = :id");
     // Vincula el ID del álbum a eliminar al parámetro :id
-    query.bindValue(":id", albumId);
+    query->bindValue(":id", albumId);
     // Ejecuta la consulta DELETE
-    query.exec();
+    query->exec();
 }
 
 /*
  * NOTAS SOBRE EVOLUCIÓN DEL CÓDIGO Y BUENAS PRÁCTICAS:
  *
  * Cambio de implementación:
- * - Antes: QVector<std::unique_ptr<Album>>
- * - Ahora: std::vector<std::unique_ptr<Album>>
+ * - Antes: QVector<Album*> (el modelo nunca liberaba los álbumes)
+ * - Ahora: QVector<Album> por valor
  *
  * Razón del cambio:
  * list.push_back(std::move(album));
- * Esto evita el error "use of deleted function" porque std::unique_ptr no se puede copiar,
- * solo mover. Al usar std::move(), transferimos la propiedad del objeto de forma explícita.
+ * Album solo contiene un int y un QString, así que guardarlo por valor es más
+ * barato que un puntero a un objeto en el heap. Con std::move() el nombre pasa
+ * al vector sin copiarse, y el vector entero se devuelve también por movimiento.
  *
- * Ventajas del patrón RAII (Resource Acquisition Is Initialization):
- * - Cada Album es ahora propiedad de std::unique_ptr
- * - El vector se encarga automáticamente de destruir los objetos Album al finalizar su ciclo de vida
- * - Evita fugas de memoria (memory leaks)
- * - Hace el código más seguro y robusto
+ * Ventajas del almacenamiento por valor:
+ * - Los álbumes están contiguos en memoria
+ * - El vector destruye los álbumes al finalizar su ciclo de vida (RAII)
+ * - Evita fugas de memoria (memory leaks) y dobles liberaciones
  * - No es necesario llamar manualmente a delete para liberar memoria
  */
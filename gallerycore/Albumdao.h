@@ -2,9 +2,10 @@
 #define ALBUMDAO_H
 
 #include <QVector>
+#include "Album.h"
+#include "StatementCache.h"
 
 class QSqlDatabase;
-class Album;
 class AlbumDao
 {
 public:
@@ -15,10 +16,12 @@ public:
     void updateAlbum(const Album& album) const;
     void removeAlbum(int id) const;
 
-    QVector<Album*> albums() const;
+    Album album(int id) const;
+    QVector<Album> albums() const;
 
 private:
     QSqlDatabase& mDatabase;
+    mutable StatementCache mStatements;
 };
 
 #endif
@@ -0,0 +1,104 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QWaitCondition>
+#include <utility>
+
+/**
+ * Cola de capacidad limitada para comunicar hilos productores y consumidores
+ *
+ * push() bloquea mientras la cola está llena y pop() mientras está vacía, de
+ * modo que una etapa rápida no acumula memoria sin límite por delante de una
+ * lenta (contrapresión).
+ *
+ * - close(): no se aceptan más elementos; los consumidores vacían lo que queda
+ *   y después pop() devuelve false.
+ * - abort(): cancela la cola; push() y pop() devuelven false inmediatamente.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int capacity) :
+        mCapacity(capacity),
+        mClosed(false),
+        mAborted(false)
+    {
+    }
+
+    /**
+     * Añade un elemento, esperando si la cola está llena
+     * @return false si la cola se ha cerrado o cancelado
+     */
+    bool push(T item)
+    {
+        QMutexLocker locker(&mMutex);
+        while (mItems.size() >= mCapacity && !mClosed && !mAborted) {
+            mNotFull.wait(&mMutex);
+        }
+        if (mClosed || mAborted) {
+            return false;
+        }
+        mItems.enqueue(std::move(item));
+        mNotEmpty.wakeOne();
+        return true;
+    }
+
+    /**
+     * Extrae un elemento, esperando si la cola está vacía
+     * @return false si la cola está cerrada y vacía, o si se ha cancelado
+     */
+    bool pop(T& item)
+    {
+        QMutexLocker locker(&mMutex);
+        while (mItems.isEmpty() && !mClosed && !mAborted) {
+            mNotEmpty.wait(&mMutex);
+        }
+        if (mAborted || mItems.isEmpty()) {
+            return false;
+        }
+        item = mItems.dequeue();
+        mNotFull.wakeOne();
+        return true;
+    }
+
+    /**
+     * Número de elementos en espera (para métricas; puede cambiar enseguida)
+     */
+    int size()
+    {
+        QMutexLocker locker(&mMutex);
+        return int(mItems.size());
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&mMutex);
+        mClosed = true;
+        mNotEmpty.wakeAll();
+        mNotFull.wakeAll();
+    }
+
+    void abort()
+    {
+        QMutexLocker locker(&mMutex);
+        mAborted = true;
+        mItems.clear();
+        mNotEmpty.wakeAll();
+        mNotFull.wakeAll();
+    }
+
+private:
+    QMutex mMutex;
+    QWaitCondition mNotFull;
+    QWaitCondition mNotEmpty;
+    QQueue<T> mItems;
+    const int mCapacity;
+    bool mClosed;
+    bool mAborted;
+};
+
+#endif // BOUNDEDQUEUE_H
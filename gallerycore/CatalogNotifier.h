@@ -0,0 +1,49 @@
+#ifndef CATALOGNOTIFIER_H
+#define CATALOGNOTIFIER_H
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include "gallerycore_global.h"
+
+/**
+ * Notificaciones de cambios en el catálogo (base de datos)
+ *
+ * Los DAOs no emiten señales; quien modifica la base de datos (modelos,
+ * importación...) emite aquí qué álbum ha cambiado, y quien guarda datos
+ * derivados (por ejemplo, las instantáneas de PictureModel) los invalida.
+ *
+ * Una única instancia vive en DatabaseManager::notifier.
+ */
+class GALLERYCORE_EXPORT CatalogNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CatalogNotifier(QObject* parent = nullptr) : QObject(parent) {}
+
+signals:
+    // Se han añadido, eliminado o modificado imágenes de un álbum
+    void picturesChanged(int albumId);
+
+    // Se han movido (o copiado, sin álbumes de origen) imágenes a un álbum
+    // Una sola señal por operación, aunque afecte a varios álbumes
+    void picturesMoved(int targetAlbumId, const QList<int>& sourceAlbumIds);
+
+    // Se han modificado en disco archivos del catálogo (sus thumbnails ya no valen)
+    void filesModified(const QStringList& paths);
+
+    // Se ha cambiado la ruta de una carpeta y sus subcarpetas (unidad o punto
+    // de montaje movido); las imágenes y sus IDs no cambian
+    void directoriesRelocated(const QString& oldPath, const QString& newPath);
+
+    // Se ha creado un álbum fuera de AlbumModel (por ejemplo, al importar una carpeta)
+    void albumAdded(int albumId);
+
+    // Se ha cambiado el nombre de un álbum (sus imágenes no cambian)
+    void albumRenamed(int albumId);
+
+    // Se ha eliminado un álbum (y con él sus imágenes)
+    void albumRemoved(int albumId);
+};
+
+#endif // CATALOGNOTIFIER_H
@@ -0,0 +1,143 @@
+#include "ContentHash.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+// Constantes de XXH64
+const quint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const quint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const quint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+const quint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const quint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Lecturas sin alinear en little endian (el formato de XXH64)
+inline quint64 read64(const uchar* data)
+{
+    quint64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+inline quint32 read32(const uchar* data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+inline quint64 round(quint64 accumulator, quint64 input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+inline quint64 mergeRound(quint64 accumulator, quint64 value)
+{
+    accumulator ^= round(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+}
+
+/**
+ * Calcula el hash XXH64 de un bloque de memoria
+ * @param data Datos a procesar
+ * @param length Número de bytes
+ * @param seed Semilla (0 por defecto, igual que la implementación de referencia)
+ * @return Hash de 64 bits, compatible con XXH64() de la librería xxHash
+ */
+quint64 ContentHash::xxh64(const void* data, qint64 length, quint64 seed)
+{
+    const uchar* p = static_cast<const uchar*>(data);
+    const uchar* end = p + length;
+    quint64 hash;
+
+    // Bloques de 32 bytes con cuatro acumuladores independientes
+    if (length >= 32) {
+        const uchar* limit = end - 32;
+        quint64 v1 = seed + PRIME64_1 + PRIME64_2;
+        quint64 v2 = seed + PRIME64_2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - PRIME64_1;
+
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += quint64(length);
+
+    // Bytes restantes: de 8 en 8, de 4 en 4 y de 1 en 1
+    while (p + 8 <= end) {
+        hash ^= round(0, read64(p));
+        hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= quint64(read32(p)) * PRIME64_1;
+        hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= quint64(*p) * PRIME64_5;
+        hash = rotateLeft(hash, 11) * PRIME64_1;
+        ++p;
+    }
+
+    // Mezcla final (avalancha)
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/**
+ * Calcula el hash del contenido de un archivo
+ * @param localPath Ruta local del archivo
+ * @return Hash XXH64 del archivo, o 0 si no se puede leer
+ *
+ * El archivo se proyecta en memoria; el sistema operativo lo lee por
+ * páginas a medida que el hash avanza. Si no se puede proyectar (por
+ * ejemplo, un archivo vacío) se lee de forma normal.
+ */
+quint64 ContentHash::file(const QString& localPath)
+{
+    QFile file(localPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    qint64 size = file.size();
+    if (size > 0) {
+        if (uchar* data = file.map(0, size)) {
+            quint64 hash = xxh64(data, size);
+            file.unmap(data);
+            return hash;
+        }
+    }
+
+    QByteArray contents = file.readAll();
+    return xxh64(contents.constData(), contents.size());
+}
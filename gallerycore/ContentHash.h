@@ -0,0 +1,25 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QString>
+#include "gallerycore_global.h"
+
+/**
+ * Hash del contenido de los archivos, para detectar imágenes duplicadas
+ *
+ * Usa XXH64 (xxHash de 64 bits): no es criptográfico, pero procesa varios
+ * GB/s y su probabilidad de colisión es despreciable para un catálogo de
+ * fotos. El archivo se proyecta en memoria (QFile::map) en lugar de leerse,
+ * así que no se copia a un búfer intermedio.
+ */
+class GALLERYCORE_EXPORT ContentHash
+{
+public:
+    static quint64 file(const QString& localPath);
+    static quint64 xxh64(const void* data, qint64 length, quint64 seed = 0);
+
+private:
+    ContentHash() = delete;
+};
+
+#endif // CONTENTHASH_H
@@ -1,5 +1,21 @@
 #include "Databasemanager.h"
+#include <QSettings>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <atomic>
+
+namespace {
+
+// Ruta indicada por línea de comandos (ver setCatalogPath)
+QString explicitCatalogPath;
+
+// Contador para dar un nombre de conexión único a cada instancia
+std::atomic<int> connectionCount(0);
+
+// Espera máxima de una conexión si otra está escribiendo en el catálogo
+const int BUSY_TIMEOUT_MS = 5000;
+
+}
 
 /**
  * Retorna la instancia única del DatabaseManager (patrón Singleton)
@@ -7,73 +23,230 @@
  *
  * Implementa el patrón Singleton usando una variable estática local.
  * La primera vez que se llama, crea la instancia; las siguientes veces retorna
- * la misma instancia ya creada. Esto garantiza que solo exista una conexión
- * a la base de datos en toda la aplicación.
+ * la misma instancia ya creada. Es el catálogo de la aplicación: usa la
+ * conexión por defecto de Qt y la ruta de catalogPath().
  *
  * Thread-safe en C++11 y versiones posteriores: la inicialización de variables
  * estáticas locales está garantizada como thread-safe por el estándar.
  */
 DatabaseManager& DatabaseManager::instance()
 {
-    static DatabaseManager singleton;  // Se crea solo una vez, persiste durante toda la ejecución
+    // Se crea solo una vez, persiste durante toda la ejecución
+    static DatabaseManager singleton(catalogPath(), QString::fromLatin1(QSqlDatabase::defaultConnection));
     return singleton;  // Retorna siempre la misma instancia
 }
 
 /**
- * Constructor privado de DatabaseManager
- * @param path Ruta del archivo de base de datos SQLite (valor por defecto definido en el .h)
+ * Ruta del catálogo de la aplicación
+ * @return Por orden de prioridad: la indicada con setCatalogPath(), la
+ *         variable de entorno GALLERY_CATALOG, la clave "catalog/path" de la
+ *         configuración o gallery.db en la carpeta actual
+ *
+ * MEMORY_DATABASE (":memory:") abre un catálogo vacío en memoria. Un archivo
+ * en un tmpfs (por ejemplo /dev/shm/gallery.db) también evita el disco y
+ * conserva el modo WAL.
+ */
+QString DatabaseManager::catalogPath()
+{
+    if (!explicitCatalogPath.isEmpty()) {
+        return explicitCatalogPath;
+    }
+    QString path = qEnvironmentVariable("GALLERY_CATALOG");
+    if (path.isEmpty()) {
+        path = QSettings().value("catalog/path").toString();
+    }
+    return path.isEmpty() ? DATABASE_FILENAME : path;
+}
+
+/**
+ * Fija la ruta del catálogo de la aplicación (opción --catalog)
+ * @param path Ruta del archivo o MEMORY_DATABASE
+ *
+ * Debe llamarse antes del primer instance().
+ */
+void DatabaseManager::setCatalogPath(const QString& path)
+{
+    explicitCatalogPath = path;
+}
+
+/**
+ * Constructor de un catálogo independiente del de la aplicación
+ * @param path Ruta del archivo de base de datos SQLite, o MEMORY_DATABASE
+ *
+ * Cada instancia tiene su propia conexión (con un nombre único), sus DAOs y
+ * su CatalogNotifier, así que varias pueden convivir en el mismo proceso;
+ * por ejemplo, benchmarks con catálogos en memoria. Los modelos la reciben
+ * en su constructor.
+ */
+DatabaseManager::DatabaseManager(const QString& path) :
+    DatabaseManager(path, QString("gallery-catalog-%1").arg(++connectionCount))
+{
+}
+
+/**
+ * Constructor de DatabaseManager
+ * @param path Ruta del archivo de base de datos SQLite, o MEMORY_DATABASE
+ * @param connectionName Nombre de la conexión de Qt
  *
  * Inicializa la conexión a la base de datos y los objetos DAO (Data Access Object).
- * Este constructor es privado para asegurar que solo se pueda crear una instancia
- * mediante el método instance() (patrón Singleton).
  *
  * Pasos que realiza:
- * 1. Crea la conexión a la base de datos SQLite
- * 2. Inicializa los DAOs (albumDao y pictureDao) con la conexión
- * 3. Establece la ruta del archivo de base de datos
- * 4. Abre la conexión a la base de datos
- * 5. Inicializa las tablas necesarias en la base de datos
+ * 1. Crea y abre la conexión a la base de datos SQLite (ver Connection)
+ * 2. Inicializa los DAOs (albumDao, directoryDao, pictureDao y searchDao) con la conexión
+ * 3. Inicializa las tablas necesarias en la base de datos
  */
-DatabaseManager::DatabaseManager(const QString& path) :
-    // Crea un nuevo objeto QSqlDatabase con el driver QSQLITE para bases de datos SQLite
-    mDatabase(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE"))),
+DatabaseManager::DatabaseManager(const QString& path, const QString& connectionName) :
+    // Crea y abre la conexión SQLite
+    mConnection(path, connectionName),
     // Inicializa el DAO de álbumes pasándole la referencia a la base de datos
-    albumDao(*mDatabase),
+    albumDao(*mConnection.database),
+    // Inicializa el DAO de carpetas (rutas compartidas por las imágenes)
+    directoryDao(*mConnection.database),
     // Inicializa el DAO de imágenes pasándole la referencia a la base de datos
-    pictureDao(*mDatabase)
+    pictureDao(*mConnection.database, directoryDao),
+    // Inicializa el DAO de búsqueda de texto completo
+    searchDao(*mConnection.database)
 {
-    // Establece la ruta del archivo de base de datos SQLite
-    mDatabase->setDatabaseName(path);
-
-    // Abre la conexión a la base de datos
-    // Si el archivo no existe, SQLite lo creará automáticamente
-    mDatabase->open();
+    if (!isInMemory()) {
+        // Modo WAL: las lecturas de la interfaz no se bloquean mientras otra
+        // conexión (la importación en segundo plano) escribe en el catálogo.
+        // Se guarda en el archivo, así que basta con fijarlo una vez
+        QSqlQuery(*mConnection.database).exec("PRAGMA journal_mode = WAL");
+    }
+    configureConnection(*mConnection.database);
 
     // Inicializa la tabla de álbumes en la base de datos
     // Crea la tabla si no existe
     albumDao.init();
 
+    // Inicializa la tabla de carpetas
+    // Debe ir antes de pictureDao, que la usa al migrar rutas antiguas
+    directoryDao.init();
+
     // Inicializa la tabla de imágenes en la base de datos
     // Crea la tabla si no existe
     pictureDao.init();
+
+    // Inicializa el índice de búsqueda (FTS5) y sus triggers
+    // Debe ir después de las tablas de álbumes e imágenes
+    searchDao.init();
 }
 
 /**
  * Destructor de DatabaseManager
  *
- * Se encarga de cerrar correctamente la conexión a la base de datos
- * y liberar la memoria del objeto QSqlDatabase.
+ * La conexión se cierra al destruirse mConnection, después de los DAOs.
+ */
+DatabaseManager::~DatabaseManager()
+{
+}
+
+/**
+ * Ruta del catálogo (MEMORY_DATABASE si está en memoria)
+ */
+QString DatabaseManager::path() const
+{
+    return mConnection.path;
+}
+
+/**
+ * Nombre de la conexión de Qt del catálogo
+ *
+ * Las tareas en segundo plano no la usan directamente: abren su propia
+ * conexión con openConnection() para trabajar en su hilo.
+ */
+QString DatabaseManager::connectionName() const
+{
+    return mConnection.database->connectionName();
+}
+
+/**
+ * Indica si el catálogo está en memoria (se pierde al destruir la instancia)
+ */
+bool DatabaseManager::isInMemory() const
+{
+    return mConnection.path == MEMORY_DATABASE;
+}
+
+/**
+ * Abre una conexión nueva al mismo catálogo
+ * @param connectionName Nombre de la nueva conexión de Qt (único)
+ * @return Conexión configurada como la principal; si no se pudo abrir,
+ *         isOpen() es false y lastError() indica el motivo
+ *
+ * Las tareas en segundo plano (importación, vigilancia de carpetas,
+ * comprobación de la instantánea) la abren en su propio hilo y la quitan
+ * con QSqlDatabase::removeDatabase() al terminar.
+ */
+QSqlDatabase DatabaseManager::openConnection(const QString& connectionName) const
+{
+    QSqlDatabase database = QSqlDatabase::cloneDatabase(this->connectionName(), connectionName);
+    if (database.open()) {
+        configureConnection(database);
+    }
+    return database;
+}
+
+/**
+ * Aplica los PRAGMAs de cada conexión (no se guardan en el archivo)
+ * @param database Conexión abierta del catálogo
+ */
+void DatabaseManager::configureConnection(QSqlDatabase& database) const
+{
+    QSqlQuery query(database);
+    if (isInMemory()) {
+        // En memoria no hay WAL: la caché compartida bloquea por tablas.
+        // Se permite leer lo que la importación aún no ha confirmado para
+        // que la interfaz no se encuentre las tablas bloqueadas
+        query.exec("PRAGMA read_uncommitted = 1");
+    }
+    // Si otra conexión está escribiendo, espera en lugar de fallar
+    query.exec(QString("PRAGMA busy_timeout = %1").arg(BUSY_TIMEOUT_MS));
+}
+
+/**
+ * Crea y abre la conexión SQLite del catálogo
+ * @param path Ruta del archivo; si no existe, SQLite lo crea
+ * @param name Nombre de la conexión de Qt
+ *
+ * Un ":memory:" normal es privado de cada conexión, y las de
+ * openConnection() (importación, reconciliación) verían un catálogo vacío.
+ * En su lugar se abre una base en memoria con caché compartida, con el
+ * nombre de la conexión: todas sus copias ven el mismo catálogo y los de
+ * otras instancias no se mezclan.
+ */
+DatabaseManager::Connection::Connection(const QString& path, const QString& name) :
+    path(path),
+    // Crea un nuevo objeto QSqlDatabase con el driver QSQLITE para bases de datos SQLite
+    database(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", name)))
+{
+    if (path == MEMORY_DATABASE) {
+        database->setConnectOptions("QSQLITE_OPEN_URI");
+        database->setDatabaseName(QString("file:%1?mode=memory&cache=shared").arg(name));
+    } else {
+        database->setDatabaseName(path);
+    }
+    database->open();
+}
+
+/**
+ * Cierra la conexión y la quita del registro de Qt
  *
  * Es importante cerrar la conexión antes de eliminar el objeto para
  * asegurar que todos los datos pendientes se escriban correctamente
- * y los recursos se liberen de forma apropiada.
+ * y los recursos se liberen de forma apropiada. Un catálogo en memoria
+ * desaparece al cerrar su última conexión.
  */
-DatabaseManager::~DatabaseManager()
+DatabaseManager::Connection::~Connection()
 {
+    const QString name = database->connectionName();
+
     // Cierra la conexión a la base de datos
     // Esto asegura que todos los cambios pendientes se escriban en disco
-    mDatabase->close();
+    database->close();
 
     // Libera la memoria del objeto QSqlDatabase creado dinámicamente
-    delete mDatabase;
+    delete database;
+
+    QSqlDatabase::removeDatabase(name);
 }
@@ -3,28 +3,61 @@
 
 #include <QString>
 #include "AlbumDao.h"
+#include "CatalogNotifier.h"
+#include "DirectoryDao.h"
 #include "PictureDao.h"
+#include "SearchDao.h"
 
 const QString DATABASE_FILENAME = "gallery.db";
 
+// Ruta especial: catálogo en memoria, sin archivo
+const QString MEMORY_DATABASE = ":memory:";
+
 class QSqlDatabase;
 class DatabaseManager
 {
 public:
     static DatabaseManager& instance();
+    static QString catalogPath();
+    static void setCatalogPath(const QString& path);
+
+    explicit DatabaseManager(const QString& path = DATABASE_FILENAME);
+    DatabaseManager(const DatabaseManager& rhs) = delete;
+    DatabaseManager& operator=(const DatabaseManager& rhs) = delete;
     ~DatabaseManager();
 
+    QString path() const;
+    QString connectionName() const;
+    bool isInMemory() const;
+    QSqlDatabase openConnection(const QString& connectionName) const;
+
 protected:
-    DatabaseManager(const QString& path = DATABASE_FILENAME);
-    DatabaseManager& operator=(const DatabaseManager& rhs);
+    DatabaseManager(const QString& path, const QString& connectionName);
 
 private:
-    QSqlDatabase* mDatabase;
+    void configureConnection(QSqlDatabase& database) const;
+
+    // Conexión del catálogo. Se declara antes que los DAOs para destruirse
+    // después de ellos, cuando ya no quedan sentencias abiertas
+    struct Connection
+    {
+        Connection(const QString& path, const QString& name);
+        ~Connection();
+
+        QString path;
+        QSqlDatabase* database;
+    };
+    Connection mConnection;
 
     //No mover, si no, crashea
 public:
     const AlbumDao albumDao;
+    const DirectoryDao directoryDao;
     const PictureDao pictureDao;
+    const SearchDao searchDao;
+
+    // Señales de cambios en el catálogo (no const: se emiten señales)
+    CatalogNotifier notifier;
 
 
 };
@@ -0,0 +1,392 @@
+#include "DirectoryDao.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QDebug>
+#include <QStringList>
+#include <atomic>
+#include <utility>
+#include "ProfiledQuery.h"
+
+namespace {
+
+// Se incrementa cada vez que las rutas en caché de cualquier DirectoryDao
+// dejan de ser válidas (ver invalidateAllCaches)
+std::atomic<int> cacheGeneration(0);
+
+}
+
+/**
+ * Constructor de DirectoryDao
+ * @param database Referencia a la base de datos SQL que se utilizará para las operaciones
+ *
+ * Este DAO gestiona la tabla "directories", que guarda una sola vez cada
+ * carpeta que contiene imágenes. Las imágenes solo almacenan el id de su
+ * carpeta y su nombre de archivo relativo.
+ */
+DirectoryDao::DirectoryDao(QSqlDatabase& database) :
+    mDatabase(database),
+    mStatements(database),
+    mCacheGeneration(cacheGeneration.load())
+{
+}
+
+/**
+ * Inicializa la tabla de carpetas en la base de datos
+ *
+ * La tabla contiene:
+ * - id: clave primaria autoincremental
+ * - path: ruta absoluta de la carpeta, con '/' como separador (única)
+ * - scanned_at: fecha de modificación de la carpeta (ms desde epoch) la
+ *   última vez que se sincronizó con el disco (ver LibraryWatcher)
+ *
+ * También crea la tabla "watched_folders" con las carpetas vigiladas y el
+ * álbum al que se añaden sus archivos nuevos.
+ *
+ * Debe llamarse antes de PictureDao::init(), que la usa para migrar las
+ * URLs completas de versiones anteriores.
+ */
+void DirectoryDao::init() const
+{
+    ProfiledQuery query(mDatabase);
+    QStringList tables = mDatabase.tables();
+
+    if (!tables.contains("directories")) {
+        query.exec("CREATE TABLE directories "
+                   "(id INTEGER PRIMARY KEY AUTOINCREMENT, path TEXT NOT NULL UNIQUE, "
+                   "scanned_at INTEGER NOT NULL DEFAULT 0)");
+    } else {
+        // Migración: columna añadida con las carpetas vigiladas
+        query.exec("SELECT scanned_at FROM directories LIMIT 0");
+        if (query.lastError().isValid()) {
+            query.exec("ALTER TABLE directories ADD COLUMN scanned_at INTEGER NOT NULL DEFAULT 0");
+        }
+    }
+
+    if (!tables.contains("watched_folders")) {
+        query.exec("CREATE TABLE watched_folders "
+                   "(id INTEGER PRIMARY KEY AUTOINCREMENT, path TEXT NOT NULL UNIQUE, "
+                   "album_id INTEGER NOT NULL)");
+    }
+}
+
+/**
+ * Obtiene el id de una carpeta, creándola si no existe
+ * @param path Ruta absoluta de la carpeta
+ * @return ID de la carpeta, o -1 si hay un error
+ */
+int DirectoryDao::directoryIdForPath(const QString& path) const
+{
+    checkCache();
+
+    // La mayoría de imports repiten la misma carpeta
+    auto it = mIds.constFind(path);
+    if (it != mIds.cend()) {
+        return it.value();
+    }
+
+    CachedQuery insert = mStatements.prepared("INSERT OR IGNORE INTO directories (path) VALUES (:path)");
+    insert->bindValue(":path", path);
+    insert->exec();
+
+    CachedQuery query = mStatements.prepared("SELECT id FROM directories WHERE path = :path");
+    query->bindValue(":path", path);
+    if (!query->exec() || !query->next()) {
+        qDebug() << "Error al obtener la carpeta:" << query->lastError();
+        return -1;
+    }
+
+    int id = query->value(0).toInt();
+    mPaths.insert(id, path);
+    mIds.insert(path, id);
+    return id;
+}
+
+/**
+ * Busca el id de una carpeta sin crearla
+ * @param path Ruta absoluta de la carpeta
+ * @return ID de la carpeta, o -1 si no está registrada
+ */
+int DirectoryDao::findDirectoryId(const QString& path) const
+{
+    checkCache();
+
+    auto it = mIds.constFind(path);
+    if (it != mIds.cend()) {
+        return it.value();
+    }
+
+    CachedQuery query = mStatements.prepared("SELECT id FROM directories WHERE path = :path");
+    query->bindValue(":path", path);
+    if (!query->exec() || !query->next()) {
+        return -1;
+    }
+
+    int id = query->value(0).toInt();
+    mPaths.insert(id, path);
+    mIds.insert(path, id);
+    return id;
+}
+
+/**
+ * Obtiene la ruta de una carpeta a partir de su id
+ * @param directoryId ID de la carpeta
+ * @return Ruta absoluta, o cadena vacía si no existe
+ */
+QString DirectoryDao::path(int directoryId) const
+{
+    checkCache();
+
+    auto it = mPaths.constFind(directoryId);
+    if (it != mPaths.cend()) {
+        return it.value();
+    }
+
+    CachedQuery query = mStatements.prepared("SELECT path FROM directories WHERE id = :id");
+    query->bindValue(":id", directoryId);
+    if (!query->exec() || !query->next()) {
+        return QString();
+    }
+
+    QString path = query->value(0).toString();
+    mPaths.insert(directoryId, path);
+    mIds.insert(path, directoryId);
+    return path;
+}
+
+/**
+ * Cambia la ruta de una carpeta y de todas sus subcarpetas
+ * @param oldPath Ruta actual, por ejemplo "D:/Fotos"
+ * @param newPath Nueva ruta, por ejemplo "E:/Fotos"
+ * @return Número de carpetas actualizadas, o -1 si hay un error
+ *
+ * Como las imágenes solo guardan el id de su carpeta (y el índice de
+ * búsqueda indexa las rutas por carpeta), mover una unidad o un punto de
+ * montaje es una única sentencia UPDATE sobre "directories",
+ * independientemente del número de imágenes que contenga. Las carpetas
+ * vigiladas que estén dentro se reubican igual.
+ *
+ * Se vacía la caché de rutas de este DAO. Quien llama debe hacerlo dentro de
+ * una transacción y, solo después de confirmarla, invalidar las cachés de
+ * los demás DAOs (invalidateAllCaches()) y emitir
+ * CatalogNotifier::directoriesRelocated; si la deshace, debe volver a vaciar
+ * la de este DAO con clearCache().
+ */
+int DirectoryDao::relocateDirectory(const QString& oldPath, const QString& newPath) const
+{
+    ProfiledQuery watched(mDatabase);
+    watched.prepare("UPDATE watched_folders SET path = :newPath || substr(path, :oldLength + 1) "
+                    "WHERE path = :oldPath OR substr(path, 1, :prefixLength) = :oldPrefix");
+    watched.bindValue(":newPath", newPath);
+    watched.bindValue(":oldLength", oldPath.length());
+    watched.bindValue(":oldPath", oldPath);
+    watched.bindValue(":prefixLength", oldPath.length() + 1);
+    watched.bindValue(":oldPrefix", oldPath + '/');
+    if (!watched.exec()) {
+        qDebug() << "Error al reubicar las carpetas vigiladas:" << watched.lastError();
+        return -1;
+    }
+
+    ProfiledQuery query(mDatabase);
+    query.prepare("UPDATE directories SET path = :newPath || substr(path, :oldLength + 1) "
+                  "WHERE path = :oldPath OR substr(path, 1, :prefixLength) = :oldPrefix");
+    query.bindValue(":newPath", newPath);
+    query.bindValue(":oldLength", oldPath.length());
+    query.bindValue(":oldPath", oldPath);
+    query.bindValue(":prefixLength", oldPath.length() + 1);
+    query.bindValue(":oldPrefix", oldPath + '/');
+
+    if (!query.exec()) {
+        qDebug() << "Error al reubicar la carpeta:" << query.lastError();
+        return -1;
+    }
+
+    // Las rutas en caché ya no son válidas en esta conexión; las demás no
+    // ven el cambio hasta que se confirme
+    clearCache();
+    return query.numRowsAffected();
+}
+
+/**
+ * Vacía las cachés de rutas de este DAO
+ *
+ * Se usa al deshacer una transacción: los ids de las carpetas creadas en
+ * ella ya no existen y SQLite puede volver a asignarlos a otras rutas.
+ */
+void DirectoryDao::clearCache() const
+{
+    mPaths.clear();
+    mIds.clear();
+}
+
+/**
+ * Invalida las cachés de rutas de todos los DirectoryDao del proceso
+ *
+ * Cada DAO compara la generación al consultar su caché (checkCache()), así
+ * que funciona con DAOs de otras conexiones y de otros hilos.
+ */
+void DirectoryDao::invalidateAllCaches()
+{
+    ++cacheGeneration;
+}
+
+/**
+ * Vacía las cachés si se han invalidado desde que se llenaron
+ */
+void DirectoryDao::checkCache() const
+{
+    const int generation = cacheGeneration.load(std::memory_order_acquire);
+    if (generation != mCacheGeneration) {
+        clearCache();
+        mCacheGeneration = generation;
+    }
+}
+
+/**
+ * Obtiene los ids de una carpeta y de todas sus subcarpetas registradas
+ * @param path Ruta absoluta de la carpeta
+ * @return IDs de las carpetas (vacío si ninguna está registrada)
+ */
+QVector<int> DirectoryDao::directoryIdsUnder(const QString& path) const
+{
+    ProfiledQuery query(mDatabase);
+    query.prepare("SELECT id FROM directories "
+                  "WHERE path = :path OR substr(path, 1, :prefixLength) = :prefix");
+    query.bindValue(":path", path);
+    query.bindValue(":prefixLength", path.length() + 1);
+    query.bindValue(":prefix", path + '/');
+
+    QVector<int> ids;
+    if (!query.exec()) {
+        qDebug() << "Error al obtener las subcarpetas:" << query.lastError();
+        return ids;
+    }
+    while (query.next()) {
+        ids << query.value(0).toInt();
+    }
+    return ids;
+}
+
+/**
+ * Obtiene los ids de todas las carpetas registradas
+ * @return IDs de las carpetas, ordenados por ruta
+ *
+ * Las rutas quedan en caché: quien recorre todo el catálogo (gallerycli)
+ * pide a continuación la ruta de cada carpeta.
+ */
+QVector<int> DirectoryDao::directoryIds() const
+{
+    ProfiledQuery query(mDatabase);
+    query.setForwardOnly(true);
+
+    QVector<int> ids;
+    if (!query.exec("SELECT id, path FROM directories ORDER BY path")) {
+        qDebug() << "Error al obtener las carpetas:" << query.lastError();
+        return ids;
+    }
+    while (query.next()) {
+        int id = query.value(0).toInt();
+        QString path = query.value(1).toString();
+        mPaths.insert(id, path);
+        mIds.insert(path, id);
+        ids << id;
+    }
+    return ids;
+}
+
+/**
+ * Obtiene la fecha de modificación de una carpeta en su última sincronización
+ * @param directoryId ID de la carpeta
+ * @return Fecha en ms desde epoch, o 0 si nunca se ha sincronizado
+ */
+qint64 DirectoryDao::scannedAt(int directoryId) const
+{
+    CachedQuery query = mStatements.prepared("SELECT scanned_at FROM directories WHERE id = :id");
+    query->bindValue(":id", directoryId);
+    if (!query->exec() || !query->next()) {
+        return 0;
+    }
+    return query->value(0).toLongLong();
+}
+
+/**
+ * Registra que una carpeta se ha sincronizado con el disco
+ * @param directoryId ID de la carpeta
+ * @param modifiedAt Fecha de modificación de la carpeta en ese momento (ms desde epoch)
+ *
+ * Crear, borrar o renombrar un archivo cambia la fecha de modificación de su
+ * carpeta: al arrancar solo se vuelven a listar las carpetas cuya fecha no
+ * coincide con la guardada.
+ */
+void DirectoryDao::setScannedAt(int directoryId, qint64 modifiedAt) const
+{
+    CachedQuery query = mStatements.prepared("UPDATE directories SET scanned_at = :scannedAt WHERE id = :id");
+    query->bindValue(":scannedAt", modifiedAt);
+    query->bindValue(":id", directoryId);
+    if (!query->exec()) {
+        qDebug() << "Error al guardar la sincronización de la carpeta:" << query->lastError();
+    }
+}
+
+/**
+ * Obtiene las carpetas vigiladas
+ */
+QVector<WatchedFolder> DirectoryDao::watchedFolders() const
+{
+    ProfiledQuery query("SELECT path, album_id FROM watched_folders", mDatabase);
+
+    QVector<WatchedFolder> folders;
+    while (query.next()) {
+        WatchedFolder folder;
+        folder.path = query.value(0).toString();
+        folder.albumId = query.value(1).toInt();
+        folders.push_back(std::move(folder));
+    }
+    return folders;
+}
+
+/**
+ * Añade una carpeta vigilada (o cambia su álbum si ya lo estaba)
+ */
+void DirectoryDao::addWatchedFolder(const WatchedFolder& folder) const
+{
+    ProfiledQuery query(mDatabase);
+    query.prepare("INSERT OR REPLACE INTO watched_folders (path, album_id) VALUES (:path, :albumId)");
+    query.bindValue(":path", folder.path);
+    query.bindValue(":albumId", folder.albumId);
+    if (!query.exec()) {
+        qDebug() << "Error al añadir la carpeta vigilada:" << query.lastError();
+    }
+}
+
+/**
+ * Deja de vigilar una carpeta (sus imágenes siguen en el catálogo)
+ */
+void DirectoryDao::removeWatchedFolder(const QString& path) const
+{
+    ProfiledQuery query(mDatabase);
+    query.prepare("DELETE FROM watched_folders WHERE path = :path");
+    query.bindValue(":path", path);
+    if (!query.exec()) {
+        qDebug() << "Error al eliminar la carpeta vigilada:" << query.lastError();
+    }
+}
+
+/**
+ * Construye la ruta completa de un archivo a partir de su carpeta y su nombre
+ * @param directory Ruta de la carpeta
+ * @param fileName Nombre del archivo
+ * @return Ruta completa, reservando la memoria justa en una sola asignación
+ */
+QString DirectoryDao::joinPath(const QString& directory, QStringView fileName)
+{
+    QString path;
+    path.reserve(directory.size() + 1 + fileName.size());
+    path += directory;
+    if (!directory.endsWith('/')) {
+        path += '/';
+    }
+    path += fileName;
+    return path;
+}
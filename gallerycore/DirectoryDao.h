@@ -0,0 +1,61 @@
+#ifndef DIRECTORYDAO_H
+#define DIRECTORYDAO_H
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "StatementCache.h"
+
+class QSqlDatabase;
+
+/**
+ * Carpeta vigilada: sus cambios en disco se sincronizan con el catálogo
+ */
+struct WatchedFolder
+{
+    QString path;       // Ruta absoluta de la carpeta raíz
+    int albumId = -1;   // Álbum de destino de los archivos nuevos
+};
+
+class DirectoryDao
+{
+public:
+    explicit DirectoryDao(QSqlDatabase& database);
+
+    void init() const;
+    int directoryIdForPath(const QString& path) const;
+    int findDirectoryId(const QString& path) const;
+    QString path(int directoryId) const;
+    int relocateDirectory(const QString& oldPath, const QString& newPath) const;
+    void clearCache() const;
+    QVector<int> directoryIdsUnder(const QString& path) const;
+    QVector<int> directoryIds() const;
+
+    qint64 scannedAt(int directoryId) const;
+    void setScannedAt(int directoryId, qint64 modifiedAt) const;
+
+    QVector<WatchedFolder> watchedFolders() const;
+    void addWatchedFolder(const WatchedFolder& folder) const;
+    void removeWatchedFolder(const QString& path) const;
+
+    static QString joinPath(const QString& directory, QStringView fileName);
+    static void invalidateAllCaches();
+
+private:
+    void checkCache() const;
+
+    QSqlDatabase& mDatabase;
+    mutable StatementCache mStatements;
+
+    // Cachés id -> ruta y ruta -> id; las carpetas son pocas comparadas con
+    // las imágenes y QString es implícitamente compartido, así que devolver
+    // una ruta no copia memoria
+    mutable QHash<int, QString> mPaths;
+    mutable QHash<QString, int> mIds;
+
+    // Generación de invalidateAllCaches() con la que se llenaron las cachés
+    mutable int mCacheGeneration;
+};
+
+#endif // DIRECTORYDAO_H
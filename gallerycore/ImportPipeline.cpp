@@ -0,0 +1,497 @@
+#include "ImportPipeline.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QThread>
+#include <QDebug>
+#include <utility>
+#include "Databasemanager.h"
+#include "ContentHash.h"
+#include "PerceptualHash.h"
+#include "MetadataExtractor.h"
+#include "Picture.h"
+#include "ThumbnailCache.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+// Hilos que recorren carpetas en paralelo (limitados por el disco, no por la CPU)
+const int WALKER_THREADS = 4;
+
+// Capacidad de las colas entre etapas
+const int QUEUE_CAPACITY = 1024;
+
+// Imágenes insertadas por transacción
+const int IMPORT_BATCH_SIZE = 500;
+
+// Intervalo mínimo entre notificaciones de imágenes nuevas a los modelos
+const int NOTIFY_INTERVAL_MS = 1000;
+
+/**
+ * Constructor de ImportPipeline
+ * @param database Catálogo en el que se importa (debe vivir más que el objeto)
+ * @param parent Objeto padre para la jerarquía de Qt
+ */
+ImportPipeline::ImportPipeline(DatabaseManager& database, QObject* parent) :
+    QObject(parent),
+    mDb(database),
+    mPendingDirectories(0),
+    mActiveWalkers(0),
+    mActiveAnalyzers(0),
+    mActiveThumbnailers(0),
+    mDiscovered(0),
+    mSkipped(0),
+    mImported(0),
+    mDuplicates(0),
+    mCancelled(false),
+    mRunning(false)
+{
+}
+
+/**
+ * Destructor de ImportPipeline
+ * Cancela la importación en curso y espera a que terminen todos los hilos.
+ */
+ImportPipeline::~ImportPipeline()
+{
+    cancel();
+    mPool.waitForDone();
+}
+
+/**
+ * Inicia la importación de una carpeta
+ * @param options Carpeta, álbum de destino y opciones de la importación
+ * @return false si ya hay una importación en curso o la carpeta no existe
+ *
+ * Lanza todas las etapas a la vez: cada una empieza a trabajar en cuanto le
+ * llega el primer elemento de la anterior.
+ */
+bool ImportPipeline::start(const ImportOptions& options)
+{
+    if (mRunning || !QFileInfo(options.rootPath).isDir()) {
+        return false;
+    }
+
+    mOptions = options;
+    mOptions.rootPath = QDir(options.rootPath).absolutePath();
+
+    mFiles = std::make_unique<BoundedQueue<QString>>(QUEUE_CAPACITY);
+    mAnalyzed = std::make_unique<BoundedQueue<Item>>(QUEUE_CAPACITY);
+    mThumbnailed = std::make_unique<BoundedQueue<Item>>(QUEUE_CAPACITY);
+
+    mKnownSizes.clear();
+    if (mOptions.duplicates != ImportOptions::KeepDuplicates) {
+        mKnownSizes = mDb.pictureDao.byteSizes();
+    }
+
+    mDirectories.clear();
+    mDirectories.enqueue(mOptions.rootPath);
+    mPendingDirectories = 1;
+
+    const int workers = qMax(1, QThread::idealThreadCount());
+    mActiveWalkers = WALKER_THREADS;
+    mActiveAnalyzers = workers;
+    mActiveThumbnailers = mOptions.thumbnailSize > 0 ? workers : 1;
+    mDiscovered = 0;
+    mSkipped = 0;
+    mImported = 0;
+    mDuplicates = 0;
+    mCancelled = false;
+    mRunning = true;
+    mChangedAlbums.clear();
+    mNotifyTimer.start();
+
+    // Cada tarea ocupa un hilo durante toda la importación (se bloquea en las
+    // colas), así que el pool necesita un hilo por tarea para no bloquearse
+    mPool.setMaxThreadCount(WALKER_THREADS + workers + mActiveThumbnailers + 1);
+
+    mPool.start([this] { writePictures(); });
+    for (int i = 0; i < mActiveThumbnailers; ++i) {
+        mPool.start([this] { generateThumbnails(); });
+    }
+    for (int i = 0; i < workers; ++i) {
+        mPool.start([this] { analyzeFiles(); });
+    }
+    for (int i = 0; i < WALKER_THREADS; ++i) {
+        mPool.start([this] { walkDirectories(); });
+    }
+    return true;
+}
+
+/**
+ * Cancela la importación en curso
+ *
+ * Las imágenes de los lotes ya escritos se conservan; el resto se descarta.
+ * La señal finished() se emite cuando todos los hilos han terminado.
+ */
+void ImportPipeline::cancel()
+{
+    if (!mRunning) {
+        return;
+    }
+
+    mCancelled = true;
+    {
+        QMutexLocker locker(&mDirectoryMutex);
+        mDirectoryAvailable.wakeAll();
+    }
+    mFiles->abort();
+    mAnalyzed->abort();
+    mThumbnailed->abort();
+}
+
+/**
+ * Indica si hay una importación en curso
+ */
+bool ImportPipeline::isRunning() const
+{
+    return mRunning;
+}
+
+/**
+ * Etapa 1: recorrido de carpetas
+ *
+ * Varios hilos comparten una cola de carpetas pendientes: cada hilo lista una
+ * carpeta, añade sus subcarpetas a la cola y envía sus archivos a la etapa
+ * siguiente. El recorrido termina cuando no quedan carpetas pendientes.
+ * No se siguen enlaces simbólicos para evitar ciclos.
+ */
+void ImportPipeline::walkDirectories()
+{
+    while (!mCancelled) {
+        QString directory;
+        {
+            QMutexLocker locker(&mDirectoryMutex);
+            while (mDirectories.isEmpty() && mPendingDirectories > 0 && !mCancelled) {
+                mDirectoryAvailable.wait(&mDirectoryMutex);
+            }
+            if (mDirectories.isEmpty() || mCancelled) {
+                break;
+            }
+            directory = mDirectories.dequeue();
+        }
+
+        QDirIterator it(directory, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot
+                                   | QDir::NoSymLinks | QDir::Readable);
+        while (it.hasNext() && !mCancelled) {
+            QString path = it.next();
+            if (it.fileInfo().isDir()) {
+                QMutexLocker locker(&mDirectoryMutex);
+                mDirectories.enqueue(path);
+                ++mPendingDirectories;
+                mDirectoryAvailable.wakeOne();
+            } else if (mFiles->push(path)) {
+                ++mDiscovered;
+            }
+        }
+
+        QMutexLocker locker(&mDirectoryMutex);
+        if (--mPendingDirectories == 0) {
+            mDirectoryAvailable.wakeAll();
+        }
+    }
+
+    if (--mActiveWalkers == 0) {
+        mFiles->close();
+    }
+}
+
+/**
+ * Etapa 2: detección del formato, extracción de metadatos y hash del contenido
+ *
+ * El formato se detecta por el contenido (no por la extensión) leyendo solo
+ * la cabecera; los archivos que no son imágenes se descartan aquí.
+ *
+ * El hash (ContentHash) solo se calcula si otro archivo del catálogo o de
+ * esta importación tiene el mismo tamaño: un archivo de tamaño único no
+ * puede ser un duplicado. Si el otro archivo tampoco tenía hash, el escritor
+ * lo calcula al comparar (PictureDao::findByContent).
+ */
+void ImportPipeline::analyzeFiles()
+{
+    const QDir root(mOptions.rootPath);
+
+    QString path;
+    while (!mCancelled && mFiles->pop(path)) {
+        GALLERY_TRACE_SCOPE(lcImport, "analyzeFile");
+        GALLERY_METRIC_SET("import.queue.files", mFiles->size());
+        QImageReader reader(path);
+        reader.setDecideFormatFromContent(true);
+        if (!reader.canRead()) {
+            ++mSkipped;
+            continue;
+        }
+
+        Item item;
+        item.path = path;
+        item.metadata = MetadataExtractor::extract(path);
+        if (mOptions.duplicates != ImportOptions::KeepDuplicates) {
+            {
+                QMutexLocker locker(&mSizesMutex);
+                item.duplicateCandidate = mKnownSizes.contains(item.metadata.byteSize);
+                if (!item.duplicateCandidate) {
+                    mKnownSizes.insert(item.metadata.byteSize);
+                }
+            }
+            if (item.duplicateCandidate) {
+                item.metadata.contentHash = ContentHash::file(path);
+            }
+        }
+        if (mOptions.albumPerFolder) {
+            item.folder = root.relativeFilePath(QFileInfo(path).absolutePath());
+            if (item.folder == ".") {
+                item.folder.clear();
+            }
+        }
+
+        if (!mAnalyzed->push(std::move(item))) {
+            break;
+        }
+    }
+
+    if (--mActiveAnalyzers == 0) {
+        mAnalyzed->close();
+    }
+}
+
+/**
+ * Etapa 3: generación de thumbnails en la caché de disco y del hash perceptual
+ *
+ * Los thumbnails se decodifican directamente a su tamaño final
+ * (ThumbnailCache::generate), así que las vistas los cargan después sin
+ * volver a leer la imagen original. Los posibles duplicados no generan
+ * thumbnail ni hash: si lo son, se usarán los de la imagen existente, y si
+ * no, la etapa de escritura calcula el hash antes de insertarlos.
+ */
+void ImportPipeline::generateThumbnails()
+{
+    const ThumbnailCache cache(mOptions.thumbnailSize);
+
+    Item item;
+    while (!mCancelled && mAnalyzed->pop(item)) {
+        GALLERY_TRACE_SCOPE(lcImport, "generateThumbnail");
+        GALLERY_METRIC_SET("import.queue.analyzed", mAnalyzed->size());
+        // El hash perceptual sale del thumbnail, que ya está decodificado
+        // (o se lee de la caché); sin thumbnails se decodifica a tamaño mínimo
+        if (!item.duplicateCandidate) {
+            item.metadata.perceptualHash = mOptions.thumbnailSize > 0
+                ? PerceptualHash::image(cache.thumbnail(item.path))
+                : PerceptualHash::file(item.path);
+        }
+        if (!mThumbnailed->push(std::move(item))) {
+            break;
+        }
+    }
+
+    if (--mActiveThumbnailers == 0) {
+        mThumbnailed->close();
+    }
+}
+
+/**
+ * Etapa 4: inserción en la base de datos por lotes
+ *
+ * Usa su propia conexión (clonada de la principal) y sus propios DAOs, e
+ * inserta IMPORT_BATCH_SIZE imágenes por transacción. Tras cada lote avisa
+ * al hilo de la interfaz con los álbumes modificados y los álbumes creados.
+ *
+ * Los archivos cuyo contenido ya está en el catálogo se enlazan u omiten
+ * según ImportOptions::duplicates; si ya están en el álbum de destino se
+ * omiten siempre, así que importar dos veces la misma tarjeta no duplica nada.
+ */
+void ImportPipeline::writePictures()
+{
+    const QString connectionName =
+        QString("gallery-import-%1").arg(reinterpret_cast<quintptr>(this));
+    bool cancelled = false;
+    {
+        QSqlDatabase database = mDb.openConnection(connectionName);
+        if (database.isOpen()) {
+            writeBatches(database);
+            database.close();
+        } else {
+            qDebug() << "Importación: no se puede abrir la base de datos:" << database.lastError();
+            mCancelled = true;
+            mFiles->abort();
+            mAnalyzed->abort();
+            mThumbnailed->abort();
+        }
+        cancelled = mCancelled;
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    QMetaObject::invokeMethod(this, [this, cancelled] {
+        writerFinished(cancelled);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * Escribe los elementos de la cola en lotes (hilo de la etapa 4)
+ * @param database Conexión propia de la etapa, ya abierta
+ *
+ * Si un lote no se puede confirmar se deshace entero: sus archivos se
+ * cuentan como omitidos y se olvidan los álbumes y carpetas creados en él,
+ * porque SQLite puede volver a asignar sus IDs.
+ */
+void ImportPipeline::writeBatches(QSqlDatabase& database)
+{
+    AlbumDao albumDao(database);
+    DirectoryDao directoryDao(database);
+    PictureDao pictureDao(database, directoryDao);
+
+    // Álbum de cada subcarpeta ("" = carpeta raíz)
+    QHash<QString, int> albumForFolder;
+    if (mOptions.albumId > 0) {
+        albumForFolder.insert(QString(), mOptions.albumId);
+    }
+
+    QVector<Item> batch;
+    batch.reserve(IMPORT_BATCH_SIZE);
+
+    auto writeBatch = [&] {
+        GALLERY_TRACE_SCOPE(lcImport, "writeBatch");
+        GALLERY_METRIC_TIMER("import.writeBatch.us");
+        QSet<int> albumIds;
+        QList<int> createdAlbumIds;
+        QStringList createdFolders;
+
+        database.transaction();
+        int imported = 0;
+        int duplicates = 0;
+        for (Item& item : batch) {
+            int albumId = albumForFolder.value(item.folder, -1);
+
+            int existingId = -1;
+            if (mOptions.duplicates != ImportOptions::KeepDuplicates) {
+                bool inAlbum = false;
+                existingId = pictureDao.findByContent(item.path, item.metadata,
+                                                      albumId, &inAlbum);
+                if (existingId > 0
+                    && (inAlbum || mOptions.duplicates == ImportOptions::SkipDuplicates)) {
+                    ++duplicates;
+                    continue;
+                }
+            }
+
+            if (albumId <= 0) {
+                QString name = item.folder.isEmpty()
+                    ? QFileInfo(mOptions.rootPath).fileName() : item.folder;
+                Album album(name);
+                albumDao.addAlbum(album);
+                albumId = album.id();
+                albumForFolder.insert(item.folder, albumId);
+                createdAlbumIds.append(albumId);
+                createdFolders.append(item.folder);
+            }
+
+            albumIds.insert(albumId);
+            if (existingId > 0) {
+                // Enlace: una fila más que apunta al archivo existente
+                pictureDao.copyPictures({ existingId }, albumId, true);
+                ++duplicates;
+                continue;
+            }
+
+            // Posible duplicado que no lo era: no pasó por el hash de la etapa 3
+            if (item.metadata.perceptualHash == 0) {
+                item.metadata.perceptualHash = PerceptualHash::file(item.path);
+            }
+
+            Picture picture(item.path);
+            picture.setMetadata(item.metadata);
+            pictureDao.addPictureInAlbum(albumId, picture);
+            ++imported;
+        }
+
+        if (!database.commit()) {
+            qDebug() << "Importación: error al escribir el lote, se omiten" << batch.count()
+                     << "archivos:" << database.lastError();
+            database.rollback();
+
+            // Los álbumes y carpetas del lote ya no existen
+            for (const QString& folder : std::as_const(createdFolders)) {
+                albumForFolder.remove(folder);
+            }
+            directoryDao.clearCache();
+
+            mSkipped += batch.count();
+            batch.clear();
+            return;
+        }
+
+        mImported += imported;
+        mDuplicates += duplicates;
+        batch.clear();
+        QMetaObject::invokeMethod(this, [this, albumIds, createdAlbumIds] {
+            batchWritten(albumIds, createdAlbumIds);
+        }, Qt::QueuedConnection);
+    };
+
+    Item item;
+    while (!mCancelled && mThumbnailed->pop(item)) {
+        batch.append(std::move(item));
+        GALLERY_METRIC_SET("import.queue.thumbnailed", mThumbnailed->size());
+        if (batch.count() >= IMPORT_BATCH_SIZE) {
+            writeBatch();
+        }
+    }
+    if (!mCancelled && !batch.isEmpty()) {
+        writeBatch();
+    }
+}
+
+/**
+ * Procesa un lote escrito (hilo de la interfaz)
+ * @param albumIds Álbumes con imágenes nuevas
+ * @param createdAlbumIds Álbumes creados en este lote
+ *
+ * Los álbumes nuevos se notifican en el momento; las imágenes nuevas se
+ * acumulan y se notifican como mucho una vez por NOTIFY_INTERVAL_MS, para
+ * no recargar el álbum visible con cada lote.
+ */
+void ImportPipeline::batchWritten(const QSet<int>& albumIds, const QList<int>& createdAlbumIds)
+{
+    for (int albumId : createdAlbumIds) {
+        emit mDb.notifier.albumAdded(albumId);
+    }
+
+    mChangedAlbums.unite(albumIds);
+    if (mNotifyTimer.elapsed() >= NOTIFY_INTERVAL_MS) {
+        flushChangedAlbums();
+    }
+
+    emit progress(mImported + mDuplicates + mSkipped, mDiscovered);
+}
+
+/**
+ * Notifica los álbumes con imágenes nuevas pendientes
+ */
+void ImportPipeline::flushChangedAlbums()
+{
+    for (int albumId : std::as_const(mChangedAlbums)) {
+        emit mDb.notifier.picturesChanged(albumId);
+    }
+    mChangedAlbums.clear();
+    mNotifyTimer.restart();
+}
+
+/**
+ * Termina la importación (hilo de la interfaz)
+ * @param cancelled true si la importación se ha cancelado
+ */
+void ImportPipeline::writerFinished(bool cancelled)
+{
+    // El resto de etapas ya no tienen trabajo: esperar no bloquea la interfaz
+    mPool.waitForDone();
+    mRunning = false;
+
+    flushChangedAlbums();
+    GALLERY_METRIC_ADD("import.files.imported", mImported);
+    GALLERY_METRIC_ADD("import.files.duplicates", mDuplicates);
+    GALLERY_METRIC_ADD("import.files.skipped", mSkipped);
+    emit progress(mImported + mDuplicates + mSkipped, mDiscovered);
+    emit finished(mImported, mDuplicates, cancelled);
+}
@@ -0,0 +1,125 @@
+#ifndef IMPORTPIPELINE_H
+#define IMPORTPIPELINE_H
+
+#include <atomic>
+#include <memory>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include "gallerycore_global.h"
+#include "BoundedQueue.h"
+#include "PictureMetadata.h"
+
+class DatabaseManager;
+class QSqlDatabase;
+
+/**
+ * Opciones de una importación de carpeta
+ */
+struct ImportOptions
+{
+    // Qué hacer con un archivo cuyo contenido ya está en el catálogo
+    enum DuplicatePolicy {
+        LinkDuplicates,     // Añadir al álbum la imagen existente (mismo archivo y thumbnail)
+        SkipDuplicates,     // No importarlo
+        KeepDuplicates,     // Importarlo como una imagen más
+    };
+
+    QString rootPath;               // Carpeta a importar (se recorre recursivamente)
+    int albumId = -1;               // Álbum de destino de los archivos de la carpeta raíz
+    bool albumPerFolder = false;    // Crear un álbum por cada subcarpeta
+    int thumbnailSize = 0;          // Tamaño de los thumbnails a generar (0 = ninguno)
+    DuplicatePolicy duplicates = LinkDuplicates;
+};
+
+/**
+ * Importación de carpetas en segundo plano, por etapas
+ *
+ * recorrido de carpetas -> detección de formato y metadatos -> thumbnails
+ * -> inserción en la base de datos por lotes
+ *
+ * Cada etapa se ejecuta en sus propios hilos y se comunica con la siguiente
+ * mediante una BoundedQueue, de modo que el disco y todos los núcleos
+ * trabajan a la vez sin que una etapa rápida acumule memoria. La escritura
+ * usa su propia conexión a la base de datos (SQLite en modo WAL), así que la
+ * interfaz sigue pudiendo leer el catálogo durante la importación.
+ *
+ * Las señales se emiten en el hilo del objeto (normalmente el de la interfaz).
+ */
+class GALLERYCORE_EXPORT ImportPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImportPipeline(DatabaseManager& database, QObject* parent = nullptr);
+    ~ImportPipeline();
+
+    bool start(const ImportOptions& options);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    // processed incluye los archivos descartados por no ser imágenes
+    void progress(int processed, int discovered);
+    // duplicates: archivos que ya estaban en el catálogo (enlazados u omitidos)
+    void finished(int imported, int duplicates, bool cancelled);
+
+private:
+    struct Item
+    {
+        QString path;
+        QString folder;             // Subcarpeta relativa a la raíz (álbum por carpeta)
+        PictureMetadata metadata;
+        bool duplicateCandidate = false;    // Su tamaño ya está en el catálogo
+    };
+
+    void walkDirectories();
+    void analyzeFiles();
+    void generateThumbnails();
+    void writePictures();
+    void writeBatches(QSqlDatabase& database);
+    void batchWritten(const QSet<int>& albumIds, const QList<int>& createdAlbumIds);
+    void writerFinished(bool cancelled);
+    void flushChangedAlbums();
+
+    DatabaseManager& mDb;
+    ImportOptions mOptions;
+    QThreadPool mPool;
+
+    // Colas entre etapas
+    std::unique_ptr<BoundedQueue<QString>> mFiles;
+    std::unique_ptr<BoundedQueue<Item>> mAnalyzed;
+    std::unique_ptr<BoundedQueue<Item>> mThumbnailed;
+
+    // Tamaños de archivo del catálogo y de esta importación: solo se calcula
+    // el hash de los archivos cuyo tamaño ya se ha visto
+    QMutex mSizesMutex;
+    QSet<qint64> mKnownSizes;
+
+    // Carpetas pendientes de recorrer, compartidas entre los hilos del recorrido
+    QMutex mDirectoryMutex;
+    QWaitCondition mDirectoryAvailable;
+    QQueue<QString> mDirectories;
+    int mPendingDirectories;
+
+    // Hilos activos de cada etapa; el último en terminar cierra la cola siguiente
+    std::atomic<int> mActiveWalkers;
+    std::atomic<int> mActiveAnalyzers;
+    std::atomic<int> mActiveThumbnailers;
+
+    std::atomic<int> mDiscovered;
+    std::atomic<int> mSkipped;
+    std::atomic<int> mImported;
+    std::atomic<int> mDuplicates;
+    std::atomic<bool> mCancelled;
+    bool mRunning;
+
+    // Álbumes con imágenes nuevas aún no notificados (hilo de la interfaz)
+    QSet<int> mChangedAlbums;
+    QElapsedTimer mNotifyTimer;
+};
+
+#endif // IMPORTPIPELINE_H
@@ -0,0 +1,597 @@
+#include "LibraryWatcher.h"
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMultiHash>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+#include <utility>
+#include "DatabaseManager.h"
+#include "MetadataExtractor.h"
+#include "PerceptualHash.h"
+#include "Picture.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+// Tiempo durante el que se acumulan los avisos del sistema de archivos antes
+// de sincronizar (copiar cientos de archivos genera cientos de avisos)
+const int SYNC_DELAY_MS = 500;
+
+/**
+ * Constructor de LibraryWatcher
+ * @param database Catálogo que se sincroniza (debe vivir más que el objeto)
+ * @param parent Objeto padre para la jerarquía de Qt
+ *
+ * No vigila nada hasta que se llama a start().
+ */
+LibraryWatcher::LibraryWatcher(DatabaseManager& database, QObject* parent) :
+    QObject(parent),
+    mDb(database),
+    mSyncing(false)
+{
+    // Una sola sincronización a la vez: los avisos que llegan mientras tanto
+    // se sincronizan en la siguiente
+    mPool.setMaxThreadCount(1);
+
+    mSyncTimer.setSingleShot(true);
+    mSyncTimer.setInterval(SYNC_DELAY_MS);
+    connect(&mSyncTimer, &QTimer::timeout, this, &LibraryWatcher::synchronize);
+
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged,
+            this, &LibraryWatcher::onDirectoryChanged);
+
+    // Al eliminar un álbum se deja de vigilar su carpeta
+    connect(&mDb.notifier, &CatalogNotifier::albumRemoved,
+            this, &LibraryWatcher::onAlbumRemoved);
+
+    // Al reubicar una carpeta cambian las rutas de las carpetas vigiladas
+    connect(&mDb.notifier, &CatalogNotifier::directoriesRelocated,
+            this, &LibraryWatcher::onDirectoriesRelocated);
+}
+
+/**
+ * Destructor de LibraryWatcher
+ * Espera a que termine la sincronización en curso.
+ */
+LibraryWatcher::~LibraryWatcher()
+{
+    mPool.waitForDone();
+}
+
+/**
+ * Empieza a vigilar las carpetas guardadas en el catálogo
+ *
+ * Las carpetas que han cambiado con la aplicación cerrada se sincronizan
+ * poco después, sin bloquear el arranque.
+ */
+void LibraryWatcher::start()
+{
+    for (const WatchedFolder& folder : mDb.directoryDao.watchedFolders()) {
+        mFolders.insert(folder.path, folder.albumId);
+        watchTree(folder.path, false);
+    }
+    scheduleSync();
+}
+
+/**
+ * Empieza a vigilar una carpeta
+ * @param path Carpeta raíz (se vigilan también sus subcarpetas)
+ * @param albumId Álbum al que se añaden los archivos nuevos
+ *
+ * La carpeta se sincroniza completa una vez, para recoger los archivos que
+ * hayan aparecido desde que se importó.
+ */
+void LibraryWatcher::watchFolder(const QString& path, int albumId)
+{
+    QString root = QDir(path).absolutePath();
+
+    WatchedFolder folder;
+    folder.path = root;
+    folder.albumId = albumId;
+    mDb.directoryDao.addWatchedFolder(folder);
+
+    mFolders.insert(root, albumId);
+    watchTree(root, true);
+    scheduleSync();
+}
+
+/**
+ * Deja de vigilar una carpeta
+ * @param path Carpeta raíz vigilada
+ *
+ * Sus imágenes siguen en el catálogo. Las subcarpetas que también estén
+ * dentro de otra carpeta vigilada se siguen vigilando.
+ */
+void LibraryWatcher::unwatchFolder(const QString& path)
+{
+    QString root = QDir(path).absolutePath();
+    if (!mFolders.remove(root)) {
+        return;
+    }
+    mDb.directoryDao.removeWatchedFolder(root);
+
+    QStringList unwatched;
+    for (const QString& directory : std::as_const(mWatchedDirectories)) {
+        if (rootForPath(mFolders, directory).isEmpty()) {
+            unwatched << directory;
+        }
+    }
+    for (const QString& directory : std::as_const(unwatched)) {
+        mWatchedDirectories.remove(directory);
+        mDirtyDirectories.remove(directory);
+    }
+    if (!unwatched.isEmpty()) {
+        mWatcher.removePaths(unwatched);
+    }
+}
+
+/**
+ * Fuerza la sincronización de todas las carpetas vigiladas
+ */
+void LibraryWatcher::rescan()
+{
+    mDirtyDirectories.unite(mWatchedDirectories);
+    scheduleSync();
+}
+
+/**
+ * Retorna las carpetas raíz vigiladas
+ */
+QStringList LibraryWatcher::watchedFolders() const
+{
+    return mFolders.keys();
+}
+
+/**
+ * Registra el cambio de una carpeta y programa la sincronización
+ * @param path Carpeta modificada
+ */
+void LibraryWatcher::onDirectoryChanged(const QString& path)
+{
+    mDirtyDirectories.insert(path);
+    scheduleSync();
+}
+
+/**
+ * Deja de vigilar las carpetas que importaban en un álbum eliminado
+ * @param albumId ID del álbum eliminado
+ */
+void LibraryWatcher::onAlbumRemoved(int albumId)
+{
+    const QStringList roots = mFolders.keys(albumId);
+    for (const QString& root : roots) {
+        unwatchFolder(root);
+    }
+}
+
+/**
+ * Vuelve a vigilar las carpetas después de reubicar una carpeta del catálogo
+ *
+ * DirectoryDao::relocateDirectory() ya ha cambiado las rutas guardadas; se
+ * sustituyen las vigiladas por las nuevas. Si aún no se ha llamado a
+ * start() no hay nada que cambiar.
+ */
+void LibraryWatcher::onDirectoriesRelocated()
+{
+    if (mFolders.isEmpty()) {
+        return;
+    }
+
+    if (!mWatchedDirectories.isEmpty()) {
+        mWatcher.removePaths(QStringList(mWatchedDirectories.cbegin(), mWatchedDirectories.cend()));
+    }
+    mWatchedDirectories.clear();
+    mDirtyDirectories.clear();
+    mFolders.clear();
+    start();
+}
+
+/**
+ * Programa una sincronización si no hay una pendiente
+ *
+ * El temporizador no se reinicia con cada aviso, así que una copia larga se
+ * sincroniza por tramos en lugar de esperar a que termine.
+ */
+void LibraryWatcher::scheduleSync()
+{
+    if (!mDirtyDirectories.isEmpty() && !mSyncTimer.isActive()) {
+        mSyncTimer.start();
+    }
+}
+
+/**
+ * Vigila una carpeta y todas sus subcarpetas
+ * @param root Carpeta raíz
+ * @param markChanged true para sincronizar todas; false para sincronizar solo
+ *                    las que han cambiado desde la última sincronización
+ *
+ * Solo consulta la fecha de modificación de cada carpeta, sin listar sus
+ * archivos ni escribir en el catálogo: las carpetas que aún no están
+ * registradas cuentan como cambiadas.
+ */
+void LibraryWatcher::watchTree(const QString& root, bool markChanged)
+{
+    if (!QFileInfo(root).isDir()) {
+        qCInfo(lcImport) << "Carpeta vigilada no disponible:" << root;
+        return;
+    }
+
+    QStringList directories = { root };
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        directories << it.next();
+    }
+
+    QStringList added;
+    for (const QString& directory : std::as_const(directories)) {
+        if (!mWatchedDirectories.contains(directory)) {
+            mWatchedDirectories.insert(directory);
+            added << directory;
+        }
+
+        bool changed = markChanged;
+        if (!changed) {
+            int directoryId = mDb.directoryDao.findDirectoryId(directory);
+            changed = directoryId < 0
+                      || mDb.directoryDao.scannedAt(directoryId)
+                         != QFileInfo(directory).lastModified().toMSecsSinceEpoch();
+        }
+        if (changed) {
+            mDirtyDirectories.insert(directory);
+        }
+    }
+
+    if (!added.isEmpty()) {
+        mWatcher.addPaths(added);
+    }
+}
+
+/**
+ * Busca la carpeta vigilada que contiene una ruta
+ * @param folders Carpetas raíz vigiladas
+ * @param path Ruta de una carpeta o archivo
+ * @return Carpeta raíz más interna que la contiene, o cadena vacía si no hay ninguna
+ */
+QString LibraryWatcher::rootForPath(const QHash<QString, int>& folders, const QString& path)
+{
+    QString best;
+    for (auto it = folders.cbegin(); it != folders.cend(); ++it) {
+        const QString& root = it.key();
+        if ((path == root || path.startsWith(root + '/')) && root.length() > best.length()) {
+            best = root;
+        }
+    }
+    return best;
+}
+
+/**
+ * Lanza la sincronización de las carpetas modificadas
+ *
+ * Se copia el estado necesario y el trabajo se hace en el hilo de
+ * sincronización; si ya hay una en curso, las carpetas esperan a que termine.
+ */
+void LibraryWatcher::synchronize()
+{
+    if (mSyncing || mDirtyDirectories.isEmpty()) {
+        return;
+    }
+
+    SyncRequest request;
+    request.database = &mDb;
+    request.connectionName = QString("gallery-watcher-%1").arg(reinterpret_cast<quintptr>(this));
+    request.directories = QStringList(mDirtyDirectories.cbegin(), mDirtyDirectories.cend());
+    request.folders = mFolders;
+    request.watchedDirectories = mWatchedDirectories;
+    mDirtyDirectories.clear();
+
+    mSyncing = true;
+    mPool.start([this, request] {
+        SyncResult result = runSynchronization(request);
+        QMetaObject::invokeMethod(this, [this, result] {
+            synchronizationFinished(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+/**
+ * Sincroniza las carpetas con su propia conexión (hilo de sincronización)
+ * @param request Carpetas a sincronizar y copia del estado del vigilante
+ * @return Cambios hechos en el catálogo
+ */
+LibraryWatcher::SyncResult LibraryWatcher::runSynchronization(const SyncRequest& request)
+{
+    GALLERY_TRACE_SCOPE(lcImport, "LibraryWatcher::synchronize");
+    GALLERY_METRIC_TIMER("watcher.sync.us");
+
+    SyncResult result;
+    result.directories = request.directories;
+    {
+        QSqlDatabase database = request.database->openConnection(request.connectionName);
+        if (database.isOpen()) {
+            synchronizeDirectories(database, request, result);
+            database.close();
+        } else {
+            qDebug() << "Sincronización: no se puede abrir la base de datos:" << database.lastError();
+        }
+    }
+    QSqlDatabase::removeDatabase(request.connectionName);
+    return result;
+}
+
+/**
+ * Sincroniza las carpetas modificadas con el catálogo (hilo de sincronización)
+ *
+ * 1. Lista cada carpeta modificada y la compara con sus filas del catálogo
+ *    (una consulta por carpeta): archivos nuevos, modificados y desaparecidos.
+ *    Las subcarpetas nuevas se vigilan y se listan en la misma pasada.
+ * 2. Empareja los desaparecidos con los nuevos por inodo: son renombrados o
+ *    movidos, y solo cambia su ruta.
+ * 3. Importa los nuevos que quedan y elimina los desaparecidos que quedan.
+ *
+ * Todo se escribe en una transacción; result solo se marca como confirmado
+ * si la transacción se confirma.
+ *
+ * @param database Conexión propia del hilo, ya abierta
+ * @param request Carpetas a sincronizar y copia del estado del vigilante
+ * @param result Cambios hechos en el catálogo
+ */
+void LibraryWatcher::synchronizeDirectories(QSqlDatabase& database, const SyncRequest& request,
+                                            SyncResult& result)
+{
+    DirectoryDao directoryDao(database);
+    PictureDao pictureDao(database, directoryDao);
+
+    QStringList directories = request.directories;
+    QSet<QString> watchedDirectories = request.watchedDirectories;
+    QSet<int> listedDirectories;
+    QVector<NewFile> newFiles;
+    QVector<MissingFile> missingFiles;
+
+    database.transaction();
+
+    // La lista crece con las subcarpetas nuevas
+    for (int i = 0; i < directories.count(); ++i) {
+        const QString directory = directories.at(i);
+        QDir dir(directory);
+
+        // Carpeta borrada o renombrada: todas sus imágenes (y las de sus
+        // subcarpetas) han desaparecido, salvo que aparezcan en otro sitio
+        if (!dir.exists()) {
+            for (int directoryId : directoryDao.directoryIdsUnder(directory)) {
+                if (listedDirectories.contains(directoryId)) {
+                    continue;
+                }
+                listedDirectories.insert(directoryId);
+                for (PictureFile& file : pictureDao.filesInDirectory(directoryId)) {
+                    missingFiles.append({ directoryId, std::move(file) });
+                }
+            }
+            for (auto it = watchedDirectories.begin(); it != watchedDirectories.end();) {
+                if (*it == directory || it->startsWith(directory + '/')) {
+                    it = watchedDirectories.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            result.vanishedDirectories << directory;
+            continue;
+        }
+
+        int directoryId = directoryDao.directoryIdForPath(directory);
+        if (listedDirectories.contains(directoryId)) {
+            continue;
+        }
+        listedDirectories.insert(directoryId);
+
+        // Subcarpetas nuevas: se vigilan y se listan en esta misma pasada
+        const QFileInfoList subdirectories =
+            dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        for (const QFileInfo& info : subdirectories) {
+            QString subdirectory = info.absoluteFilePath();
+            if (!watchedDirectories.contains(subdirectory)) {
+                watchedDirectories.insert(subdirectory);
+                result.newDirectories << subdirectory;
+                directories << subdirectory;
+            }
+        }
+
+        // Archivos del catálogo en esta carpeta, por nombre
+        QHash<QString, PictureFile> known;
+        for (PictureFile& file : pictureDao.filesInDirectory(directoryId)) {
+            known.insert(file.name, std::move(file));
+        }
+
+        const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::NoSymLinks);
+        for (const QFileInfo& info : entries) {
+            qint64 modifiedAt = info.lastModified().toSecsSinceEpoch();
+            auto it = known.find(info.fileName());
+
+            if (it == known.end()) {
+                newFiles.append({ directoryId, info.fileName(), info.absoluteFilePath(),
+                                  MetadataExtractor::fileId(info.absoluteFilePath()),
+                                  info.size(), modifiedAt });
+                continue;
+            }
+
+            if (it->byteSize != info.size() || it->modifiedAt != modifiedAt) {
+                // El contenido ha cambiado: también su hash perceptual
+                PictureMetadata metadata = MetadataExtractor::extract(info.absoluteFilePath());
+                metadata.perceptualHash = PerceptualHash::file(info.absoluteFilePath());
+                if (pictureDao.updateFileMetadata(directoryId, it->name, metadata)) {
+                    result.modifiedPaths << info.absoluteFilePath();
+                    for (int albumId : std::as_const(it->albumIds)) {
+                        result.changedAlbums.insert(albumId);
+                    }
+                    ++result.modified;
+                }
+            }
+            known.erase(it);
+        }
+
+        for (PictureFile& file : known) {
+            missingFiles.append({ directoryId, std::move(file) });
+        }
+
+        directoryDao.setScannedAt(directoryId,
+                                  QFileInfo(directory).lastModified().toMSecsSinceEpoch());
+    }
+
+    // Índices de los archivos desaparecidos por inodo y por tamaño + fecha
+    QHash<quint64, int> missingById;
+    QMultiHash<QPair<qint64, qint64>, int> missingBySignature;
+    for (int i = 0; i < missingFiles.count(); ++i) {
+        const PictureFile& file = missingFiles.at(i).file;
+        if (file.fileId) {
+            missingById.insert(file.fileId, i);
+        }
+        missingBySignature.insert(qMakePair(file.byteSize, file.modifiedAt), i);
+    }
+    QVector<bool> matched(missingFiles.count(), false);
+
+    for (const NewFile& file : std::as_const(newFiles)) {
+        // Renombrado o movido: mismo inodo y mismo tamaño
+        int index = -1;
+        if (file.fileId) {
+            auto it = missingById.constFind(file.fileId);
+            if (it != missingById.cend() && !matched.at(*it)
+                && missingFiles.at(*it).file.byteSize == file.byteSize) {
+                index = *it;
+            }
+        }
+
+        // Sin inodo (o movido a otro volumen): mismo tamaño, fecha y extensión
+        if (index < 0) {
+            QString suffix = QFileInfo(file.name).suffix().toLower();
+            const QList<int> candidates =
+                missingBySignature.values(qMakePair(file.byteSize, file.modifiedAt));
+            for (int candidate : candidates) {
+                if (!matched.at(candidate)
+                    && QFileInfo(missingFiles.at(candidate).file.name).suffix().toLower() == suffix) {
+                    index = candidate;
+                    break;
+                }
+            }
+        }
+
+        if (index >= 0) {
+            matched[index] = true;
+            const MissingFile& missing = missingFiles.at(index);
+            if (pictureDao.relocateFile(missing.directoryId, missing.file.name,
+                                        file.directoryId, file.name)) {
+                for (int albumId : missing.file.albumIds) {
+                    result.changedAlbums.insert(albumId);
+                }
+                ++result.moved;
+            }
+            continue;
+        }
+
+        // Archivo nuevo: solo se importan las imágenes (formato detectado por contenido)
+        QImageReader reader(file.path);
+        reader.setDecideFormatFromContent(true);
+        if (!reader.canRead()) {
+            continue;
+        }
+
+        int albumId = pictureDao.albumForDirectory(file.directoryId);
+        if (albumId <= 0) {
+            albumId = request.folders.value(rootForPath(request.folders, file.path), -1);
+        }
+        if (albumId <= 0) {
+            continue;
+        }
+
+        PictureMetadata metadata = MetadataExtractor::extract(file.path);
+        metadata.perceptualHash = PerceptualHash::file(file.path);
+        Picture picture(file.path);
+        picture.setMetadata(metadata);
+        pictureDao.addPictureInAlbum(albumId, picture);
+        if (picture.id() > 0) {
+            result.changedAlbums.insert(albumId);
+            ++result.added;
+        }
+    }
+
+    // Desaparecidos que no se han encontrado en otro sitio: borrados
+    for (int i = 0; i < missingFiles.count(); ++i) {
+        if (matched.at(i)) {
+            continue;
+        }
+        const MissingFile& missing = missingFiles.at(i);
+        if (pictureDao.removeFile(missing.directoryId, missing.file.name)) {
+            for (int albumId : missing.file.albumIds) {
+                result.changedAlbums.insert(albumId);
+            }
+            ++result.removed;
+        }
+    }
+
+    if (!database.commit()) {
+        qDebug() << "Error al sincronizar las carpetas vigiladas:" << database.lastError();
+        database.rollback();
+        return;
+    }
+    result.committed = true;
+}
+
+/**
+ * Aplica el resultado de una sincronización (hilo de la interfaz)
+ * @param result Cambios hechos en el catálogo
+ *
+ * Si la transacción no se ha confirmado, las carpetas vuelven a quedar
+ * pendientes y se reintentan en la siguiente sincronización.
+ */
+void LibraryWatcher::synchronizationFinished(const SyncResult& result)
+{
+    mSyncing = false;
+
+    if (!result.committed) {
+        for (const QString& directory : result.directories) {
+            if (!rootForPath(mFolders, directory).isEmpty()) {
+                mDirtyDirectories.insert(directory);
+            }
+        }
+        scheduleSync();
+        return;
+    }
+
+    // Carpetas desaparecidas y subcarpetas nuevas, salvo las de carpetas que
+    // se han dejado de vigilar durante la sincronización
+    for (const QString& directory : result.vanishedDirectories) {
+        for (auto it = mWatchedDirectories.begin(); it != mWatchedDirectories.end();) {
+            if (*it == directory || it->startsWith(directory + '/')) {
+                it = mWatchedDirectories.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    QStringList added;
+    for (const QString& directory : result.newDirectories) {
+        if (!mWatchedDirectories.contains(directory) && !rootForPath(mFolders, directory).isEmpty()) {
+            mWatchedDirectories.insert(directory);
+            added << directory;
+        }
+    }
+    if (!added.isEmpty()) {
+        mWatcher.addPaths(added);
+    }
+
+    if (!result.modifiedPaths.isEmpty()) {
+        emit mDb.notifier.filesModified(result.modifiedPaths);
+    }
+    for (int albumId : result.changedAlbums) {
+        emit mDb.notifier.picturesChanged(albumId);
+    }
+    if (result.added || result.modified || result.moved || result.removed) {
+        emit synchronized(result.added, result.modified, result.moved, result.removed);
+    }
+
+    // Avisos recibidos mientras se sincronizaba
+    scheduleSync();
+}
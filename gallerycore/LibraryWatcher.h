@@ -0,0 +1,128 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include "gallerycore_global.h"
+#include "PictureDao.h"
+
+class DatabaseManager;
+class QSqlDatabase;
+
+/**
+ * Sincronización incremental de las carpetas vigiladas con el catálogo
+ *
+ * Vigila cada carpeta (y sus subcarpetas) con QFileSystemWatcher. Los avisos
+ * se acumulan durante SYNC_DELAY_MS y después solo se vuelven a listar las
+ * carpetas que han cambiado:
+ * - archivo nuevo: se importa en el álbum de sus vecinos (o el de la carpeta)
+ * - archivo modificado: se vuelven a leer sus metadatos y su hash perceptual
+ *   y se invalida su thumbnail
+ * - archivo borrado: se elimina del catálogo
+ * - archivo renombrado o movido: se reconoce por su inodo (o, si no se
+ *   conoce, por tamaño, fecha y extensión) y solo se actualiza su ruta,
+ *   conservando su ID, sus álbumes y su thumbnail
+ *
+ * Al arrancar solo se listan las carpetas cuya fecha de modificación ha
+ * cambiado desde la última sincronización; rescan() fuerza un recorrido
+ * completo (por ejemplo, para detectar archivos sobrescritos con la
+ * aplicación cerrada, que no cambian la fecha de su carpeta).
+ *
+ * La sincronización (listar carpetas, leer metadatos y escribir en el
+ * catálogo) se hace en un hilo con su propia conexión; las señales se
+ * emiten en el hilo de la interfaz cuando termina.
+ */
+class GALLERYCORE_EXPORT LibraryWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LibraryWatcher(DatabaseManager& database, QObject* parent = nullptr);
+    ~LibraryWatcher();
+
+    void start();
+    void watchFolder(const QString& path, int albumId);
+    void unwatchFolder(const QString& path);
+    void rescan();
+    QStringList watchedFolders() const;
+
+signals:
+    void synchronized(int added, int modified, int moved, int removed);
+
+private slots:
+    void onDirectoryChanged(const QString& path);
+    void onAlbumRemoved(int albumId);
+    void onDirectoriesRelocated();
+    void synchronize();
+
+private:
+    // Archivo en disco que no está en el catálogo
+    struct NewFile
+    {
+        int directoryId;
+        QString name;
+        QString path;
+        quint64 fileId;
+        qint64 byteSize;
+        qint64 modifiedAt;
+    };
+
+    // Archivo del catálogo que ya no está en disco
+    struct MissingFile
+    {
+        int directoryId;
+        PictureFile file;
+    };
+
+    // Copia del estado del vigilante con la que trabaja el hilo de sincronización
+    struct SyncRequest
+    {
+        const DatabaseManager* database = nullptr;
+        QString connectionName;
+        QStringList directories;
+        QHash<QString, int> folders;
+        QSet<QString> watchedDirectories;
+    };
+
+    // Resultado de una sincronización, que se aplica en el hilo de la interfaz
+    struct SyncResult
+    {
+        bool committed = false;
+        QStringList directories;
+        QStringList newDirectories;
+        QStringList vanishedDirectories;
+        QStringList modifiedPaths;
+        QSet<int> changedAlbums;
+        int added = 0;
+        int modified = 0;
+        int moved = 0;
+        int removed = 0;
+    };
+
+    void watchTree(const QString& root, bool markChanged);
+    static QString rootForPath(const QHash<QString, int>& folders, const QString& path);
+    void scheduleSync();
+    static SyncResult runSynchronization(const SyncRequest& request);
+    static void synchronizeDirectories(QSqlDatabase& database, const SyncRequest& request,
+                                       SyncResult& result);
+    void synchronizationFinished(const SyncResult& result);
+
+    DatabaseManager& mDb;
+    QFileSystemWatcher mWatcher;
+    QTimer mSyncTimer;
+    QThreadPool mPool;
+    bool mSyncing;
+
+    // Carpeta raíz vigilada -> álbum de destino
+    QHash<QString, int> mFolders;
+
+    // Carpetas vigiladas (raíces y subcarpetas) y carpetas pendientes de sincronizar
+    QSet<QString> mWatchedDirectories;
+    QSet<QString> mDirtyDirectories;
+};
+
+#endif // LIBRARYWATCHER_H
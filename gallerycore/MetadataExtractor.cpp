@@ -0,0 +1,264 @@
+#include "MetadataExtractor.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMimeDatabase>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+// Bytes leídos de la cabecera del archivo para buscar el bloque EXIF
+// (el segmento APP1 está limitado a 64 KB y suele ir al principio del JPEG)
+const qint64 EXIF_HEADER_SIZE = 128 * 1024;
+
+// Etiquetas TIFF/EXIF utilizadas
+const quint16 EXIF_TAG_DATETIME = 0x0132;
+const quint16 EXIF_TAG_EXIF_IFD = 0x8769;
+const quint16 EXIF_TAG_DATETIME_ORIGINAL = 0x9003;
+const quint16 EXIF_TYPE_ASCII = 2;
+
+namespace {
+
+/**
+ * Lector mínimo de estructuras TIFF con control de límites
+ * Respeta el orden de bytes declarado en la cabecera ("II" o "MM")
+ */
+class TiffReader
+{
+public:
+    TiffReader(const char* data, int size, bool littleEndian) :
+        mData(reinterpret_cast<const uchar*>(data)),
+        mSize(size),
+        mLittleEndian(littleEndian)
+    {
+    }
+
+    bool contains(qint64 offset, qint64 length) const
+    {
+        return offset >= 0 && length >= 0 && offset + length <= mSize;
+    }
+
+    quint16 u16(qint64 offset) const
+    {
+        const uchar* p = mData + offset;
+        return mLittleEndian ? quint16(p[0] | (p[1] << 8))
+                             : quint16((p[0] << 8) | p[1]);
+    }
+
+    quint32 u32(qint64 offset) const
+    {
+        const uchar* p = mData + offset;
+        return mLittleEndian
+            ? quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24)
+            : (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+    }
+
+    /**
+     * Busca una etiqueta dentro de un IFD
+     * @return Offset de la entrada de 12 bytes, o -1 si no existe
+     */
+    qint64 findTag(qint64 ifdOffset, quint16 tag) const
+    {
+        if (!contains(ifdOffset, 2)) {
+            return -1;
+        }
+        int count = u16(ifdOffset);
+        for (int i = 0; i < count; ++i) {
+            qint64 entry = ifdOffset + 2 + i * 12;
+            if (!contains(entry, 12)) {
+                return -1;
+            }
+            if (u16(entry) == tag) {
+                return entry;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Lee una fecha EXIF ("yyyy:MM:dd HH:mm:ss") de una entrada ASCII
+     * @return Segundos desde epoch, o 0 si la entrada no es válida
+     *
+     * EXIF no guarda la zona horaria: la hora de la cámara se interpreta
+     * como UTC, así que el valor no depende de la zona del equipo que importa.
+     */
+    qint64 dateTime(qint64 entry) const
+    {
+        if (entry < 0 || u16(entry + 2) != EXIF_TYPE_ASCII) {
+            return 0;
+        }
+        quint32 length = u32(entry + 4);
+        qint64 valueOffset = length <= 4 ? entry + 8 : u32(entry + 8);
+        if (length < 19 || !contains(valueOffset, 19)) {
+            return 0;
+        }
+        QString text = QString::fromLatin1(reinterpret_cast<const char*>(mData + valueOffset), 19);
+        QDate date = QDate::fromString(text.left(10), "yyyy:MM:dd");
+        QTime time = QTime::fromString(text.mid(11), "HH:mm:ss");
+        if (!date.isValid() || !time.isValid()) {
+            return 0;
+        }
+        return QDateTime(date, time, Qt::UTC).toSecsSinceEpoch();
+    }
+
+private:
+    const uchar* mData;
+    qint64 mSize;
+    bool mLittleEndian;
+};
+
+}
+
+/**
+ * Extrae los metadatos de un archivo de imagen
+ * @param localPath Ruta local del archivo
+ * @return PictureMetadata con los datos encontrados (campos a 0 si no se pueden leer)
+ *
+ * Solo lee cabeceras: QImageReader::size() no decodifica los píxeles y el
+ * bloque EXIF se busca en los primeros KB del archivo. El tipo MIME se
+ * detecta por extensión y contenido con QMimeDatabase.
+ */
+PictureMetadata MetadataExtractor::extract(const QString& localPath)
+{
+    PictureMetadata metadata;
+
+    QFileInfo fileInfo(localPath);
+    if (!fileInfo.isFile()) {
+        return metadata;
+    }
+
+    metadata.byteSize = fileInfo.size();
+    const QDateTime lastModified = fileInfo.lastModified();
+    metadata.modifiedAt = lastModified.toSecsSinceEpoch();
+    metadata.fileId = fileId(localPath);
+
+    static const QMimeDatabase mimeDatabase;
+    metadata.mimeType = mimeDatabase.mimeTypeForFile(fileInfo).name();
+
+    // Dimensiones leídas de la cabecera, sin decodificar la imagen
+    QImageReader reader(localPath);
+    QSize size = reader.size();
+    if (size.isValid()) {
+        metadata.width = size.width();
+        metadata.height = size.height();
+    }
+
+    // Fecha de captura EXIF (solo JPEG); si no existe se usa la de
+    // modificación en hora local, con la misma convención que EXIF
+    if (metadata.mimeType == "image/jpeg") {
+        QFile file(localPath);
+        if (file.open(QIODevice::ReadOnly)) {
+            metadata.takenAt = exifCaptureTime(file.read(EXIF_HEADER_SIZE));
+        }
+    }
+    if (metadata.takenAt <= 0) {
+        metadata.takenAt = metadata.modifiedAt + lastModified.offsetFromUtc();
+    }
+
+    return metadata;
+}
+
+/**
+ * Obtiene la identidad de un archivo en su volumen
+ * @param localPath Ruta local del archivo
+ * @return Número de inodo (Unix) o índice de archivo (NTFS), o 0 si no se puede obtener
+ *
+ * La identidad no cambia al renombrar o mover el archivo dentro del mismo
+ * volumen, así que permite reconocer un archivo movido sin leer su contenido.
+ */
+quint64 MetadataExtractor::fileId(const QString& localPath)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(localPath.utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+    return ok ? (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow : 0;
+#elif defined(Q_OS_UNIX)
+    struct stat info;
+    if (::stat(QFile::encodeName(localPath).constData(), &info) != 0) {
+        return 0;
+    }
+    return quint64(info.st_ino);
+#else
+    Q_UNUSED(localPath)
+    return 0;
+#endif
+}
+
+/**
+ * Busca la fecha de captura en la cabecera de un JPEG
+ * @param header Primeros bytes del archivo JPEG
+ * @return Segundos desde epoch de DateTimeOriginal (o DateTime), o 0 si no hay EXIF
+ *
+ * Recorre los segmentos del JPEG hasta encontrar APP1 "Exif", y dentro de la
+ * estructura TIFF sigue el puntero al sub-IFD EXIF para leer la etiqueta 0x9003.
+ */
+qint64 MetadataExtractor::exifCaptureTime(const QByteArray& header)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(header.constData());
+    const qint64 size = header.size();
+
+    // Marcador SOI del JPEG
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return 0;
+    }
+
+    qint64 pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) {
+            return 0;
+        }
+        uchar marker = data[pos + 1];
+        qint64 segmentLength = (data[pos + 2] << 8) | data[pos + 3];
+
+        // SOS: a partir de aquí empiezan los datos comprimidos
+        if (marker == 0xDA || segmentLength < 2) {
+            return 0;
+        }
+
+        qint64 payload = pos + 4;
+        qint64 payloadLength = segmentLength - 2;
+        if (marker == 0xE1 && payloadLength > 14 && payload + payloadLength <= size
+            && header.mid(payload, 6) == QByteArray("Exif\0\0", 6)) {
+
+            qint64 tiffStart = payload + 6;
+            qint64 tiffLength = payloadLength - 6;
+            const char* tiff = header.constData() + tiffStart;
+
+            bool littleEndian = tiff[0] == 'I' && tiff[1] == 'I';
+            if (!littleEndian && !(tiff[0] == 'M' && tiff[1] == 'M')) {
+                return 0;
+            }
+
+            TiffReader reader(tiff, int(tiffLength), littleEndian);
+            if (reader.u16(2) != 42) {
+                return 0;
+            }
+
+            qint64 ifd0 = reader.u32(4);
+            qint64 exifEntry = reader.findTag(ifd0, EXIF_TAG_EXIF_IFD);
+            if (exifEntry >= 0) {
+                qint64 taken = reader.dateTime(
+                    reader.findTag(reader.u32(exifEntry + 8), EXIF_TAG_DATETIME_ORIGINAL));
+                if (taken > 0) {
+                    return taken;
+                }
+            }
+            return reader.dateTime(reader.findTag(ifd0, EXIF_TAG_DATETIME));
+        }
+
+        pos += 2 + segmentLength;
+    }
+
+    return 0;
+}
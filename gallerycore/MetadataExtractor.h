@@ -0,0 +1,20 @@
+#ifndef METADATAEXTRACTOR_H
+#define METADATAEXTRACTOR_H
+
+#include <QByteArray>
+#include <QString>
+#include "gallerycore_global.h"
+#include "PictureMetadata.h"
+
+class GALLERYCORE_EXPORT MetadataExtractor
+{
+public:
+    static PictureMetadata extract(const QString& localPath);
+    static qint64 exifCaptureTime(const QByteArray& header);
+    static quint64 fileId(const QString& localPath);
+
+private:
+    MetadataExtractor() = delete;
+};
+
+#endif // METADATAEXTRACTOR_H
@@ -0,0 +1,189 @@
+#include "Metrics.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QTimer>
+
+// Intervalo por defecto del volcado periódico (GALLERY_METRICS_INTERVAL)
+const int DEFAULT_DUMP_INTERVAL_S = 60;
+
+/**
+ * Límite superior (incluido) de los valores de un cubo del histograma
+ */
+qint64 MetricHistogram::bucketUpperBound(int index)
+{
+    if (index < 16) {
+        return index;
+    }
+    const int exponent = (index - 16) / 16 + 4;
+    const int subBucket = (index - 16) % 16;
+    const qint64 lower = qint64(16 + subBucket) << (exponent - 4);
+    return lower + (qint64(1) << (exponent - 4)) - 1;
+}
+
+/**
+ * Calcula un percentil de los valores registrados
+ * @param percent Percentil, de 0 a 100 (por ejemplo 99.9)
+ * @return Límite superior del cubo que lo contiene (nunca mayor que el
+ *         máximo registrado), o 0 si no hay valores
+ */
+qint64 MetricHistogram::percentile(double percent) const
+{
+    const qint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    const qint64 target = qMax<qint64>(1, qint64(total * qBound(0.0, percent, 100.0) / 100.0 + 0.5));
+    qint64 seen = 0;
+    for (int index = 0; index < BUCKET_COUNT; ++index) {
+        seen += mBuckets[index].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return qMin(bucketUpperBound(index), max());
+        }
+    }
+    return max();
+}
+
+/**
+ * Retorna el registro único de métricas
+ */
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+/**
+ * Obtiene un contador, creándolo si no existe
+ * @param name Nombre de la métrica, por ejemplo "thumbnails.memory.hits"
+ * @return Referencia válida durante toda la ejecución
+ */
+MetricCounter& Metrics::counter(const QString& name)
+{
+    QMutexLocker locker(&mMutex);
+    std::unique_ptr<MetricCounter>& metric = mCounters[name];
+    if (!metric) {
+        metric = std::make_unique<MetricCounter>();
+    }
+    return *metric;
+}
+
+/**
+ * Obtiene un indicador, creándolo si no existe
+ */
+MetricGauge& Metrics::gauge(const QString& name)
+{
+    QMutexLocker locker(&mMutex);
+    std::unique_ptr<MetricGauge>& metric = mGauges[name];
+    if (!metric) {
+        metric = std::make_unique<MetricGauge>();
+    }
+    return *metric;
+}
+
+/**
+ * Obtiene un histograma, creándolo si no existe
+ */
+MetricHistogram& Metrics::histogram(const QString& name)
+{
+    QMutexLocker locker(&mMutex);
+    std::unique_ptr<MetricHistogram>& metric = mHistograms[name];
+    if (!metric) {
+        metric = std::make_unique<MetricHistogram>();
+    }
+    return *metric;
+}
+
+/**
+ * Instantánea de todas las métricas
+ * @return Objeto con "counters", "gauges" e "histograms"; cada histograma
+ *         incluye count, mean, p50, p90, p99, p999 y max
+ */
+QJsonObject Metrics::toJson() const
+{
+    QMutexLocker locker(&mMutex);
+
+    QJsonObject counters;
+    for (const auto& entry : mCounters) {
+        counters.insert(entry.first, entry.second->value());
+    }
+
+    QJsonObject gauges;
+    for (const auto& entry : mGauges) {
+        gauges.insert(entry.first, entry.second->value());
+    }
+
+    QJsonObject histograms;
+    for (const auto& entry : mHistograms) {
+        const MetricHistogram& histogram = *entry.second;
+        const qint64 count = histogram.count();
+        QJsonObject values;
+        values.insert("count", count);
+        values.insert("mean", count ? double(histogram.sum()) / count : 0.0);
+        values.insert("p50", histogram.percentile(50));
+        values.insert("p90", histogram.percentile(90));
+        values.insert("p99", histogram.percentile(99));
+        values.insert("p999", histogram.percentile(99.9));
+        values.insert("max", histogram.max());
+        histograms.insert(entry.first, values);
+    }
+
+    QJsonObject json;
+    json.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    json.insert("counters", counters);
+    json.insert("gauges", gauges);
+    json.insert("histograms", histograms);
+    return json;
+}
+
+/**
+ * Escribe la instantánea de las métricas en un archivo JSON
+ * @return false si no se ha podido escribir
+ */
+bool Metrics::writeJson(const QString& filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pueden escribir las métricas en" << filePath;
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    return file.commit();
+}
+
+/**
+ * Activa el volcado periódico si la variable GALLERY_METRICS indica un archivo
+ * @return true si se ha activado
+ *
+ * El archivo se reescribe cada GALLERY_METRICS_INTERVAL segundos y al
+ * destruir la QCoreApplication, que debe existir ya.
+ */
+bool Metrics::startFromEnvironment()
+{
+    static QString filePath;
+    if (!filePath.isEmpty() || !QCoreApplication::instance()) {
+        return false;
+    }
+    filePath = qEnvironmentVariable("GALLERY_METRICS");
+    if (filePath.isEmpty()) {
+        return false;
+    }
+
+    bool ok = false;
+    int interval = qEnvironmentVariableIntValue("GALLERY_METRICS_INTERVAL", &ok);
+    if (!ok || interval <= 0) {
+        interval = DEFAULT_DUMP_INTERVAL_S;
+    }
+
+    QTimer* timer = new QTimer(QCoreApplication::instance());
+    QObject::connect(timer, &QTimer::timeout, [] {
+        Metrics::instance().writeJson(filePath);
+    });
+    timer->start(interval * 1000);
+
+    qAddPostRoutine([] { Metrics::instance().writeJson(filePath); });
+    return true;
+}
@@ -0,0 +1,178 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include "gallerycore_global.h"
+
+/**
+ * Contador que solo crece (aciertos de caché, archivos importados...)
+ */
+class MetricCounter
+{
+public:
+    void add(qint64 amount = 1) { mValue.fetch_add(amount, std::memory_order_relaxed); }
+    qint64 value() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> mValue { 0 };
+};
+
+/**
+ * Valor instantáneo (memoria de una caché, elementos en una cola...)
+ */
+class MetricGauge
+{
+public:
+    void set(qint64 value) { mValue.store(value, std::memory_order_relaxed); }
+    void add(qint64 amount) { mValue.fetch_add(amount, std::memory_order_relaxed); }
+    qint64 value() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> mValue { 0 };
+};
+
+/**
+ * Histograma de latencias con precisión relativa fija (al estilo HDR)
+ *
+ * Los valores menores que 16 tienen un cubo cada uno; a partir de ahí cada
+ * potencia de dos se divide en 16 cubos, así que el error de un percentil
+ * es como mucho del 6 % tanto para 20 µs como para 20 s. Son 960 contadores
+ * atómicos: registrar un valor no bloquea y cuesta unos pocos ns.
+ */
+class GALLERYCORE_EXPORT MetricHistogram
+{
+public:
+    static const int BUCKET_COUNT = 16 + 59 * 16;
+
+    void record(qint64 value)
+    {
+        value = qMax<qint64>(0, value);
+        mBuckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value, std::memory_order_relaxed);
+
+        qint64 max = mMax.load(std::memory_order_relaxed);
+        while (value > max && !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    qint64 count() const { return mCount.load(std::memory_order_relaxed); }
+    qint64 sum() const { return mSum.load(std::memory_order_relaxed); }
+    qint64 max() const { return mMax.load(std::memory_order_relaxed); }
+    qint64 percentile(double percent) const;
+
+private:
+    static int bucketIndex(qint64 value)
+    {
+        if (value < 16) {
+            return int(value);
+        }
+        const int exponent = 63 - qCountLeadingZeroBits(quint64(value));
+        const int subBucket = int(value >> (exponent - 4)) & 15;
+        return 16 + (exponent - 4) * 16 + subBucket;
+    }
+    static qint64 bucketUpperBound(int index);
+
+    std::atomic<qint64> mBuckets[BUCKET_COUNT] = {};
+    std::atomic<qint64> mCount { 0 };
+    std::atomic<qint64> mSum { 0 };
+    std::atomic<qint64> mMax { 0 };
+};
+
+/**
+ * Registro de métricas de la aplicación
+ *
+ * Las métricas se crean la primera vez que se piden por su nombre y viven
+ * hasta el final del proceso, así que cada punto de medida guarda una
+ * referencia en una variable estática (ver las macros GALLERY_METRIC_*) y
+ * solo consulta el registro una vez. Los nombres de las latencias terminan
+ * en ".us" (microsegundos) y los de memoria en ".kb".
+ *
+ * toJson() da una instantánea de todas las métricas; con la variable de
+ * entorno GALLERY_METRICS=<archivo.json> se vuelcan periódicamente (cada
+ * GALLERY_METRICS_INTERVAL segundos, 60 por defecto) y al salir.
+ */
+class GALLERYCORE_EXPORT Metrics
+{
+public:
+    static Metrics& instance();
+
+    MetricCounter& counter(const QString& name);
+    MetricGauge& gauge(const QString& name);
+    MetricHistogram& histogram(const QString& name);
+
+    QJsonObject toJson() const;
+    bool writeJson(const QString& filePath) const;
+    bool startFromEnvironment();
+
+private:
+    Metrics() = default;
+
+    mutable QMutex mMutex;
+    std::map<QString, std::unique_ptr<MetricCounter>> mCounters;
+    std::map<QString, std::unique_ptr<MetricGauge>> mGauges;
+    std::map<QString, std::unique_ptr<MetricHistogram>> mHistograms;
+};
+
+/**
+ * Mide el tiempo desde su construcción hasta su destrucción, en µs
+ */
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricHistogram& histogram) :
+        mHistogram(histogram)
+    {
+        mTimer.start();
+    }
+
+    ~MetricTimer()
+    {
+        mHistogram.record(mTimer.nsecsElapsed() / 1000);
+    }
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+private:
+    MetricHistogram& mHistogram;
+    QElapsedTimer mTimer;
+};
+
+#define GALLERY_METRIC_CONCAT_(a, b) a##b
+#define GALLERY_METRIC_CONCAT(a, b) GALLERY_METRIC_CONCAT_(a, b)
+
+// Registra la duración del bloque en el histograma indicado
+#define GALLERY_METRIC_TIMER(name) \
+    static MetricHistogram& GALLERY_METRIC_CONCAT(metricHistogram_, __LINE__) = \
+        Metrics::instance().histogram(name); \
+    MetricTimer GALLERY_METRIC_CONCAT(metricTimer_, __LINE__)(GALLERY_METRIC_CONCAT(metricHistogram_, __LINE__))
+
+// Suma una cantidad a un contador
+#define GALLERY_METRIC_ADD(name, amount) \
+    do { \
+        static MetricCounter& metricCounter = Metrics::instance().counter(name); \
+        metricCounter.add(amount); \
+    } while (0)
+
+// Fija el valor de un indicador
+#define GALLERY_METRIC_SET(name, value) \
+    do { \
+        static MetricGauge& metricGauge = Metrics::instance().gauge(name); \
+        metricGauge.set(value); \
+    } while (0)
+
+// Registra un valor en un histograma
+#define GALLERY_METRIC_RECORD(name, value) \
+    do { \
+        static MetricHistogram& metricHistogram = Metrics::instance().histogram(name); \
+        metricHistogram.record(value); \
+    } while (0)
+
+#endif // METRICS_H
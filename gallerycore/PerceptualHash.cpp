@@ -0,0 +1,62 @@
+#include "PerceptualHash.h"
+#include <QImageReader>
+
+// Tamaño de la imagen reducida: 9 columnas dan 8 diferencias por fila
+const int HASH_WIDTH = 9;
+const int HASH_HEIGHT = 8;
+
+// Tamaño al que se decodifica un archivo sin thumbnail antes de reducirlo
+const int HASH_SOURCE_SIZE = 64;
+
+/**
+ * Calcula el dHash de una imagen
+ * @param source Imagen (normalmente el thumbnail)
+ * @return Hash de 64 bits, o 0 si la imagen es nula
+ *
+ * La reducción suavizada promedia los píxeles de cada celda, así que el
+ * resultado apenas depende del tamaño de la imagen de partida.
+ */
+quint64 PerceptualHash::image(const QImage& source)
+{
+    if (source.isNull()) {
+        return 0;
+    }
+
+    const QImage small = source.scaled(HASH_WIDTH, HASH_HEIGHT, Qt::IgnoreAspectRatio,
+                                       Qt::SmoothTransformation)
+                             .convertToFormat(QImage::Format_Grayscale8);
+
+    quint64 hash = 0;
+    for (int y = 0; y < HASH_HEIGHT; ++y) {
+        const uchar* line = small.constScanLine(y);
+        for (int x = 0; x < HASH_WIDTH - 1; ++x) {
+            hash = (hash << 1) | (line[x] > line[x + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+/**
+ * Calcula el dHash de un archivo que no tiene thumbnail a mano
+ * @param localPath Ruta local de la imagen
+ * @return Hash de 64 bits, o 0 si el archivo no se puede leer
+ *
+ * Decodifica directamente a tamaño reducido (ver ThumbnailCache::generate).
+ */
+quint64 PerceptualHash::file(const QString& localPath)
+{
+    QImageReader reader(localPath);
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > HASH_SOURCE_SIZE || size.height() > HASH_SOURCE_SIZE)) {
+        reader.setScaledSize(size.scaled(HASH_SOURCE_SIZE, HASH_SOURCE_SIZE, Qt::KeepAspectRatio));
+    }
+    return image(reader.read());
+}
+
+/**
+ * Distancia de Hamming entre dos hashes (número de bits distintos)
+ */
+int PerceptualHash::distance(quint64 first, quint64 second)
+{
+    return qPopulationCount(first ^ second);
+}
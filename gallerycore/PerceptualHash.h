@@ -0,0 +1,31 @@
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QImage>
+#include <QString>
+#include "gallerycore_global.h"
+
+/**
+ * Hash perceptual de las imágenes, para encontrar imágenes parecidas
+ *
+ * Usa dHash (hash de diferencias): la imagen se reduce a 9x8 píxeles en
+ * escala de grises y cada bit indica si un píxel es más claro que su vecino
+ * de la derecha. Dos versiones de la misma foto (redimensionada,
+ * recomprimida, con otro formato) dan hashes a muy pocos bits de distancia;
+ * fotos distintas quedan, de media, a unos 32 bits.
+ *
+ * Como solo necesita una imagen diminuta, se calcula a partir del thumbnail
+ * cuando ya se ha generado (ver ImportPipeline).
+ */
+class GALLERYCORE_EXPORT PerceptualHash
+{
+public:
+    static quint64 image(const QImage& source);
+    static quint64 file(const QString& localPath);
+    static int distance(quint64 first, quint64 second);
+
+private:
+    PerceptualHash() = delete;
+};
+
+#endif // PERCEPTUALHASH_H
@@ -1,26 +1,48 @@
 #include "Picture.h"
 
+// La imagen guarda su ruta local en lugar de un QUrl: la ruta se reconstruye
+// desde la base de datos sin analizar ninguna URL y el QUrl solo se crea
+// cuando alguien lo pide explícitamente
 Picture::Picture(const QString& filePath) :
-    Picture(QUrl::fromLocalFile(filePath))
+    mId(-1),
+    mAlbumId(-1),
+    mFilePath(filePath)
 {
-
 }
 
 Picture::Picture(const QUrl& fileUrl) :
-    mId(-1),
-    mAlbumId(-1),
-    mFileUrl(fileUrl)
+    Picture(fileUrl.toLocalFile())
 {
 }
 
 QUrl Picture::fileUrl() const
 {
-    return mFileUrl;
+    return QUrl::fromLocalFile(mFilePath);
 }
 
 void Picture::setFileUrl(const QUrl& fileUrl)
 {
-    mFileUrl = fileUrl;
+    mFilePath = fileUrl.toLocalFile();
+}
+
+const QString& Picture::filePath() const
+{
+    return mFilePath;
+}
+
+void Picture::setFilePath(const QString& filePath)
+{
+    mFilePath = filePath;
+}
+
+const PictureMetadata& Picture::metadata() const
+{
+    return mMetadata;
+}
+
+void Picture::setMetadata(const PictureMetadata& metadata)
+{
+    mMetadata = metadata;
 }
 
 void Picture::setId(int id) {
@@ -34,3 +56,7 @@ void Picture::setAlbumId(int albumId) {
 int Picture::id() const {
     return mId;
 }
+
+int Picture::albumId() const {
+    return mAlbumId;
+}
@@ -2,21 +2,120 @@
 #include "qsqldatabase.h"
 #include "qsqlquery.h"
 #include <QSqlError>
+#include <QStringList>
+#include <QPair>
+#include <QDebug>
+#include <QFileInfo>
+#include <QUrl>
 #include "Picture.h"
+#include "DirectoryDao.h"
+#include "PictureRows.h"
+#include "PictureMetadata.h"
+#include "ContentHash.h"
+#include "PerceptualHash.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "Trace.h"
+#include <memory>
+#include <optional>
+#include <utility>
 
 /**
  * Constructor de PictureDao
  * @param database Referencia a la base de datos SQL que se utilizará para las operaciones
+ * @param directoryDao DAO de carpetas, usado para guardar y reconstruir las rutas
  *
  * Inicializa el objeto PictureDao con una referencia a la base de datos.
  * Este DAO (Data Access Object) encapsula todas las operaciones de acceso
  * a datos relacionadas con las imágenes (pictures) en la base de datos.
  */
-PictureDao::PictureDao(QSqlDatabase& database) :
-    mDatabase(database)  // Almacena la referencia a la base de datos
+PictureDao::PictureDao(QSqlDatabase& database, const DirectoryDao& directoryDao) :
+    mDatabase(database),  // Almacena la referencia a la base de datos
+    mStatements(database),  // Sentencias preparadas, reutilizadas entre llamadas
+    mDirectoryDao(directoryDao)  // DAO de carpetas para reconstruir las rutas
 {
 }
 
+// Número máximo de IDs por sentencia en las operaciones en bloque
+// (SQLite limita el número de parámetros de una sentencia)
+const int BULK_CHUNK_SIZE = 500;
+
+/**
+ * Columnas de metadatos añadidas a la tabla "pictures" (nombre y definición)
+ * Se usan tanto al crear la tabla como al migrar bases de datos antiguas
+ * que solo tenían id, album_id y url.
+ * El nombre del archivo es relativo a su carpeta (columna directory_id).
+ */
+static const QList<QPair<QString, QString>> METADATA_COLUMNS = {
+    { "width",       "INTEGER NOT NULL DEFAULT 0" },   // Ancho en píxeles
+    { "height",      "INTEGER NOT NULL DEFAULT 0" },   // Alto en píxeles
+    { "byte_size",   "INTEGER NOT NULL DEFAULT 0" },   // Tamaño en bytes
+    { "modified_at", "INTEGER NOT NULL DEFAULT 0" },   // Fecha de modificación (epoch)
+    { "taken_at",    "INTEGER NOT NULL DEFAULT 0" },   // Fecha de captura EXIF (epoch)
+    { "mime_type",   "TEXT NOT NULL DEFAULT ''" },     // Tipo MIME
+    { "name",        "TEXT NOT NULL DEFAULT ''" },     // Nombre del archivo
+    { "extension",   "TEXT NOT NULL DEFAULT ''" },     // Extensión en minúsculas
+    { "file_id",     "INTEGER NOT NULL DEFAULT 0" },   // Inodo del archivo (detecta renombrados)
+    { "content_hash", "INTEGER NOT NULL DEFAULT 0" },  // XXH64 del contenido (0 = sin calcular)
+    { "phash",       "INTEGER NOT NULL DEFAULT 0" },   // dHash de la imagen (0 = sin calcular)
+};
+
+/**
+ * Expresión SQL de cada clave de ordenación
+ * Debe coincidir exactamente con la de su índice para que SQLite lo use.
+ */
+static QString sortExpression(PictureQuery::SortKey sortKey)
+{
+    switch (sortKey) {
+    case PictureQuery::SortByName:
+        return "name COLLATE NOCASE";
+    case PictureQuery::SortByDate:
+        return "taken_at";
+    case PictureQuery::SortBySize:
+        return "byte_size";
+    case PictureQuery::SortByDimensions:
+        return "width * height";
+    case PictureQuery::SortById:
+    default:
+        return "id";
+    }
+}
+
+/**
+ * Devuelve los nombres de las columnas de una tabla
+ * @param database Base de datos a consultar
+ * @param table Nombre de la tabla
+ */
+static QStringList tableColumns(QSqlDatabase& database, const QString& table)
+{
+    QStringList columns;
+    ProfiledQuery query(database);
+    query.exec(QString("PRAGMA table_info(%1)").arg(table));
+    while (query.next()) {
+        columns << query.value(1).toString();  // La columna 1 es el nombre
+    }
+    return columns;
+}
+
+/**
+ * Sentencia CREATE TABLE con el esquema actual de la tabla de imágenes
+ * @param table Nombre de la tabla a crear (se usa otro nombre durante las migraciones)
+ */
+static QString createTableStatement(const QString& table)
+{
+    QString columns;
+    for (const auto& column : METADATA_COLUMNS) {
+        columns += ", " + column.first + " " + column.second;
+    }
+
+    // Concatena strings para mejor legibilidad del código
+    return QString("CREATE TABLE ") + table
+        + " (id INTEGER PRIMARY KEY AUTOINCREMENT, "  // ID único de la imagen
+        + "album_id INTEGER, "                         // ID del álbum asociado
+        + "directory_id INTEGER NOT NULL DEFAULT 0"    // Carpeta (tabla directories)
+        + columns + ")";                               // Nombre y metadatos
+}
+
 /**
  * Inicializa la tabla de imágenes en la base de datos
  *
@@ -24,25 +123,144 @@ PictureDao::PictureDao(QSqlDatabase& database) :
  * Si no existe, la crea con la siguiente estructura:
  * - id: Clave primaria autoincremental que identifica únicamente cada imagen
  * - album_id: Clave foránea que referencia al álbum al que pertenece la imagen
- * - url: Ruta o URL del archivo de imagen (tipo TEXT)
+ * - directory_id: Carpeta que contiene el archivo (ver DirectoryDao)
+ * - name, extension: nombre del archivo dentro de su carpeta y su extensión
+ * - width, height, byte_size, modified_at, taken_at, mime_type: metadatos
+ *   extraídos al importar (ver MetadataExtractor)
+ *
+ * Si la tabla ya existe pero es de una versión anterior, añade las columnas
+ * de metadatos que falten con ALTER TABLE y convierte las URLs completas
+ * de la antigua columna "url" en carpeta + nombre.
  *
  * Esta función debe ser llamada durante la inicialización de la aplicación
- * para garantizar que la tabla existe antes de realizar operaciones.
+ * (después de DirectoryDao::init()) para garantizar que la tabla existe antes
+ * de realizar operaciones.
  */
 void PictureDao::init() const
 {
+    ProfiledQuery query(mDatabase);
+
     // Verifica si la tabla "pictures" ya existe en la base de datos
     if (!mDatabase.tables().contains("pictures")) {
-        // Crea un objeto query para ejecutar comandos SQL
-        QSqlQuery query(mDatabase);
+        query.exec(createTableStatement("pictures"));
+    } else {
+        // Migración: añade las columnas de metadatos que no existan todavía
+        QStringList existing = tableColumns(mDatabase, "pictures");
+        for (const auto& column : METADATA_COLUMNS) {
+            if (!existing.contains(column.first)) {
+                query.exec("ALTER TABLE pictures ADD COLUMN "
+                           + column.first + " " + column.second);
+            }
+        }
 
-        // Ejecuta la consulta SQL para crear la tabla pictures
-        // Concatena strings para mejor legibilidad del código
-        query.exec(QString("CREATE TABLE pictures")
-        + " (id INTEGER PRIMARY KEY AUTOINCREMENT, "  // ID único de la imagen
-        + "album_id INTEGER, "                         // ID del álbum asociado
-        + "url TEXT)");                                // Ruta del archivo
+        // Rellena nombre y extensión de las imágenes importadas antes de
+        // existir estas columnas, a partir de la URL guardada
+        if (!existing.contains("name")) {
+            mDatabase.transaction();
+            ProfiledQuery select(mDatabase);
+            ProfiledQuery update(mDatabase);
+            select.setForwardOnly(true);
+            update.prepare("UPDATE pictures SET name = :name, extension = :extension WHERE id = :id");
+            select.exec("SELECT id, url FROM pictures");
+            while (select.next()) {
+                QFileInfo fileInfo(QUrl(select.value(1).toString()).toLocalFile());
+                update.bindValue(":name", fileInfo.fileName());
+                update.bindValue(":extension", fileInfo.suffix().toLower());
+                update.bindValue(":id", select.value(0).toInt());
+                update.exec();
+            }
+            mDatabase.commit();
+        }
+
+        // Sustituye la URL completa por carpeta + nombre relativo
+        if (existing.contains("url")) {
+            migrateUrlsToDirectories();
+        }
     }
+
+    // Índice por álbum para la paginación por cursor (keyset)
+    // En SQLite el índice incluye implícitamente el rowid (id), por lo que
+    // "WHERE album_id = ? AND id > ? ORDER BY id" se resuelve con un único
+    // recorrido del índice, sin ordenar en memoria
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_album_idx ON pictures (album_id)");
+
+    // Índices sobre las columnas ordenables, siempre precedidas por album_id
+    // ya que toda consulta del grid se filtra por álbum
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_taken_idx ON pictures (album_id, taken_at)");
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_size_idx ON pictures (album_id, byte_size)");
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_pixels_idx ON pictures (album_id, width * height)");
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_name_idx ON pictures (album_id, name COLLATE NOCASE)");
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_extension_idx ON pictures (album_id, extension)");
+
+    // Índice por carpeta para las operaciones a nivel de carpeta
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_directory_idx ON pictures (directory_id, name)");
+
+    // Índice por contenido: el filtro por tamaño y la agrupación de duplicados
+    // (byte_size, content_hash) se resuelven sin recorrer la tabla
+    query.exec("CREATE INDEX IF NOT EXISTS pictures_content_idx ON pictures (byte_size, content_hash)");
+}
+
+/**
+ * Migra el esquema antiguo (URL completa por imagen) a carpeta + nombre
+ *
+ * 1. Registra la carpeta de cada imagen en la tabla "directories"
+ * 2. Reconstruye la tabla "pictures" sin la columna "url", conservando los IDs
+ *    y el contador AUTOINCREMENT
+ * 3. Elimina el índice de búsqueda, que guardaba URLs; SearchDao::init() lo
+ *    vuelve a crear con las rutas nuevas
+ * 4. Compacta el archivo de la base de datos con VACUUM
+ *
+ * Todo salvo el VACUUM se ejecuta en una única transacción.
+ */
+void PictureDao::migrateUrlsToDirectories() const
+{
+    mDatabase.transaction();
+
+    ProfiledQuery query(mDatabase);
+    query.exec("ALTER TABLE pictures ADD COLUMN directory_id INTEGER NOT NULL DEFAULT 0");
+
+    ProfiledQuery select(mDatabase);
+    ProfiledQuery update(mDatabase);
+    select.setForwardOnly(true);
+    update.prepare("UPDATE pictures SET directory_id = :directoryId WHERE id = :id");
+    select.exec("SELECT id, url FROM pictures");
+    while (select.next()) {
+        QFileInfo fileInfo(QUrl(select.value(1).toString()).toLocalFile());
+        update.bindValue(":directoryId", mDirectoryDao.directoryIdForPath(fileInfo.absolutePath()));
+        update.bindValue(":id", select.value(0).toInt());
+        update.exec();
+    }
+    select.finish();
+
+    // Conserva el contador AUTOINCREMENT para no reutilizar IDs borrados
+    int sequence = 0;
+    query.exec("SELECT seq FROM sqlite_sequence WHERE name = 'pictures'");
+    if (query.next()) {
+        sequence = query.value(0).toInt();
+    }
+
+    QStringList columns = { "id", "album_id", "directory_id" };
+    for (const auto& column : METADATA_COLUMNS) {
+        columns << column.first;
+    }
+    QString columnList = columns.join(", ");
+
+    query.exec(createTableStatement("pictures_migrated"));
+    query.exec("INSERT INTO pictures_migrated (" + columnList + ") "
+               "SELECT " + columnList + " FROM pictures");
+    query.exec("DROP TABLE pictures");
+    query.exec("ALTER TABLE pictures_migrated RENAME TO pictures");
+    query.exec(QString("UPDATE sqlite_sequence SET seq = %1 WHERE name = 'pictures'").arg(sequence));
+    query.exec("DROP TABLE IF EXISTS picture_search");
+
+    if (!mDatabase.commit()) {
+        qDebug() << "Error al migrar las rutas de las imágenes:" << mDatabase.lastError();
+        mDatabase.rollback();
+        return;
+    }
+
+    // Recupera el espacio de las URLs eliminadas (no puede ir en una transacción)
+    query.exec("VACUUM");
 }
 
 /**
@@ -60,29 +278,27 @@ QVector<Picture*> PictureDao::picturesForAlbum(int albumId) const
     // Vector que almacenará los punteros a las imágenes recuperadas
     QVector<Picture*> list;
 
-    // Crea un objeto query para la base de datos
-    QSqlQuery query(mDatabase);
-
     // Prepara una consulta parametrizada para evitar inyección SQL
     // Selecciona solo las imágenes que pertenecen al álbum especificado
-    query.prepare("SELECT * FROM pictures WHERE album_id = :albumId");
+    CachedQuery query = mStatements.prepared("SELECT id, directory_id, name FROM pictures WHERE album_id = :albumId");
 
     // Vincula el ID del álbum al parámetro :albumId de la consulta
-    query.bindValue(":albumId", albumId);
+    query->bindValue(":albumId", albumId);
 
     // Ejecuta la consulta SELECT
-    query.exec();
+    query->exec();
 
     // Itera sobre cada fila del resultado de la consulta
-    while (query.next()) {
+    while (query->next()) {
         // Crea un nuevo objeto Picture en el heap
         Picture* pic = new Picture();
 
         // Establece el ID de la imagen desde la columna "id"
-        pic->setId(query.value("id").toInt());
+        pic->setId(query->value(0).toInt());
 
-        // Establece la URL/ruta del archivo desde la columna "url"
-        pic->setFileUrl(query.value("url").toString());
+        // Reconstruye la ruta del archivo a partir de su carpeta y su nombre
+        pic->setFilePath(DirectoryDao::joinPath(
+            mDirectoryDao.path(query->value(1).toInt()), query->value(2).toString()));
 
         // Establece el ID del álbum al que pertenece
         pic->setAlbumId(albumId);
@@ -94,6 +310,771 @@ QVector<Picture*> PictureDao::picturesForAlbum(int albumId) const
     return list;  // Retorna el vector con todas las imágenes del álbum
 }
 
+/**
+ * Obtiene una página de imágenes de un álbum ordenada y filtrada en SQL
+ * @param albumId ID del álbum del cual se quieren obtener las imágenes
+ * @param pictureQuery Criterios de ordenación y filtrado
+ * @param cursor Posición de la última fila ya cargada; se actualiza con la
+ *               última fila devuelta (vacío para la primera página)
+ * @param maxId ID máximo a incluir; las imágenes añadidas después de abrir el álbum
+ *              se insertan directamente en el modelo y no deben volver a paginarse
+ * @param limit Número máximo de imágenes a devolver
+ * @param rows Almacén al que se añaden las filas, en el orden solicitado
+ * @return Número de filas añadidas
+ *
+ * Usa paginación por cursor (keyset) sobre el par (clave, id), de modo que
+ * cada página es un recorrido del índice (album_id, clave) a partir de la
+ * última fila, independientemente de su posición dentro del álbum.
+ * La condición redundante "clave >= cursor" permite a SQLite acotar el
+ * recorrido del índice; la comparación de tuplas resuelve los empates por id.
+ *
+ * Las filas se copian directamente al almacén compacto, sin crear objetos Picture.
+ *
+ * Sin filtros solo hay unas pocas sentencias distintas (clave, sentido y
+ * cursor), que se reutilizan página tras página desde la caché. Con filtros
+ * las combinaciones no tienen límite (el IN de extensiones cambia con cada
+ * selección), así que la sentencia se prepara para esta página y se libera.
+ */
+int PictureDao::picturesPage(int albumId, const PictureQuery& pictureQuery,
+                             PictureCursor& cursor, int maxId, int limit, PictureRows& rows) const
+{
+    GALLERY_TRACE_SCOPE(lcDatabase, "PictureDao::picturesPage");
+    GALLERY_METRIC_TIMER("db.picturesPage.us");
+
+    const QString key = sortExpression(pictureQuery.sortKey);
+    const bool ascending = pictureQuery.sortOrder == Qt::AscendingOrder;
+    const QString direction = ascending ? "ASC" : "DESC";
+
+    QString sql = "SELECT id, directory_id, name, " + key + " FROM pictures "
+                  "WHERE album_id = :albumId AND id <= :maxId";
+
+    // Filtros
+    if (!pictureQuery.nameContains.isEmpty())
+        sql += " AND name LIKE :name ESCAPE '\\'";
+    for (int i = 0; i < pictureQuery.extensions.count(); ++i)
+        sql += (i == 0 ? " AND extension IN (" : ", ") + QString(":ext%1").arg(i)
+               + (i == pictureQuery.extensions.count() - 1 ? ")" : "");
+    if (pictureQuery.takenAfter > 0)
+        sql += " AND taken_at >= :takenAfter";
+    if (pictureQuery.takenBefore > 0)
+        sql += " AND taken_at <= :takenBefore";
+    if (pictureQuery.minByteSize > 0)
+        sql += " AND byte_size >= :minByteSize";
+    if (pictureQuery.maxByteSize > 0)
+        sql += " AND byte_size <= :maxByteSize";
+    if (pictureQuery.minWidth > 0)
+        sql += " AND width >= :minWidth";
+    if (pictureQuery.minHeight > 0)
+        sql += " AND height >= :minHeight";
+
+    // Cursor
+    if (!cursor.isAtStart()) {
+        if (pictureQuery.sortKey == PictureQuery::SortById) {
+            sql += ascending ? " AND id > :cursorId" : " AND id < :cursorId";
+        } else {
+            sql += QString(" AND %1 %2 :cursorBound AND (%1, id) %3 (:cursorKey, :cursorId)")
+                       .arg(key, ascending ? ">=" : "<=", ascending ? ">" : "<");
+        }
+    }
+
+    if (pictureQuery.sortKey == PictureQuery::SortById)
+        sql += " ORDER BY id " + direction;
+    else
+        sql += " ORDER BY " + key + " " + direction + ", id " + direction;
+    sql += " LIMIT :limit";
+
+    std::optional<CachedQuery> cached;
+    std::unique_ptr<ProfiledQuery> uncached;
+    ProfiledQuery* query;
+    if (pictureQuery.hasFilters()) {
+        uncached = std::make_unique<ProfiledQuery>(mDatabase);
+        uncached->setForwardOnly(true);
+        uncached->prepare(sql);
+        query = uncached.get();
+    } else {
+        cached.emplace(mStatements.prepared(sql));
+        query = &**cached;
+    }
+    query->bindValue(":albumId", albumId);
+    query->bindValue(":maxId", maxId);
+    query->bindValue(":limit", limit);
+
+    if (!pictureQuery.nameContains.isEmpty()) {
+        QString pattern = pictureQuery.nameContains;
+        pattern.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+        query->bindValue(":name", "%" + pattern + "%");
+    }
+    for (int i = 0; i < pictureQuery.extensions.count(); ++i)
+        query->bindValue(QString(":ext%1").arg(i), pictureQuery.extensions.at(i).toLower());
+    if (pictureQuery.takenAfter > 0)
+        query->bindValue(":takenAfter", pictureQuery.takenAfter);
+    if (pictureQuery.takenBefore > 0)
+        query->bindValue(":takenBefore", pictureQuery.takenBefore);
+    if (pictureQuery.minByteSize > 0)
+        query->bindValue(":minByteSize", pictureQuery.minByteSize);
+    if (pictureQuery.maxByteSize > 0)
+        query->bindValue(":maxByteSize", pictureQuery.maxByteSize);
+    if (pictureQuery.minWidth > 0)
+        query->bindValue(":minWidth", pictureQuery.minWidth);
+    if (pictureQuery.minHeight > 0)
+        query->bindValue(":minHeight", pictureQuery.minHeight);
+
+    if (!cursor.isAtStart()) {
+        query->bindValue(":cursorId", cursor.id);
+        if (pictureQuery.sortKey != PictureQuery::SortById) {
+            query->bindValue(":cursorBound", cursor.key);
+            query->bindValue(":cursorKey", cursor.key);
+        }
+    }
+
+    if (!query->exec()) {
+        qDebug() << "Error al paginar pictures:" << query->lastError();
+        return 0;
+    }
+
+    // Nombres de archivo de unos 24 caracteres de media
+    rows.reserve(limit, limit * 24);
+
+    int added = 0;
+    while (query->next()) {
+        const int id = query->value(0).toInt();
+        rows.append(id, albumId, query->value(1).toInt(), query->value(2).toString());
+        ++added;
+
+        // Avanza el cursor hasta la última fila leída
+        cursor.id = id;
+        cursor.key = query->value(3);
+    }
+
+    return added;
+}
+
+/**
+ * Obtiene el ID más alto de las imágenes de un álbum
+ * @param albumId ID del álbum
+ * @return ID de la última imagen del álbum, o 0 si el álbum está vacío
+ *
+ * Se usa como límite superior de la paginación al abrir un álbum.
+ */
+int PictureDao::lastPictureIdForAlbum(int albumId) const
+{
+    CachedQuery query = mStatements.prepared("SELECT MAX(id) FROM pictures WHERE album_id = :albumId");
+    query->bindValue(":albumId", albumId);
+
+    if (!query->exec() || !query->next()) {
+        qDebug() << "Error al consultar el último id:" << query->lastError();
+        return 0;
+    }
+
+    // MAX() devuelve NULL si el álbum no tiene imágenes; toInt() lo convierte en 0
+    return query->value(0).toInt();
+}
+
+/**
+ * Obtiene las extensiones de archivo presentes en un álbum
+ * @param albumId ID del álbum
+ * @return Lista ordenada de extensiones distintas (en minúsculas)
+ *
+ * Se resuelve con el índice (album_id, extension) sin leer la tabla.
+ */
+QStringList PictureDao::extensionsForAlbum(int albumId) const
+{
+    QStringList extensions;
+    CachedQuery query = mStatements.prepared("SELECT DISTINCT extension FROM pictures "
+                                             "WHERE album_id = :albumId AND extension <> '' ORDER BY extension");
+    query->bindValue(":albumId", albumId);
+    query->exec();
+    while (query->next()) {
+        extensions << query->value(0).toString();
+    }
+    return extensions;
+}
+
+/**
+ * Genera la lista de marcadores posicionales de una cláusula IN
+ * @param count Número de marcadores
+ * @return Cadena "?, ?, ..., ?"
+ */
+static QString idPlaceholders(int count)
+{
+    QString placeholders;
+    placeholders.reserve(count * 3);
+    for (int i = 0; i < count; ++i) {
+        placeholders += i == 0 ? "?" : ", ?";
+    }
+    return placeholders;
+}
+
+/**
+ * Ejecuta una sentencia sobre una lista de IDs dividida en bloques
+ * @param database Base de datos
+ * @param sql Sentencia con "%1" en lugar de la lista IN, que debe ser lo
+ *            último de la sentencia
+ * @param leadingValues Valores de los marcadores "?" anteriores a la lista IN
+ * @param pictureIds IDs de las imágenes
+ * @param inTransaction true si quien llama ya tiene una transacción abierta
+ *                      (por ejemplo, la de un lote de la importación)
+ * @return Número total de filas afectadas, o -1 si hay un error
+ *
+ * SQLite limita el número de parámetros por sentencia, así que los IDs se
+ * envían en bloques de BULK_CHUNK_SIZE. Todos los bloques van en una única
+ * transacción: o se aplican todos o ninguno. Con inTransaction se usa la de
+ * quien llama, que decide si confirmarla; si no, se abre una propia y, si no
+ * se puede abrir, no se ejecuta nada. La sentencia solo se vuelve a preparar
+ * cuando cambia el tamaño del bloque (como mucho, en el último).
+ */
+static int execInChunks(QSqlDatabase& database, const QString& sql,
+                        const QVariantList& leadingValues, const QVector<int>& pictureIds,
+                        bool inTransaction)
+{
+    if (pictureIds.isEmpty()) {
+        return 0;
+    }
+
+    const bool ownTransaction = !inTransaction;
+    if (ownTransaction && !database.transaction()) {
+        qDebug() << "Error al abrir la transacción de la operación en bloque:" << database.lastError();
+        return -1;
+    }
+
+    ProfiledQuery query(database);
+    int preparedSize = 0;
+    int affected = 0;
+    for (int first = 0; first < pictureIds.count(); first += BULK_CHUNK_SIZE) {
+        int count = qMin(BULK_CHUNK_SIZE, int(pictureIds.count()) - first);
+        if (count != preparedSize) {
+            query.prepare(sql.arg(idPlaceholders(count)));
+            preparedSize = count;
+        }
+
+        for (const QVariant& value : leadingValues) {
+            query.addBindValue(value);
+        }
+        for (int i = first; i < first + count; ++i) {
+            query.addBindValue(pictureIds.at(i));
+        }
+
+        if (!query.exec()) {
+            qDebug() << "Error en la operación en bloque:" << query.lastError();
+            if (ownTransaction) {
+                database.rollback();
+            }
+            return -1;
+        }
+        affected += query.numRowsAffected();
+    }
+
+    if (ownTransaction && !database.commit()) {
+        qDebug() << "Error al confirmar la operación en bloque:" << database.lastError();
+        database.rollback();
+        return -1;
+    }
+    return affected;
+}
+
+/**
+ * Mueve imágenes a otro álbum
+ * @param pictureIds IDs de las imágenes a mover
+ * @param albumId ID del álbum de destino
+ * @param inTransaction true si quien llama ya tiene una transacción abierta
+ * @return Número de imágenes movidas, o -1 si hay un error
+ *
+ * Solo cambia la columna album_id; el archivo, sus metadatos y su thumbnail
+ * (que se identifica por la ruta) no se tocan. Las imágenes que ya están
+ * en el álbum de destino no se cuentan.
+ */
+int PictureDao::movePictures(const QVector<int>& pictureIds, int albumId, bool inTransaction) const
+{
+    return execInChunks(mDatabase,
+                        "UPDATE pictures SET album_id = ? WHERE album_id <> ? AND id IN (%1)",
+                        { albumId, albumId }, pictureIds, inTransaction);
+}
+
+/**
+ * Copia imágenes a otro álbum
+ * @param pictureIds IDs de las imágenes a copiar
+ * @param albumId ID del álbum de destino
+ * @param inTransaction true si quien llama ya tiene una transacción abierta
+ * @return Número de imágenes copiadas, o -1 si hay un error
+ *
+ * Las copias son filas nuevas que apuntan al mismo archivo: se copian en SQL
+ * la carpeta, el nombre y los metadatos, sin volver a leer el disco.
+ */
+int PictureDao::copyPictures(const QVector<int>& pictureIds, int albumId, bool inTransaction) const
+{
+    QStringList columns = { "directory_id" };
+    for (const auto& column : METADATA_COLUMNS) {
+        columns << column.first;
+    }
+    QString columnList = columns.join(", ");
+
+    return execInChunks(mDatabase,
+                        "INSERT INTO pictures (album_id, " + columnList + ") "
+                        "SELECT ?, " + columnList + " FROM pictures WHERE id IN (%1)",
+                        { albumId }, pictureIds, inTransaction);
+}
+
+/**
+ * Indica si otra imagen del catálogo apunta al mismo archivo
+ * @param pictureId ID de la imagen
+ * @return true si existe una copia de la imagen en algún álbum
+ *
+ * Se usa antes de borrar el archivo del disco: si la imagen se copió a otro
+ * álbum, el archivo debe conservarse.
+ */
+bool PictureDao::isFileShared(int pictureId) const
+{
+    CachedQuery query = mStatements.prepared("SELECT EXISTS (SELECT 1 FROM pictures AS original "
+                                             "JOIN pictures AS copy ON copy.directory_id = original.directory_id "
+                                             "AND copy.name = original.name AND copy.id <> original.id "
+                                             "WHERE original.id = :id)");
+    query->bindValue(":id", pictureId);
+
+    if (!query->exec() || !query->next()) {
+        qDebug() << "Error al comprobar las copias de la imagen:" << query->lastError();
+        return true;  // Ante la duda, no se borra el archivo
+    }
+    return query->value(0).toBool();
+}
+
+/**
+ * Obtiene los archivos del catálogo que están en una carpeta
+ * @param directoryId ID de la carpeta
+ * @return Un elemento por archivo, aunque esté copiado en varios álbumes
+ *
+ * Se resuelve con el índice (directory_id, name), así que las filas ya
+ * llegan agrupadas por nombre.
+ */
+QVector<PictureFile> PictureDao::filesInDirectory(int directoryId) const
+{
+    CachedQuery query = mStatements.prepared("SELECT name, file_id, byte_size, modified_at, album_id, phash FROM pictures "
+                                             "WHERE directory_id = :directoryId ORDER BY name");
+    query->bindValue(":directoryId", directoryId);
+
+    QVector<PictureFile> files;
+    if (!query->exec()) {
+        qDebug() << "Error al obtener los archivos de la carpeta:" << query->lastError();
+        return files;
+    }
+
+    while (query->next()) {
+        QString name = query->value(0).toString();
+        if (files.isEmpty() || files.last().name != name) {
+            PictureFile file;
+            file.name = name;
+            file.fileId = query->value(1).toULongLong();
+            file.byteSize = query->value(2).toLongLong();
+            file.modifiedAt = query->value(3).toLongLong();
+            file.perceptualHash = query->value(5).toULongLong();
+            files.push_back(std::move(file));
+        }
+        files.last().albumIds << query->value(4).toInt();
+    }
+    return files;
+}
+
+/**
+ * Obtiene el álbum al que pertenecen la mayoría de imágenes de una carpeta
+ * @param directoryId ID de la carpeta
+ * @return ID del álbum, o -1 si la carpeta no tiene imágenes
+ *
+ * Los archivos nuevos de una carpeta vigilada van al mismo álbum que sus
+ * vecinos (por ejemplo, al importar con un álbum por subcarpeta).
+ */
+int PictureDao::albumForDirectory(int directoryId) const
+{
+    CachedQuery query = mStatements.prepared("SELECT album_id FROM pictures WHERE directory_id = :directoryId "
+                                             "GROUP BY album_id ORDER BY COUNT(*) DESC LIMIT 1");
+    query->bindValue(":directoryId", directoryId);
+    if (!query->exec() || !query->next()) {
+        return -1;
+    }
+    return query->value(0).toInt();
+}
+
+/**
+ * Cambia la carpeta y el nombre de un archivo renombrado o movido
+ * @param directoryId Carpeta actual del archivo en el catálogo
+ * @param name Nombre actual del archivo en el catálogo
+ * @param newDirectoryId Nueva carpeta
+ * @param newName Nuevo nombre
+ * @return true si se ha actualizado
+ *
+ * Se actualizan todas las copias del archivo; sus IDs, álbumes y metadatos
+ * se conservan.
+ */
+bool PictureDao::relocateFile(int directoryId, const QString& name,
+                              int newDirectoryId, const QString& newName) const
+{
+    CachedQuery query = mStatements.prepared("UPDATE pictures SET directory_id = :newDirectoryId, name = :newName, "
+                                             "extension = :extension WHERE directory_id = :directoryId AND name = :name");
+    query->bindValue(":newDirectoryId", newDirectoryId);
+    query->bindValue(":newName", newName);
+    query->bindValue(":extension", QFileInfo(newName).suffix().toLower());
+    query->bindValue(":directoryId", directoryId);
+    query->bindValue(":name", name);
+
+    if (!query->exec()) {
+        qDebug() << "Error al reubicar el archivo:" << query->lastError();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Actualiza los metadatos de un archivo modificado en disco
+ * @param directoryId Carpeta del archivo
+ * @param name Nombre del archivo
+ * @param metadata Metadatos leídos de nuevo
+ * @return true si se han actualizado
+ */
+bool PictureDao::updateFileMetadata(int directoryId, const QString& name,
+                                    const PictureMetadata& metadata) const
+{
+    CachedQuery query = mStatements.prepared("UPDATE pictures SET width = :width, height = :height, byte_size = :byteSize, "
+                                             "modified_at = :modifiedAt, taken_at = :takenAt, mime_type = :mimeType, "
+                                             "file_id = :fileId, content_hash = :contentHash, phash = :perceptualHash "
+                                             "WHERE directory_id = :directoryId AND name = :name");
+    query->bindValue(":width", metadata.width);
+    query->bindValue(":height", metadata.height);
+    query->bindValue(":byteSize", metadata.byteSize);
+    query->bindValue(":modifiedAt", metadata.modifiedAt);
+    query->bindValue(":takenAt", metadata.takenAt);
+    query->bindValue(":mimeType", metadata.mimeType);
+    query->bindValue(":fileId", qint64(metadata.fileId));
+    query->bindValue(":contentHash", qint64(metadata.contentHash));
+    query->bindValue(":perceptualHash", qint64(metadata.perceptualHash));
+    query->bindValue(":directoryId", directoryId);
+    query->bindValue(":name", name);
+
+    if (!query->exec()) {
+        qDebug() << "Error al actualizar los metadatos del archivo:" << query->lastError();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Elimina del catálogo un archivo borrado del disco (todas sus copias)
+ * @param directoryId Carpeta del archivo
+ * @param name Nombre del archivo
+ * @return true si se ha eliminado
+ */
+bool PictureDao::removeFile(int directoryId, const QString& name) const
+{
+    CachedQuery query = mStatements.prepared("DELETE FROM pictures WHERE directory_id = :directoryId AND name = :name");
+    query->bindValue(":directoryId", directoryId);
+    query->bindValue(":name", name);
+
+    if (!query->exec()) {
+        qDebug() << "Error al eliminar el archivo:" << query->lastError();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Obtiene los tamaños de archivo presentes en el catálogo
+ * @return Conjunto de tamaños en bytes (recorre solo el índice pictures_content_idx)
+ *
+ * Un archivo cuyo tamaño no está en el conjunto no puede ser un duplicado,
+ * así que no hace falta calcular su hash.
+ */
+QSet<qint64> PictureDao::byteSizes() const
+{
+    ProfiledQuery query(mDatabase);
+    query.setForwardOnly(true);
+    query.exec("SELECT DISTINCT byte_size FROM pictures");
+
+    QSet<qint64> sizes;
+    while (query.next()) {
+        sizes.insert(query.value(0).toLongLong());
+    }
+    return sizes;
+}
+
+/**
+ * Calcula el hash de un archivo del catálogo y lo guarda en todas sus copias
+ * @param directoryId Carpeta del archivo
+ * @param name Nombre del archivo
+ * @return Hash calculado, o 0 si el archivo no se puede leer
+ */
+quint64 PictureDao::updateContentHash(int directoryId, const QString& name) const
+{
+    quint64 hash = ContentHash::file(DirectoryDao::joinPath(mDirectoryDao.path(directoryId), name));
+    if (hash == 0) {
+        return 0;
+    }
+
+    CachedQuery query = mStatements.prepared("UPDATE pictures SET content_hash = :contentHash "
+                                             "WHERE directory_id = :directoryId AND name = :name");
+    query->bindValue(":contentHash", qint64(hash));
+    query->bindValue(":directoryId", directoryId);
+    query->bindValue(":name", name);
+    if (!query->exec()) {
+        qDebug() << "Error al guardar el hash del archivo:" << query->lastError();
+    }
+    return hash;
+}
+
+/**
+ * Busca en el catálogo una imagen con el mismo contenido que un archivo
+ * @param filePath Ruta local del archivo
+ * @param metadata Metadatos del archivo (byteSize obligatorio); si hay que
+ *                 calcular su hash se guarda en metadata.contentHash
+ * @param albumId Álbum en el que se busca primero
+ * @param inAlbum Si no es nulo, indica si la imagen encontrada está en albumId
+ * @return ID de la imagen con el mismo contenido, o -1 si no hay ninguna
+ *
+ * Filtro por tamaño: si ninguna imagen tiene el mismo tamaño no se calcula
+ * ningún hash. Si alguna lo tiene, se calcula el del archivo y, de forma
+ * perezosa, el de las imágenes candidatas que aún no lo tenían.
+ */
+int PictureDao::findByContent(const QString& filePath, PictureMetadata& metadata,
+                              int albumId, bool* inAlbum) const
+{
+    if (inAlbum) {
+        *inAlbum = false;
+    }
+
+    CachedQuery query = mStatements.prepared("SELECT id, album_id, directory_id, name, content_hash FROM pictures "
+                                             "WHERE byte_size = :byteSize");
+    query->bindValue(":byteSize", metadata.byteSize);
+    if (!query->exec()) {
+        qDebug() << "Error al buscar duplicados:" << query->lastError();
+        return -1;
+    }
+
+    struct Candidate { int id; int albumId; int directoryId; QString name; quint64 hash; };
+    QVector<Candidate> candidates;
+    while (query->next()) {
+        candidates.append({ query->value(0).toInt(), query->value(1).toInt(),
+                            query->value(2).toInt(), query->value(3).toString(),
+                            query->value(4).toULongLong() });
+    }
+    query->finish();
+    if (candidates.isEmpty()) {
+        return -1;
+    }
+
+    if (metadata.contentHash == 0) {
+        metadata.contentHash = ContentHash::file(filePath);
+        if (metadata.contentHash == 0) {
+            return -1;
+        }
+    }
+
+    // Hashes calculados en esta llamada, por archivo (las copias comparten archivo)
+    QHash<QString, quint64> computed;
+    int found = -1;
+    for (const Candidate& candidate : std::as_const(candidates)) {
+        quint64 hash = candidate.hash;
+        if (hash == 0) {
+            QString key = QString::number(candidate.directoryId) + '/' + candidate.name;
+            auto it = computed.constFind(key);
+            hash = it != computed.cend()
+                ? it.value()
+                : computed.insert(key, updateContentHash(candidate.directoryId, candidate.name)).value();
+        }
+        if (hash != metadata.contentHash) {
+            continue;
+        }
+
+        if (candidate.albumId == albumId) {
+            if (inAlbum) {
+                *inAlbum = true;
+            }
+            return candidate.id;
+        }
+        if (found < 0) {
+            found = candidate.id;
+        }
+    }
+    return found;
+}
+
+/**
+ * Obtiene los grupos de imágenes duplicadas del catálogo
+ * @return Un vector de IDs por grupo; cada grupo tiene al menos dos archivos
+ *         distintos con el mismo contenido (las copias entre álbumes de un
+ *         mismo archivo no cuentan como duplicados)
+ *
+ * Primero calcula los hashes que falten entre los archivos que comparten
+ * tamaño; después los grupos salen de una única consulta agrupada sobre el
+ * índice (byte_size, content_hash). Los grupos más pesados van primero.
+ */
+QVector<QVector<int>> PictureDao::duplicateGroups() const
+{
+    ProfiledQuery query(mDatabase);
+    query.setForwardOnly(true);
+
+    // Archivos sin hash cuyo tamaño coincide con el de otro archivo
+    query.exec("SELECT DISTINCT directory_id, name FROM pictures WHERE content_hash = 0 "
+               "AND byte_size IN (SELECT byte_size FROM pictures GROUP BY byte_size "
+               "HAVING COUNT(DISTINCT directory_id || '/' || name) > 1)");
+    QVector<QPair<int, QString>> unhashed;
+    while (query.next()) {
+        unhashed.append(qMakePair(query.value(0).toInt(), query.value(1).toString()));
+    }
+    query.finish();
+
+    if (!unhashed.isEmpty()) {
+        mDatabase.transaction();
+        for (const auto& file : std::as_const(unhashed)) {
+            updateContentHash(file.first, file.second);
+        }
+        mDatabase.commit();
+    }
+
+    QVector<QVector<int>> groups;
+    if (!query.exec("SELECT group_concat(id) FROM pictures WHERE content_hash <> 0 "
+                    "GROUP BY byte_size, content_hash "
+                    "HAVING COUNT(DISTINCT directory_id || '/' || name) > 1 "
+                    "ORDER BY byte_size DESC")) {
+        qDebug() << "Error al buscar duplicados:" << query.lastError();
+        return groups;
+    }
+
+    while (query.next()) {
+        QVector<int> group;
+        const QStringList ids = query.value(0).toString().split(',');
+        for (const QString& id : ids) {
+            group << id.toInt();
+        }
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+/**
+ * Obtiene los hashes perceptuales del catálogo, para construir un SimilarityIndex
+ * @param pictureIds Vector al que se añade el ID de cada archivo
+ * @param hashes Vector al que se añade su hash (mismo orden)
+ *
+ * Un archivo copiado en varios álbumes aparece una sola vez (con el menor de
+ * sus IDs). Los archivos sin hash no se incluyen: los que no se pudieron
+ * leer y los de catálogos anteriores al hash (gallerycli prewarm los calcula).
+ */
+void PictureDao::perceptualHashes(QVector<int>& pictureIds, QVector<quint64>& hashes) const
+{
+    ProfiledQuery query(mDatabase);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT MIN(id), phash FROM pictures WHERE phash <> 0 "
+                    "GROUP BY directory_id, name")) {
+        qDebug() << "Error al obtener los hashes perceptuales:" << query.lastError();
+        return;
+    }
+
+    while (query.next()) {
+        pictureIds.append(query.value(0).toInt());
+        hashes.append(query.value(1).toULongLong());
+    }
+}
+
+/**
+ * Obtiene el hash perceptual de una imagen
+ * @param pictureId ID de la imagen
+ * @return Hash guardado; si aún no lo tenía se calcula a partir del archivo y
+ *         se guarda en todas sus copias. 0 si el archivo no se puede leer.
+ */
+quint64 PictureDao::perceptualHash(int pictureId) const
+{
+    int directoryId;
+    QString name;
+    {
+        CachedQuery query = mStatements.prepared("SELECT directory_id, name, phash FROM pictures WHERE id = :id");
+        query->bindValue(":id", pictureId);
+        if (!query->exec() || !query->next()) {
+            return 0;
+        }
+
+        quint64 hash = query->value(2).toULongLong();
+        if (hash != 0) {
+            return hash;
+        }
+        directoryId = query->value(0).toInt();
+        name = query->value(1).toString();
+    }
+
+    // Se calcula con la lectura ya cerrada: puede tardar
+    quint64 hash = PerceptualHash::file(DirectoryDao::joinPath(mDirectoryDao.path(directoryId), name));
+    if (hash == 0) {
+        return 0;
+    }
+
+    setPerceptualHash(directoryId, name, hash);
+    return hash;
+}
+
+/**
+ * Guarda el hash perceptual de un archivo en todas sus copias
+ * @param directoryId Carpeta del archivo
+ * @param name Nombre del archivo
+ * @param hash Hash calculado (ver PerceptualHash)
+ * @return true si se ha guardado
+ */
+bool PictureDao::setPerceptualHash(int directoryId, const QString& name, quint64 hash) const
+{
+    CachedQuery update = mStatements.prepared("UPDATE pictures SET phash = :perceptualHash "
+                                              "WHERE directory_id = :directoryId AND name = :name");
+    update->bindValue(":perceptualHash", qint64(hash));
+    update->bindValue(":directoryId", directoryId);
+    update->bindValue(":name", name);
+    if (!update->exec()) {
+        qDebug() << "Error al guardar el hash perceptual:" << update->lastError();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Obtiene las filas de una lista de imágenes, en el orden de la lista
+ * @param pictureIds IDs de las imágenes (como mucho BULK_CHUNK_SIZE)
+ * @param rows Almacén al que se añaden las filas
+ * @return Número de filas añadidas (las imágenes que ya no existen se omiten)
+ */
+int PictureDao::picturesByIds(const QVector<int>& pictureIds, PictureRows& rows) const
+{
+    GALLERY_TRACE_SCOPE(lcDatabase, "PictureDao::picturesByIds");
+    GALLERY_METRIC_TIMER("db.picturesByIds.us");
+
+    if (pictureIds.isEmpty()) {
+        return 0;
+    }
+
+    ProfiledQuery query(mDatabase);
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, album_id, directory_id, name FROM pictures WHERE id IN ("
+                  + idPlaceholders(pictureIds.count()) + ")");
+    for (int id : pictureIds) {
+        query.addBindValue(id);
+    }
+    if (!query.exec()) {
+        qDebug() << "Error al obtener las imágenes:" << query.lastError();
+        return 0;
+    }
+
+    // Las filas llegan en orden de ID; se reordenan según la lista
+    PictureRows found;
+    QHash<int, int> rowForId;
+    found.reserve(pictureIds.count(), pictureIds.count() * 16);
+    while (query.next()) {
+        rowForId.insert(query.value(0).toInt(), found.count());
+        found.append(query.value(0).toInt(), query.value(1).toInt(),
+                     query.value(2).toInt(), query.value(3).toString());
+    }
+
+    int count = 0;
+    for (int id : pictureIds) {
+        int row = rowForId.value(id, -1);
+        if (row >= 0) {
+            rows.append(found.id(row), found.albumId(row), found.directoryId(row), found.name(row));
+            ++count;
+        }
+    }
+    return count;
+}
+
 /**
  * Elimina una imagen de la base de datos
  * @param pictureId ID de la imagen que se desea eliminar
@@ -106,19 +1087,15 @@ QVector<Picture*> PictureDao::picturesForAlbum(int albumId) const
  */
 void PictureDao::removePicture(int pictureId) const
 {
-    // Crea un objeto query (nota: usa el constructor por defecto,
-    // podría ser mejor usar QSqlQuery query(mDatabase) para consistencia)
-    QSqlQuery query;
-
     // Prepara la consulta SQL DELETE con parámetro nombrado
-    query.prepare("DELETE FROM pictures WHERE id = :id");
+    CachedQuery query = mStatements.prepared("DELETE FROM pictures WHERE id = :id");
 
     // Vincula el ID de la imagen a eliminar al parámetro :id
-    query.bindValue(":id", pictureId);
+    query->bindValue(":id", pictureId);
 
     // Ejecuta la consulta DELETE y verifica si tuvo éxito
-    if (!query.exec()) {
+    if (!query->exec()) {
         // Si la ejecución falla, muestra el error en la consola de debug
-        qDebug() << "Error al eliminar picture:" << query.lastError();
+        qDebug() << "Error al eliminar picture:" << query->lastError();
     }
 }
@@ -1,10 +1,34 @@
+#ifndef PICTUREDAO_H
+#define PICTUREDAO_H
+
+#include <QSet>
 #include <QVector>
+#include <QStringList>
+#include "PictureQuery.h"
+#include "StatementCache.h"
 class QSqlDatabase;
 class Picture;
+struct PictureMetadata;
+class PictureRows;
+class DirectoryDao;
+/**
+ * Archivo del catálogo dentro de una carpeta, con los datos necesarios para
+ * compararlo con el disco (ver LibraryWatcher)
+ */
+struct PictureFile
+{
+    QString name;           // Nombre del archivo dentro de su carpeta
+    quint64 fileId = 0;     // Inodo guardado al importarlo
+    qint64 byteSize = 0;
+    qint64 modifiedAt = 0;
+    quint64 perceptualHash = 0; // 0 si aún no se ha calculado
+    QList<int> albumIds;    // Álbumes que contienen el archivo (varios si se copió)
+};
+
 class PictureDao
 {
 public:
-    explicit PictureDao(QSqlDatabase& database);
+    PictureDao(QSqlDatabase& database, const DirectoryDao& directoryDao);
 
     void init() const;
     void addPictureInAlbum(int albumId, Picture& picture) const;
@@ -12,7 +36,40 @@ public:
     void removePicturesForAlbum(int albumId) const;
 
     QVector<Picture*> picturesForAlbum(int albumId) const;
+    int picturesPage(int albumId, const PictureQuery& pictureQuery,
+                     PictureCursor& cursor, int maxId, int limit, PictureRows& rows) const;
+    int lastPictureIdForAlbum(int albumId) const;
+    QStringList extensionsForAlbum(int albumId) const;
+
+    int movePictures(const QVector<int>& pictureIds, int albumId, bool inTransaction = false) const;
+    int copyPictures(const QVector<int>& pictureIds, int albumId, bool inTransaction = false) const;
+    bool isFileShared(int pictureId) const;
+
+    QVector<PictureFile> filesInDirectory(int directoryId) const;
+    int albumForDirectory(int directoryId) const;
+    bool relocateFile(int directoryId, const QString& name,
+                      int newDirectoryId, const QString& newName) const;
+    bool updateFileMetadata(int directoryId, const QString& name,
+                            const PictureMetadata& metadata) const;
+    bool removeFile(int directoryId, const QString& name) const;
+
+    QSet<qint64> byteSizes() const;
+    int findByContent(const QString& filePath, PictureMetadata& metadata,
+                      int albumId = -1, bool* inAlbum = nullptr) const;
+    QVector<QVector<int>> duplicateGroups() const;
+    int picturesByIds(const QVector<int>& pictureIds, PictureRows& rows) const;
+
+    void perceptualHashes(QVector<int>& pictureIds, QVector<quint64>& hashes) const;
+    quint64 perceptualHash(int pictureId) const;
+    bool setPerceptualHash(int directoryId, const QString& name, quint64 hash) const;
 
 private:
+    void migrateUrlsToDirectories() const;
+    quint64 updateContentHash(int directoryId, const QString& name) const;
+
     QSqlDatabase& mDatabase;
+    mutable StatementCache mStatements;
+    const DirectoryDao& mDirectoryDao;
 };
+
+#endif // PICTUREDAO_H
@@ -0,0 +1,29 @@
+#ifndef PICTUREMETADATA_H
+#define PICTUREMETADATA_H
+
+#include <QString>
+
+/**
+ * Metadatos de una imagen extraídos en el momento de importarla
+ *
+ * Se guardan como columnas de la tabla "pictures" para poder ordenar
+ * y filtrar álbumes grandes sin volver a consultar el sistema de archivos.
+ * Las fechas se almacenan en segundos desde epoch. modifiedAt es un instante
+ * (UTC); takenAt es la hora de reloj de la captura guardada como si fuera
+ * UTC, porque EXIF no indica la zona horaria: una foto de las 10:00 tiene
+ * las 10:00 UTC de ese día, se importe donde se importe.
+ */
+struct PictureMetadata
+{
+    int width = 0;            // Ancho en píxeles
+    int height = 0;           // Alto en píxeles
+    qint64 byteSize = 0;      // Tamaño del archivo en bytes
+    qint64 modifiedAt = 0;    // Fecha de última modificación del archivo
+    qint64 takenAt = 0;       // Hora de captura EXIF (o de modificación, en hora local, si no hay EXIF)
+    QString mimeType;         // Tipo MIME, por ejemplo "image/jpeg"
+    quint64 fileId = 0;       // Identidad del archivo en su volumen (inodo); 0 si no se conoce
+    quint64 contentHash = 0;  // XXH64 del contenido (ver ContentHash); 0 si no se ha calculado
+    quint64 perceptualHash = 0;   // dHash del thumbnail (ver PerceptualHash); 0 si no se ha calculado
+};
+
+#endif // PICTUREMETADATA_H
@@ -0,0 +1,68 @@
+#ifndef PICTUREQUERY_H
+#define PICTUREQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+/**
+ * Criterios de ordenación y filtrado de las imágenes de un álbum
+ *
+ * PictureDao traduce estos criterios a SQL sobre columnas indexadas,
+ * de modo que reordenar un álbum grande es un único recorrido de índice
+ * en lugar de un ordenamiento en memoria.
+ */
+struct PictureQuery
+{
+    enum SortKey {
+        SortById,           // Orden de importación
+        SortByName,         // Nombre del archivo (sin distinguir mayúsculas)
+        SortByDate,         // Fecha de captura
+        SortBySize,         // Tamaño en bytes
+        SortByDimensions,   // Número de píxeles (ancho * alto)
+    };
+
+    SortKey sortKey = SortById;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+
+    // Filtros: un valor vacío o 0 significa "sin filtro"
+    QString nameContains;       // Subcadena del nombre del archivo
+    QStringList extensions;     // Extensiones en minúsculas, sin punto ("jpg", "png")
+    qint64 takenAfter = 0;      // Fecha de captura mínima (epoch)
+    qint64 takenBefore = 0;     // Fecha de captura máxima (epoch)
+    qint64 minByteSize = 0;
+    qint64 maxByteSize = 0;
+    int minWidth = 0;
+    int minHeight = 0;
+
+    bool hasFilters() const
+    {
+        return !nameContains.isEmpty() || !extensions.isEmpty() || takenAfter > 0
+            || takenBefore > 0 || minByteSize > 0 || maxByteSize > 0
+            || minWidth > 0 || minHeight > 0;
+    }
+
+    bool operator==(const PictureQuery& other) const
+    {
+        return sortKey == other.sortKey && sortOrder == other.sortOrder
+            && nameContains == other.nameContains && extensions == other.extensions
+            && takenAfter == other.takenAfter && takenBefore == other.takenBefore
+            && minByteSize == other.minByteSize && maxByteSize == other.maxByteSize
+            && minWidth == other.minWidth && minHeight == other.minHeight;
+    }
+    bool operator!=(const PictureQuery& other) const { return !(*this == other); }
+};
+
+/**
+ * Posición de la última fila cargada en una consulta paginada
+ * Guarda el valor de la clave de ordenación y el ID como desempate.
+ */
+struct PictureCursor
+{
+    QVariant key;
+    int id = 0;
+
+    bool isAtStart() const { return id == 0; }
+};
+
+#endif // PICTUREQUERY_H
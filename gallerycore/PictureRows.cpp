@@ -0,0 +1,158 @@
+#include "PictureRows.h"
+
+/**
+ * Constructor de PictureRows
+ * Crea un almacén vacío con el desplazamiento inicial de la cadena de nombres.
+ */
+PictureRows::PictureRows() :
+    mNameOffsets(1, 0)
+{
+}
+
+/**
+ * Retorna el número de filas almacenadas
+ */
+int PictureRows::count() const
+{
+    return mIds.count();
+}
+
+/**
+ * Indica si no hay ninguna fila almacenada
+ */
+bool PictureRows::isEmpty() const
+{
+    return mIds.isEmpty();
+}
+
+/**
+ * Reserva memoria para un número de filas adicionales
+ * @param rows Número de filas que se van a añadir
+ * @param nameChars Número aproximado de caracteres de sus nombres
+ */
+void PictureRows::reserve(int rows, int nameChars)
+{
+    mIds.reserve(count() + rows);
+    mAlbumIds.reserve(count() + rows);
+    mDirectoryIds.reserve(count() + rows);
+    mNameOffsets.reserve(count() + rows + 1);
+    mNames.reserve(mNames.size() + nameChars);
+}
+
+/**
+ * Elimina todas las filas
+ *
+ * Conserva la capacidad de los vectores y de la cadena de nombres, de modo
+ * que cambiar de álbum reutiliza la memoria en lugar de volver a reservarla.
+ */
+void PictureRows::clear()
+{
+    mIds.clear();
+    mAlbumIds.clear();
+    mDirectoryIds.clear();
+    mNameOffsets.resize(1);
+    mNames.resize(0);
+}
+
+/**
+ * Añade una fila al final
+ * @param id ID de la imagen
+ * @param albumId ID del álbum al que pertenece
+ * @param directoryId ID de la carpeta que contiene el archivo
+ * @param name Nombre del archivo dentro de su carpeta
+ */
+void PictureRows::append(int id, int albumId, int directoryId, QStringView name)
+{
+    mIds.append(id);
+    mAlbumIds.append(albumId);
+    mDirectoryIds.append(directoryId);
+    mNames.append(name);
+    mNameOffsets.append(mNames.size());
+}
+
+/**
+ * Añade al final todas las filas de otro almacén
+ * @param other Filas a añadir (por ejemplo, una página recién consultada)
+ */
+void PictureRows::append(const PictureRows& other)
+{
+    const int base = mNames.size();
+
+    mIds.append(other.mIds);
+    mAlbumIds.append(other.mAlbumIds);
+    mDirectoryIds.append(other.mDirectoryIds);
+    mNames.append(other.mNames);
+
+    mNameOffsets.reserve(mNameOffsets.size() + other.count());
+    for (int i = 1; i < other.mNameOffsets.size(); ++i) {
+        mNameOffsets.append(base + other.mNameOffsets.at(i));
+    }
+}
+
+/**
+ * Elimina un rango de filas
+ * @param row Primera fila a eliminar
+ * @param count Número de filas a eliminar
+ *
+ * Compacta la cadena de nombres y desplaza los offsets de las filas siguientes.
+ */
+void PictureRows::remove(int row, int count)
+{
+    const int first = mNameOffsets.at(row);
+    const int removedChars = mNameOffsets.at(row + count) - first;
+
+    mIds.remove(row, count);
+    mAlbumIds.remove(row, count);
+    mDirectoryIds.remove(row, count);
+    mNames.remove(first, removedChars);
+
+    mNameOffsets.remove(row + 1, count);
+    for (int i = row + 1; i < mNameOffsets.size(); ++i) {
+        mNameOffsets[i] -= removedChars;
+    }
+}
+
+/**
+ * Retorna el ID de la imagen de una fila
+ */
+int PictureRows::id(int row) const
+{
+    return mIds.at(row);
+}
+
+/**
+ * Retorna el ID del álbum de una fila
+ */
+int PictureRows::albumId(int row) const
+{
+    return mAlbumIds.at(row);
+}
+
+/**
+ * Retorna el ID de la carpeta de una fila
+ */
+int PictureRows::directoryId(int row) const
+{
+    return mDirectoryIds.at(row);
+}
+
+/**
+ * Retorna el nombre del archivo de una fila
+ * @return Vista sobre la cadena de nombres; deja de ser válida si se modifica el almacén
+ */
+QStringView PictureRows::name(int row) const
+{
+    const int first = mNameOffsets.at(row);
+    return QStringView(mNames).mid(first, mNameOffsets.at(row + 1) - first);
+}
+
+/**
+ * Busca la fila de una imagen por su ID
+ * @param pictureId ID de la imagen
+ * @param from Fila a partir de la cual buscar
+ * @return Fila de la imagen, o -1 si no está cargada
+ */
+int PictureRows::indexOf(int pictureId, int from) const
+{
+    return mIds.indexOf(pictureId, from);
+}
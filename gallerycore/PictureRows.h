@@ -0,0 +1,52 @@
+#ifndef PICTUREROWS_H
+#define PICTUREROWS_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "gallerycore_global.h"
+
+/**
+ * Almacén compacto de las filas de imágenes cargadas en un modelo
+ *
+ * En lugar de un objeto Picture por fila, guarda cada campo en un vector
+ * contiguo (estructura de arrays). Los nombres de archivo se concatenan en
+ * una única cadena y cada fila guarda solo su desplazamiento; la carpeta se
+ * guarda como id de la tabla "directories" (ver DirectoryDao).
+ *
+ * Los DAOs añaden las filas directamente desde el resultado de la consulta,
+ * sin crear objetos Picture intermedios.
+ */
+class GALLERYCORE_EXPORT PictureRows
+{
+public:
+    PictureRows();
+
+    int count() const;
+    bool isEmpty() const;
+
+    void reserve(int rows, int nameChars);
+    void clear();
+    void append(int id, int albumId, int directoryId, QStringView name);
+    void append(const PictureRows& other);
+    void remove(int row, int count = 1);
+
+    int id(int row) const;
+    int albumId(int row) const;
+    int directoryId(int row) const;
+    QStringView name(int row) const;
+
+    int indexOf(int pictureId, int from = 0) const;
+
+private:
+    QVector<int> mIds;
+    QVector<int> mAlbumIds;
+    QVector<int> mDirectoryIds;
+
+    // mNameOffsets tiene count() + 1 elementos: el nombre de la fila i ocupa
+    // [mNameOffsets[i], mNameOffsets[i + 1]) dentro de mNames
+    QVector<int> mNameOffsets;
+    QString mNames;
+};
+
+#endif // PICTUREROWS_H
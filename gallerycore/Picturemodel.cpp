@@ -1,35 +1,89 @@
 #include "Picturemodel.h"
 #include "Databasemanager.h"
 #include <memory>
-#include <vector>
+#include <utility>
+#include <QDataStream>
 #include <QFile>
+#include <QFileInfo>
+#include <QMimeData>
+#include <QSet>
 #include "AlbumModel.h"
+#include "MetadataExtractor.h"
+#include "DirectoryDao.h"
+#include "PerceptualHash.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "StartupSnapshot.h"
+#include "Trace.h"
 #include "qsqlerror.h"
 #include "qsqlquery.h"
 
+// Número de imágenes que se cargan por página desde la base de datos
+const int PICTURE_PAGE_SIZE = 256;
+
+// Número máximo de filas guardadas entre todas las instantáneas de álbumes
+// (unos pocos MB con PictureRows)
+const int SNAPSHOT_CACHE_ROWS = 50000;
+
+// Distancia máxima (bits distintos de 64) entre los hashes perceptuales de
+// dos imágenes para considerarlas parecidas
+const int SIMILAR_MAX_DISTANCE = 10;
+
+// Páginas que se cargan, como mucho, para mostrar la imagen añadida (o la
+// existente, si era un duplicado) cuando no está entre las filas cargadas
+const int PAGES_TO_FIND_PICTURE = 4;
+
 /**
  * Constructor de PictureModel
- * @param albumModel Referencia al modelo de álbumes para conectar señales
+ * @param albumModel Referencia al modelo de álbumes para conectar señales;
+ *                   el modelo usa su mismo catálogo (AlbumModel::database())
  * @param parent Objeto padre para la jerarquía de Qt (gestión automática de memoria)
  *
  * Inicializa el modelo de imágenes heredando de QAbstractListModel.
- * Configura la gestión de memoria usando smart pointers (unique_ptr) para
- * garantizar RAII y evitar fugas de memoria.
+ * Las filas se guardan en un PictureRows (vectores contiguos por campo), sin
+ * un objeto en el heap por cada imagen.
  *
  * Conecta la señal rowsRemoved del AlbumModel para eliminar automáticamente
  * las imágenes cuando se elimina un álbum, manteniendo la integridad referencial.
+ *
+ * Las instantáneas de álbumes se invalidan con las señales de CatalogNotifier.
  */
 PictureModel::PictureModel(const AlbumModel& albumModel, QObject* parent) :
     QAbstractListModel(parent),  // Llama al constructor de la clase base
-    mDb(DatabaseManager::instance()),  // Obtiene la instancia singleton del DatabaseManager
+    mDb(albumModel.database()),  // Mismo catálogo que el modelo de álbumes
     mAlbumId(-1),  // Inicializa con -1 indicando que no hay álbum seleccionado
-    // Inicializa el vector de imágenes usando make_unique para gestión automática de memoria
-    mPictures(std::make_unique<std::vector<std::unique_ptr<Picture>>>())
+    mMaxPictureId(0),
+    mHasMorePictures(false),
+    mShowingResults(false),
+    mResultOffset(0),
+    mSnapshots(SNAPSHOT_CACHE_ROWS),
+    mNotifyingChange(false)
 {
     // Conecta la señal de filas eliminadas del AlbumModel con el slot para eliminar imágenes
     // Cuando se elimina un álbum, automáticamente se eliminan sus imágenes asociadas
     connect(&albumModel, &AlbumModel::rowsRemoved,
             this, &PictureModel::deletePicturesForAlbum);
+
+    // Un álbum modificado o eliminado ya no puede restaurarse desde su instantánea
+    connect(&mDb.notifier, &CatalogNotifier::picturesChanged,
+            this, &PictureModel::onPicturesChanged);
+    connect(&mDb.notifier, &CatalogNotifier::picturesMoved,
+            this, &PictureModel::onPicturesMoved);
+    connect(&mDb.notifier, &CatalogNotifier::albumRemoved,
+            this, [this](int albumId) { mSnapshots.remove(albumId); });
+
+    // Con imágenes nuevas o modificadas el índice de similitud se reconstruye
+    // en la siguiente búsqueda
+    connect(&mDb.notifier, &CatalogNotifier::filesModified,
+            this, [this] { mSimilarityIndex.clear(); });
+
+    // Las rutas se construyen al vuelo (ver data()): tras reubicar una
+    // carpeta basta con que las vistas las vuelvan a pedir
+    connect(&mDb.notifier, &CatalogNotifier::directoriesRelocated, this, [this] {
+        if (rowCount() > 0) {
+            emit dataChanged(index(0, 0), index(rowCount() - 1, 0), { FilePathRole });
+        }
+    });
 }
 
 /**
@@ -39,7 +93,8 @@ PictureModel::PictureModel(const AlbumModel& albumModel, QObject* parent) :
  * @return QVariant con el dato solicitado, o QVariant vacío si el índice es inválido
  *
  * Esta función es llamada por las vistas (como ListView en QML) para mostrar los datos.
- * Actualmente solo retorna la ruta del archivo de la imagen.
+ * La ruta completa se construye al vuelo a partir de la carpeta (en caché en
+ * DirectoryDao) y del nombre guardado en la fila.
  */
 QVariant PictureModel::data(const QModelIndex& index, int role) const
 {
@@ -47,14 +102,16 @@ QVariant PictureModel::data(const QModelIndex& index, int role) const
     if (!index.isValid() || index.row() < 0 || index.row() >= rowCount())
         return QVariant();  // Retorna un QVariant vacío si es inválido
 
-    // Obtiene el puntero crudo (raw pointer) del unique_ptr en la posición especificada
-    const Picture* pic = mPictures->at(index.row()).get();
+    const int row = index.row();
 
     // Retorna el dato correspondiente según el rol solicitado
     switch (role) {
     case Qt::DisplayRole:      // Rol estándar de Qt para mostrar texto
+        return mRows.name(row).toString();  // Nombre del archivo
     case FilePathRole:         // Rol personalizado para la ruta del archivo
-        return pic->fileUrl(); // Retorna la URL del archivo de imagen
+        return filePath(row);  // Retorna la ruta local del archivo de imagen
+    case PictureIdRole:        // ID de la imagen en la base de datos
+        return mRows.id(row);
     default:
         return QVariant();     // Retorna vacío si el rol no es reconocido
     }
@@ -71,8 +128,150 @@ QVariant PictureModel::data(const QModelIndex& index, int role) const
 int PictureModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent)  // Marca el parámetro como no usado para evitar warnings
-    // Convierte size_t a int de forma segura usando static_cast
-    return static_cast<int>(mPictures->size());
+    return mRows.count();
+}
+
+/**
+ * Retorna las propiedades de un elemento del modelo
+ * @param index Índice del elemento
+ * @return Flags por defecto más ItemIsDragEnabled para las imágenes
+ *
+ * Las imágenes se pueden arrastrar sobre la lista de álbumes para moverlas
+ * o copiarlas (ver AlbumModel::dropMimeData).
+ */
+Qt::ItemFlags PictureModel::flags(const QModelIndex& index) const
+{
+    Qt::ItemFlags defaultFlags = QAbstractListModel::flags(index);
+    return index.isValid() ? defaultFlags | Qt::ItemIsDragEnabled : defaultFlags;
+}
+
+/**
+ * Retorna los tipos MIME que genera mimeData()
+ */
+QStringList PictureModel::mimeTypes() const
+{
+    return { PICTURE_IDS_MIME_TYPE };
+}
+
+/**
+ * Serializa las imágenes arrastradas
+ * @param indexes Índices de las imágenes seleccionadas
+ * @return QMimeData con los IDs de las imágenes y los álbumes de origen
+ *
+ * Solo viajan los IDs: el destino mueve o copia las filas en SQL sin
+ * volver a leer los archivos.
+ */
+QMimeData* PictureModel::mimeData(const QModelIndexList& indexes) const
+{
+    QVector<int> pictureIds;
+    QSet<int> albumIds;
+    pictureIds.reserve(indexes.count());
+    for (const QModelIndex& index : indexes) {
+        if (index.isValid() && index.row() < rowCount()) {
+            pictureIds.append(mRows.id(index.row()));
+            albumIds.insert(mRows.albumId(index.row()));
+        }
+    }
+
+    QByteArray encoded;
+    QDataStream stream(&encoded, QIODevice::WriteOnly);
+    stream << pictureIds << albumIds.values();
+
+    QMimeData* mimeData = new QMimeData();
+    mimeData->setData(PICTURE_IDS_MIME_TYPE, encoded);
+    return mimeData;
+}
+
+/**
+ * Acciones permitidas al arrastrar imágenes: mover (por defecto) o copiar
+ */
+Qt::DropActions PictureModel::supportedDragActions() const
+{
+    return Qt::MoveAction | Qt::CopyAction;
+}
+
+/**
+ * Indica si quedan imágenes del álbum por cargar desde la base de datos
+ * @param parent Índice padre (solo se pagina la raíz en modelos de lista)
+ * @return true si hay más páginas disponibles
+ *
+ * Las vistas llaman a esta función cuando el usuario se acerca al final
+ * del contenido cargado (por ejemplo, al hacer scroll).
+ */
+bool PictureModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return false;
+
+    return mHasMorePictures;
+}
+
+/**
+ * Carga la siguiente página de imágenes del álbum actual
+ * @param parent Índice padre (solo se pagina la raíz en modelos de lista)
+ *
+ * Consulta la base de datos a partir del último ID cargado y añade las
+ * filas al final del modelo notificando a las vistas con beginInsertRows,
+ * de modo que el ThumbnailProxyModel solo genera miniaturas de las nuevas filas.
+ */
+void PictureModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || !mHasMorePictures)
+        return;
+
+    // La página se lee en un almacén aparte: las filas no pueden aparecer en
+    // el modelo antes de beginInsertRows()
+    mPage.clear();
+    int count = fetchPage(mPage);
+
+    if (count == 0) {
+        return;
+    }
+
+    int firstRow = rowCount();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + count - 1);
+    mRows.append(mPage);
+    endInsertRows();
+}
+
+/**
+ * Consulta la siguiente página a partir del cursor actual
+ * @param rows Almacén al que se añaden las filas de la página
+ * @return Número de filas añadidas
+ *
+ * El DAO avanza el cursor de paginación hasta la última imagen recibida.
+ * Si la página viene incompleta, ya no quedan más imágenes por cargar.
+ */
+int PictureModel::fetchPage(PictureRows& rows)
+{
+    GALLERY_TRACE_SCOPE(lcModel, "fetchPage");
+
+    // Lista explícita: la página son los siguientes IDs de la lista
+    if (mShowingResults) {
+        QVector<int> page = mResultIds.mid(mResultOffset, PICTURE_PAGE_SIZE);
+        mResultOffset += page.count();
+        mHasMorePictures = mResultOffset < mResultIds.count();
+        return mDb.pictureDao.picturesByIds(page, rows);
+    }
+
+    int count = isSearchActive()
+        ? mDb.searchDao.searchPictures(mSearchText, mCursor, PICTURE_PAGE_SIZE, rows)
+        : mDb.pictureDao.picturesPage(mAlbumId, mQuery, mCursor, mMaxPictureId,
+                                      PICTURE_PAGE_SIZE, rows);
+
+    mHasMorePictures = count == PICTURE_PAGE_SIZE;
+    return count;
+}
+
+/**
+ * Construye la ruta local del archivo de una fila
+ * @param row Fila del modelo
+ * @return Ruta de la carpeta + nombre del archivo
+ */
+QString PictureModel::filePath(int row) const
+{
+    return DirectoryDao::joinPath(mDb.directoryDao.path(mRows.directoryId(row)),
+                                  mRows.name(row));
 }
 
 /**
@@ -96,10 +295,8 @@ bool PictureModel::removeRows(int row, int count, const QModelIndex& parent)
     // Notifica a las vistas que se van a eliminar filas
     beginRemoveRows(QModelIndex(), row, row + count - 1);
 
-    // Elimina el rango de elementos del vector usando iteradores
-    // Los unique_ptr se destruyen automáticamente, liberando la memoria
-    mPictures->erase(mPictures->begin() + row,
-                     mPictures->begin() + row + count);
+    // Elimina el rango de filas del almacén
+    mRows.remove(row, count);
 
     // Notifica a las vistas que la eliminación ha terminado
     endRemoveRows();
@@ -113,6 +310,11 @@ bool PictureModel::removeRows(int row, int count, const QModelIndex& parent)
  *
  * La imagen se asocia automáticamente al álbum actualmente seleccionado (mAlbumId).
  * Si no hay álbum seleccionado (mAlbumId <= 0), la operación falla.
+ *
+ * Con el orden por defecto (importación) la imagen nueva va al final. Con
+ * otro orden o con filtros, su posición (y si se muestra) la decide la
+ * consulta: se recarga la primera página y se retorna su índice si está en
+ * las primeras páginas, o un índice inválido si la consulta la filtra.
  */
 QModelIndex PictureModel::addPicture(const Picture& picture)
 {
@@ -125,9 +327,39 @@ QModelIndex PictureModel::addPicture(const Picture& picture)
     // Asocia la imagen al álbum actual
     pic.setAlbumId(mAlbumId);
 
+    // Extrae los metadatos del archivo si no vienen ya rellenados
+    if (pic.metadata().byteSize == 0) {
+        pic.setMetadata(MetadataExtractor::extract(pic.filePath()));
+    }
+
+    // Si el álbum ya contiene una imagen con el mismo contenido no se duplica;
+    // el hash, si se ha tenido que calcular, se guarda con la imagen
+    PictureMetadata metadata = pic.metadata();
+    bool inAlbum = false;
+    int existingId = mDb.pictureDao.findByContent(pic.filePath(), metadata, mAlbumId, &inAlbum);
+    if (existingId > 0 && inAlbum) {
+        return indexForPictureId(existingId, PAGES_TO_FIND_PICTURE);
+    }
+
+    // Hash perceptual para "mostrar similares" (decodifica a tamaño mínimo)
+    if (metadata.perceptualHash == 0) {
+        metadata.perceptualHash = PerceptualHash::file(pic.filePath());
+    }
+    pic.setMetadata(metadata);
+
     // GUARDAR EN BASE DE DATOS
     // Inserta la imagen en la base de datos y actualiza su ID
     mDb.pictureDao.addPictureInAlbum(mAlbumId, pic);
+    mNotifyingChange = true;
+    emit mDb.notifier.picturesChanged(mAlbumId);
+    mNotifyingChange = false;
+
+    if (mQuery != PictureQuery()) {
+        beginResetModel();
+        loadPictures(mAlbumId);
+        endResetModel();
+        return indexForPictureId(pic.id(), PAGES_TO_FIND_PICTURE);
+    }
 
     // Obtiene la posición donde se insertará (al final)
     int newRow = rowCount();
@@ -135,9 +367,11 @@ QModelIndex PictureModel::addPicture(const Picture& picture)
     // Notifica a las vistas que se va a insertar una fila
     beginInsertRows(QModelIndex(), newRow, newRow);
 
-    // Crea un unique_ptr con la imagen y lo añade al vector
-    // make_unique garantiza la gestión automática de memoria
-    mPictures->push_back(std::make_unique<Picture>(pic));
+    // Añade la fila al almacén; la carpeta ya está en la caché de DirectoryDao
+    QFileInfo fileInfo(pic.filePath());
+    mRows.append(pic.id(), mAlbumId,
+                 mDb.directoryDao.directoryIdForPath(fileInfo.absolutePath()),
+                 fileInfo.fileName());
 
     // Notifica a las vistas que la inserción ha terminado
     endInsertRows();
@@ -146,47 +380,98 @@ QModelIndex PictureModel::addPicture(const Picture& picture)
 }
 
 /**
- * Carga todas las imágenes asociadas a un álbum específico desde la base de datos
+ * Guarda el álbum actual como instantánea en la caché LRU
+ *
+ * Las filas se mueven a la instantánea, sin copiarse. Los resultados de
+ * búsqueda no se guardan.
+ */
+void PictureModel::saveSnapshot()
+{
+    if (mAlbumId <= 0 || isSearchActive()) {
+        return;
+    }
+
+    AlbumSnapshot* snapshot = new AlbumSnapshot{
+        std::move(mRows), mQuery, mCursor, mMaxPictureId, mHasMorePictures };
+    mRows = PictureRows();
+
+    // QCache toma la propiedad de la instantánea (y la libera si no cabe)
+    mSnapshots.insert(mAlbumId, snapshot, snapshot->rows.count() + 1);
+    GALLERY_METRIC_SET("model.snapshots.rows", mSnapshots.totalCost());
+}
+
+/**
+ * Restaura un álbum desde su instantánea
+ * @param albumId ID del álbum a restaurar
+ * @return true si había una instantánea válida para el álbum y el orden actual
+ *
+ * La instantánea sale de la caché: mientras el álbum está abierto, sus filas
+ * viven en el modelo.
+ */
+bool PictureModel::restoreSnapshot(int albumId)
+{
+    GALLERY_TRACE_SCOPE(lcModel, "restoreSnapshot");
+
+    AlbumSnapshot* cached = mSnapshots.object(albumId);
+    if (!cached || cached->query != mQuery) {
+        GALLERY_METRIC_ADD("model.snapshots.misses", 1);
+        return false;
+    }
+
+    GALLERY_METRIC_ADD("model.snapshots.hits", 1);
+    std::unique_ptr<AlbumSnapshot> snapshot(mSnapshots.take(albumId));
+    GALLERY_METRIC_SET("model.snapshots.rows", mSnapshots.totalCost());
+    mRows = std::move(snapshot->rows);
+    mCursor = snapshot->cursor;
+    mMaxPictureId = snapshot->maxPictureId;
+    mHasMorePictures = snapshot->hasMorePictures;
+    return true;
+}
+
+/**
+ * Carga la primera página de imágenes de un álbum específico desde la base de datos
  * @param albumId ID del álbum cuyas imágenes se desean cargar
  *
- * Esta función reemplaza completamente el contenido actual del modelo con las
- * imágenes del álbum especificado. Si el albumId es inválido (<=0), limpia
- * todas las imágenes del modelo.
+ * Esta función reemplaza completamente el contenido actual del modelo con la
+ * primera página de imágenes del álbum especificado. Si el albumId es inválido
+ * (<=0), limpia todas las imágenes del modelo.
  *
- * Convierte el QVector<Picture*> retornado por el DAO a std::vector<std::unique_ptr<Picture>>
- * para una gestión de memoria más segura con RAII.
+ * El resto de páginas se cargan bajo demanda mediante fetchMore(). El cursor
+ * queda acotado por el ID máximo del álbum en el momento de abrirlo, de modo que
+ * las imágenes añadidas después con addPicture() no se cargan dos veces.
  */
 void PictureModel::loadPictures(int albumId)
 {
-    qDebug() << "=== PictureModel::loadPictures ===";
-    qDebug() << "albumId:" << albumId;
+    GALLERY_TRACE_SCOPE(lcModel, "loadPictures");
+    qCDebug(lcModel) << "loadPictures:" << albumId;
+
+    // Vacía el almacén (conservando su memoria) y reinicia el cursor de paginación
+    mRows.clear();
+    mCursor = PictureCursor();
+    mMaxPictureId = 0;
+    mHasMorePictures = false;
+
+    // Álbum virtual de resultados de búsqueda o lista de imágenes
+    if (isSearchActive()) {
+        mResultOffset = 0;
+        fetchPage(mRows);
+        return;
+    }
 
-    // Si el albumId es inválido, limpia el modelo
+    // Si el albumId es inválido, el modelo queda vacío
     if (albumId <= 0) {
-        // Crea un nuevo vector vacío
-        mPictures = std::make_unique<std::vector<std::unique_ptr<Picture>>>();
-        qDebug() << "albumId inválido, limpiando pictures";
         return;
     }
 
-    // Obtiene las imágenes del álbum desde el DAO
-    // Retorna QVector<Picture*> (punteros crudos)
-    QVector<Picture*> picturesFromDao = mDb.pictureDao.picturesForAlbum(albumId);
-    qDebug() << "Pictures obtenidas del DAO:" << picturesFromDao.count();
-
-    // Crea un nuevo vector para almacenar las imágenes con unique_ptr
-    auto newPictures = std::make_unique<std::vector<std::unique_ptr<Picture>>>();
-
-    // Convierte cada puntero crudo a unique_ptr
-    // Transfiere la propiedad de la memoria a los unique_ptr
-    for (Picture* p : picturesFromDao) {
-        newPictures->push_back(std::unique_ptr<Picture>(p));
+    // Fija el límite superior de la paginación
+    mMaxPictureId = mDb.pictureDao.lastPictureIdForAlbum(albumId);
+    if (mMaxPictureId <= 0) {
+        return;  // Álbum vacío
     }
 
-    // Mueve el nuevo vector al miembro de la clase
-    // std::move transfiere la propiedad, el vector anterior se destruye automáticamente
-    mPictures = std::move(newPictures);
-    qDebug() << "Total pictures cargadas:" << mPictures->size();
+    // Carga solo la primera página; el resto llega con fetchMore()
+    fetchPage(mRows);
+    qCDebug(lcModel) << "Primera página cargada:" << mRows.count();
 }
 
 /**
@@ -205,26 +490,25 @@ void PictureModel::removePicture(int row)
     // Valida que el índice esté dentro del rango
     if (row < 0 || row >= rowCount()) return;
 
-    // Obtiene el puntero crudo del unique_ptr
-    Picture* p = mPictures->at(row).get();
-    if (p) {
-        // 1. Borrar archivo físico del disco
-        QFile file(p->fileUrl().toLocalFile());  // Convierte URL a ruta local
-        if (file.exists()) {
-            file.remove();  // Elimina el archivo del sistema de archivos
-        }
-
-        // 2. Borrar registro de la base de datos usando PictureDao
-        mDb.pictureDao.removePicture(p->id());
+    // 1. Borrar archivo físico del disco
+    // Si la imagen se copió a otro álbum, el archivo se conserva para la copia
+    QFile file(filePath(row));  // Ruta local del archivo
+    if (file.exists() && !mDb.pictureDao.isFileShared(mRows.id(row))) {
+        file.remove();  // Elimina el archivo del sistema de archivos
     }
 
+    // 2. Borrar registro de la base de datos usando PictureDao
+    mDb.pictureDao.removePicture(mRows.id(row));
+    mNotifyingChange = true;
+    emit mDb.notifier.picturesChanged(mRows.albumId(row));
+    mNotifyingChange = false;
+
     // 3. Borrar del modelo (lista en memoria)
     // Notifica a las vistas del cambio
     beginRemoveRows(QModelIndex(), row, row);
 
-    // Elimina el unique_ptr del vector
-    // El unique_ptr se destruye automáticamente y libera la memoria del objeto Picture
-    mPictures->erase(mPictures->begin() + row);
+    // Elimina la fila del almacén
+    mRows.remove(row);
 
     // Notifica a las vistas que la eliminación ha terminado
     endRemoveRows();
@@ -240,24 +524,245 @@ void PictureModel::removePicture(int row)
  *
  * Usa beginResetModel/endResetModel para notificar a las vistas que
  * el contenido del modelo ha cambiado completamente.
+ *
+ * El álbum anterior se guarda como instantánea; si el nuevo álbum se ha
+ * visitado hace poco y no ha cambiado, se restaura sin ninguna consulta SQL.
  */
 void PictureModel::setAlbumId(int albumId)
 {
-    qDebug() << "PictureModel::setAlbumId:" << albumId;
+    GALLERY_TRACE_SCOPE(lcModel, "setAlbumId");
+    qCDebug(lcModel) << "setAlbumId:" << albumId;
 
     // Notifica a las vistas que el modelo va a cambiar completamente
     beginResetModel();
 
-    // Actualiza el ID del álbum activo
+    // Guarda el álbum que se abandona
+    saveSnapshot();
+
+    // Actualiza el ID del álbum activo y sale del modo búsqueda
     mAlbumId = albumId;
+    mSearchText.clear();
+    mShowingResults = false;
+    mResultIds.clear();
 
-    // Carga las imágenes del nuevo álbum
-    loadPictures(mAlbumId);
+    // Restaura las imágenes del nuevo álbum o las carga de la base de datos
+    if (!restoreSnapshot(mAlbumId)) {
+        loadPictures(mAlbumId);
+    }
 
     // Notifica a las vistas que el modelo ha terminado de cambiar
     endResetModel();
 }
 
+/**
+ * Cambia el orden y los filtros de las imágenes del álbum actual
+ * @param query Criterios de ordenación y filtrado
+ *
+ * La ordenación y el filtrado se resuelven en SQL (PictureDao::picturesPage),
+ * por lo que el modelo simplemente vuelve a cargar la primera página en el
+ * nuevo orden. Las vistas deben restaurar su selección con indexForPictureId().
+ */
+void PictureModel::setQuery(const PictureQuery& query)
+{
+    beginResetModel();
+    mQuery = query;
+    loadPictures(mAlbumId);
+    endResetModel();
+}
+
+/**
+ * Retorna los criterios de ordenación y filtrado actuales
+ */
+const PictureQuery& PictureModel::query() const
+{
+    return mQuery;
+}
+
+/**
+ * Busca la fila de una imagen por su ID
+ * @param pictureId ID de la imagen en la base de datos
+ * @param maxPagesToFetch Número máximo de páginas adicionales a cargar si la
+ *                        imagen todavía no está entre las filas cargadas
+ * @return QModelIndex de la imagen, o índice inválido si no se encuentra
+ */
+QModelIndex PictureModel::indexForPictureId(int pictureId, int maxPagesToFetch)
+{
+    // Cada página solo se busca una vez: a partir de la primera fila nueva
+    int from = 0;
+    for (;;) {
+        int row = mRows.indexOf(pictureId, from);
+        if (row >= 0) {
+            return index(row, 0);
+        }
+        if (maxPagesToFetch-- <= 0 || !canFetchMore(QModelIndex())) {
+            break;
+        }
+        from = rowCount();
+        fetchMore(QModelIndex());
+    }
+
+    return QModelIndex();
+}
+
+/**
+ * Muestra los resultados de una búsqueda como un álbum virtual
+ * @param text Texto de búsqueda; si está vacío se sale del modo búsqueda
+ *
+ * Los resultados se obtienen del índice FTS5 (SearchDao) y se paginan igual
+ * que un álbum normal, por lo que el ThumbnailProxyModel y las vistas
+ * existentes los muestran sin cambios. Mientras la búsqueda está activa no
+ * hay álbum seleccionado y addPicture() no está disponible.
+ */
+void PictureModel::setSearchText(const QString& text)
+{
+    beginResetModel();
+    saveSnapshot();
+    mSearchText = text.trimmed();
+    mShowingResults = false;
+    mResultIds.clear();
+    mAlbumId = -1;
+    loadPictures(mAlbumId);
+    endResetModel();
+}
+
+/**
+ * Muestra una lista de imágenes como un álbum virtual
+ * @param pictureIds IDs de las imágenes, en el orden en que se mostrarán
+ *
+ * Igual que los resultados de búsqueda: se paginan con fetchMore() y no hay
+ * álbum seleccionado mientras se muestran.
+ */
+void PictureModel::showPictures(const QVector<int>& pictureIds)
+{
+    beginResetModel();
+    saveSnapshot();
+    mSearchText.clear();
+    mResultIds = pictureIds;
+    mShowingResults = true;
+    mAlbumId = -1;
+    loadPictures(mAlbumId);
+    endResetModel();
+}
+
+/**
+ * Muestra las imágenes duplicadas del catálogo como un álbum virtual
+ * @return Número de grupos de duplicados encontrados
+ *
+ * Las imágenes de cada grupo aparecen seguidas (ver PictureDao::duplicateGroups).
+ */
+int PictureModel::showDuplicates()
+{
+    const QVector<QVector<int>> groups = mDb.pictureDao.duplicateGroups();
+
+    QVector<int> pictureIds;
+    for (const QVector<int>& group : groups) {
+        pictureIds += group;
+    }
+    showPictures(pictureIds);
+    return groups.count();
+}
+
+/**
+ * Muestra las imágenes parecidas a una imagen como un álbum virtual
+ * @param pictureId ID de la imagen de referencia (aparece la primera)
+ * @return Número de imágenes parecidas encontradas, sin contar la de referencia
+ *
+ * El índice de similitud (SimilarityIndex) se construye con los hashes del
+ * catálogo la primera vez y se conserva hasta que cambian las imágenes, así
+ * que las búsquedas siguientes solo consultan memoria.
+ */
+int PictureModel::showSimilar(int pictureId)
+{
+    GALLERY_TRACE_SCOPE(lcModel, "showSimilar");
+
+    QVector<int> pictureIds;
+    quint64 hash = mDb.pictureDao.perceptualHash(pictureId);
+    if (hash != 0) {
+        if (mSimilarityIndex.isEmpty()) {
+            QVector<quint64> hashes;
+            mDb.pictureDao.perceptualHashes(pictureIds, hashes);
+            mSimilarityIndex.build(pictureIds, hashes);
+        }
+        pictureIds = mSimilarityIndex.search(hash, SIMILAR_MAX_DISTANCE);
+        pictureIds.removeAll(pictureId);
+    }
+
+    int similarCount = pictureIds.count();
+    pictureIds.prepend(pictureId);
+    showPictures(pictureIds);
+    return similarCount;
+}
+
+/**
+ * Guarda en la instantánea de arranque las filas cargadas del álbum actual
+ * @param snapshot Instantánea a rellenar
+ *
+ * Solo se guardan con el orden y los filtros por defecto, que son los que
+ * tendrá el modelo al arrancar; en otro caso solo se guarda el álbum.
+ */
+void PictureModel::saveStartupState(StartupSnapshot& snapshot) const
+{
+    snapshot.albumId = isSearchActive() ? -1 : mAlbumId;
+    if (snapshot.albumId <= 0 || mQuery != PictureQuery()) {
+        return;
+    }
+
+    snapshot.rows = mRows;
+    snapshot.cursor = mCursor;
+    snapshot.maxPictureId = mMaxPictureId;
+    snapshot.hasMorePictures = mHasMorePictures;
+}
+
+/**
+ * Prepara las filas de la instantánea de arranque
+ * @param snapshot Instantánea leída al arrancar
+ *
+ * Las filas se guardan como instantánea del álbum (ver saveSnapshot), así que
+ * al seleccionarlo con setAlbumId() se muestran sin consultar la base de datos.
+ */
+void PictureModel::restoreStartupState(const StartupSnapshot& snapshot)
+{
+    if (snapshot.albumId <= 0 || snapshot.rows.isEmpty()) {
+        return;
+    }
+
+    AlbumSnapshot* albumSnapshot = new AlbumSnapshot{
+        snapshot.rows, PictureQuery(), snapshot.cursor,
+        snapshot.maxPictureId, snapshot.hasMorePictures };
+    mSnapshots.insert(snapshot.albumId, albumSnapshot, albumSnapshot->rows.count() + 1);
+}
+
+/**
+ * Descarta lo que el modelo sabe de un álbum y, si es el actual, lo recarga
+ * @param albumId Álbum cuyas imágenes han cambiado sin pasar por CatalogNotifier
+ *                (por ejemplo, al comprobar la instantánea de arranque)
+ */
+void PictureModel::invalidateAlbum(int albumId)
+{
+    onPicturesChanged(albumId);
+}
+
+/**
+ * Indica si el modelo muestra un álbum virtual (resultados de búsqueda o
+ * una lista de imágenes) en lugar de un álbum real
+ */
+bool PictureModel::isSearchActive() const
+{
+    return !mSearchText.isEmpty() || mShowingResults;
+}
+
+/**
+ * Retorna las extensiones de archivo presentes en el álbum actual
+ * Útil para poblar los filtros de la interfaz.
+ */
+QStringList PictureModel::availableExtensions() const
+{
+    if (mAlbumId <= 0)
+        return QStringList();
+
+    return mDb.pictureDao.extensionsForAlbum(mAlbumId);
+}
+
 /**
  * Añade una imagen a un álbum específico en la base de datos
  * @param albumId ID del álbum al que se añadirá la imagen
@@ -271,31 +776,97 @@ void PictureModel::setAlbumId(int albumId)
  */
 void PictureDao::addPictureInAlbum(int albumId, Picture& picture) const
 {
-    // Crea un objeto query para la base de datos
-    QSqlQuery query(mDatabase);
+    GALLERY_METRIC_TIMER("db.addPicture.us");
 
     // Prepara la consulta SQL INSERT con parámetros nombrados
-    query.prepare(
-        "INSERT INTO pictures (album_id, url) "
-        "VALUES (:albumId, :url)"
+    CachedQuery query = mStatements.prepared(
+        "INSERT INTO pictures (album_id, directory_id, name, extension, width, height, "
+        "byte_size, modified_at, taken_at, mime_type, file_id, content_hash, phash) "
+        "VALUES (:albumId, :directoryId, :name, :extension, :width, :height, "
+        ":byteSize, :modifiedAt, :takenAt, :mimeType, :fileId, :contentHash, :perceptualHash)"
         );
 
     // Vincula el ID del álbum al parámetro :albumId
-    query.bindValue(":albumId", albumId);
-
-    // Vincula la URL de la imagen al parámetro :url
-    // Convierte QUrl a QString para almacenar en la base de datos
-    query.bindValue(":url", picture.fileUrl().toString());
+    query->bindValue(":albumId", albumId);
+
+    // La ruta se guarda como carpeta (compartida entre imágenes) + nombre
+    QFileInfo fileInfo(picture.filePath());
+    query->bindValue(":directoryId", mDirectoryDao.directoryIdForPath(fileInfo.absolutePath()));
+
+    // Nombre y extensión se guardan aparte para poder ordenar y filtrar en SQL
+    query->bindValue(":name", fileInfo.fileName());
+    query->bindValue(":extension", fileInfo.suffix().toLower());
+
+    // Vincula los metadatos extraídos al importar
+    const PictureMetadata& metadata = picture.metadata();
+    query->bindValue(":width", metadata.width);
+    query->bindValue(":height", metadata.height);
+    query->bindValue(":byteSize", metadata.byteSize);
+    query->bindValue(":modifiedAt", metadata.modifiedAt);
+    query->bindValue(":takenAt", metadata.takenAt);
+    query->bindValue(":mimeType", metadata.mimeType);
+    query->bindValue(":fileId", qint64(metadata.fileId));
+    query->bindValue(":contentHash", qint64(metadata.contentHash));
+    query->bindValue(":perceptualHash", qint64(metadata.perceptualHash));
 
     // Ejecuta la consulta INSERT y verifica si tuvo éxito
-    if (!query.exec()) {
+    if (!query->exec()) {
         // Si falla, muestra el error en la consola de debug
-        qDebug() << "Error insertando picture:" << query.lastError();
+        qDebug() << "Error insertando picture:" << query->lastError();
         return;
     }
 
     // Actualiza el ID de la imagen con el valor generado automáticamente
-    picture.setId(query.lastInsertId().toInt());
+    picture.setId(query->lastInsertId().toInt());
+}
+
+/**
+ * Reacciona a un cambio en las imágenes de un álbum
+ * @param albumId ID del álbum modificado
+ *
+ * Invalida la instantánea del álbum. Si el cambio lo ha hecho otro componente
+ * y afecta a lo que se está mostrando, recarga la vista con un único reset
+ * del modelo; los thumbnails se reutilizan desde la caché del ThumbnailProxyModel.
+ */
+void PictureModel::onPicturesChanged(int albumId)
+{
+    mSnapshots.remove(albumId);
+    mSimilarityIndex.clear();
+
+    if (mNotifyingChange) {
+        return;
+    }
+
+    if (albumId == mAlbumId || isSearchActive()) {
+        beginResetModel();
+        loadPictures(mAlbumId);
+        endResetModel();
+    }
+}
+
+/**
+ * Reacciona a imágenes movidas o copiadas entre álbumes
+ * @param targetAlbumId ID del álbum de destino
+ * @param sourceAlbumIds IDs de los álbumes de origen (vacío si se han copiado)
+ *
+ * Invalida las instantáneas de todos los álbumes afectados y recarga la vista
+ * una sola vez si muestra alguno de ellos (o resultados de búsqueda).
+ *
+ * El reset es síncrono: limpia la selección de la vista antes de que termine
+ * el arrastre, de modo que QAbstractItemView no intenta eliminar las filas movidas.
+ */
+void PictureModel::onPicturesMoved(int targetAlbumId, const QList<int>& sourceAlbumIds)
+{
+    mSnapshots.remove(targetAlbumId);
+    for (int albumId : sourceAlbumIds) {
+        mSnapshots.remove(albumId);
+    }
+
+    if (targetAlbumId == mAlbumId || sourceAlbumIds.contains(mAlbumId) || isSearchActive()) {
+        beginResetModel();
+        loadPictures(mAlbumId);
+        endResetModel();
+    }
 }
 
 /**
@@ -304,8 +875,7 @@ void PictureDao::addPictureInAlbum(int albumId, Picture& picture) const
  * Esta función se llama automáticamente cuando se elimina un álbum
  * (conectada mediante signal/slot en el constructor).
  *
- * Limpia completamente el modelo de imágenes, destruyendo todos los
- * unique_ptr y liberando la memoria automáticamente gracias a RAII.
+ * Limpia completamente el modelo de imágenes.
  *
  * NOTA: Solo elimina del modelo en memoria, NO elimina de la base de datos
  * ni del sistema de archivos. La eliminación en cascada de la BD debe
@@ -316,9 +886,9 @@ void PictureModel::deletePicturesForAlbum()
     // Notifica a las vistas que el modelo va a cambiar completamente
     beginResetModel();
 
-    // Limpia el vector de imágenes
-    // Los unique_ptr se destruyen automáticamente, liberando toda la memoria
-    mPictures->clear();
+    // Limpia el almacén de filas
+    mRows.clear();
+    mHasMorePictures = false;
 
     // Notifica a las vistas que el modelo ha terminado de cambiar
     endResetModel();
@@ -375,4 +945,18 @@ void PictureModel::deletePicturesForAlbum()
  *    - La memoria se libera automáticamente cuando los objetos salen de scope
  *    - Elimina la necesidad de llamadas manuales a delete
  *    - Previene fugas de memoria y errores de doble liberación
+ *
+ * 7. Almacenamiento compacto (PictureRows):
+ *    ANTES:
+ *    std::unique_ptr<std::vector<std::unique_ptr<Picture>>> mPictures
+ *
+ *    AHORA:
+ *    PictureRows mRows
+ *
+ *    - Un vector contiguo por campo (id, álbum, carpeta) en lugar de un
+ *      Picture en el heap por fila, cada uno con su propia ruta
+ *    - Los nombres de archivo comparten una única cadena; la carpeta es un id
+ *    - Los DAOs rellenan el almacén directamente, sin Picture intermedios
+ *    - Cambiar de álbum reutiliza la memoria ya reservada
+ *    - Unos 16 bytes por fila más el nombre, frente a cientos antes
  */
@@ -1,12 +1,21 @@
-#include <memory>
-#include <vector>
+#ifndef PICTUREMODEL_H
+#define PICTUREMODEL_H
+
 #include <QAbstractListModel>
+#include <QCache>
 #include "gallerycore_global.h"
 #include "Picture.h"
+#include "PictureQuery.h"
+#include "PictureRows.h"
+#include "SimilarityIndex.h"
+
+// Tipo MIME de las imágenes arrastradas entre vistas (lista de IDs)
+const QString PICTURE_IDS_MIME_TYPE = "application/x-gallery-picture-ids";
 
 class Album;
 class DatabaseManager;
 class AlbumModel;
+class StartupSnapshot;
 
 class GALLERYCORE_EXPORT PictureModel : public QAbstractListModel
 {
@@ -14,7 +23,8 @@ class GALLERYCORE_EXPORT PictureModel : public QAbstractListModel
 public:
 
     enum PictureRole{
-        FilePathRole = Qt::UserRole + 1
+        FilePathRole = Qt::UserRole + 1,
+        PictureIdRole
     };
 
     PictureModel (const AlbumModel& albumModel, QObject* parent = 0);
@@ -26,19 +36,87 @@ public:
     void removePicture(int row);
     void setAlbumId(int albumId);
     void clearAlbum();
+    void setQuery(const PictureQuery& query);
+    const PictureQuery& query() const;
+    QModelIndex indexForPictureId(int pictureId, int maxPagesToFetch = 0);
+    QStringList availableExtensions() const;
+    void setSearchText(const QString& text);
+    void showPictures(const QVector<int>& pictureIds);
+    int showDuplicates();
+    int showSimilar(int pictureId);
+    bool isSearchActive() const;
+    void saveStartupState(StartupSnapshot& snapshot) const;
+    void restoreStartupState(const StartupSnapshot& snapshot);
+    void invalidateAlbum(int albumId);
     bool removeRows(int row, int count, const QModelIndex& parent) override;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QStringList mimeTypes() const override;
+    QMimeData* mimeData(const QModelIndexList& indexes) const override;
+    Qt::DropActions supportedDragActions() const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
 public slots:
     void deletePicturesForAlbum();
 
+private slots:
+    void onPicturesChanged(int albumId);
+    void onPicturesMoved(int targetAlbumId, const QList<int>& sourceAlbumIds);
+
 private:
+    // Estado completo de un álbum ya cargado, para volver a él sin consultar SQL
+    struct AlbumSnapshot
+    {
+        PictureRows rows;
+        PictureQuery query;
+        PictureCursor cursor;
+        int maxPictureId;
+        bool hasMorePictures;
+    };
+
+    void saveSnapshot();
+    bool restoreSnapshot(int albumId);
     void loadPictures(int albumId);
+    int fetchPage(PictureRows& rows);
+    QString filePath(int row) const;
     bool isIndexValid(const QModelIndex& index) const;
 
     DatabaseManager& mDb;
     int mAlbumId;
-    std::unique_ptr<std::vector<std::unique_ptr<Picture>>> mPictures;
+    PictureRows mRows;
+
+    // Página temporal para fetchMore(); se reutiliza para no reservar memoria
+    // en cada página
+    PictureRows mPage;
+
+    // Orden, filtros y estado del cursor de paginación
+    PictureQuery mQuery;
+    PictureCursor mCursor;
+    int mMaxPictureId;
+    bool mHasMorePictures;
+
+    // Texto de búsqueda; si no está vacío el modelo muestra el álbum
+    // virtual de resultados en lugar de un álbum real
+    QString mSearchText;
+
+    // Lista explícita de imágenes (duplicados, similares) mostrada como álbum
+    // virtual; mResultOffset es la posición de la siguiente página
+    QVector<int> mResultIds;
+    bool mShowingResults;
+    int mResultOffset;
+
+    // Hashes perceptuales del catálogo; vacío hasta la primera búsqueda de
+    // imágenes parecidas y cada vez que cambian las imágenes
+    SimilarityIndex mSimilarityIndex;
+
+    // Últimos álbumes visitados (LRU); el coste de cada entrada es su número de filas
+    QCache<int, AlbumSnapshot> mSnapshots;
+
+    // true mientras el propio modelo notifica un cambio que ya ha aplicado
+    bool mNotifyingChange;
 
 };
+
+#endif // PICTUREMODEL_H
@@ -0,0 +1,350 @@
+#include "ProfiledQuery.h"
+#include <algorithm>
+#include <atomic>
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QStringList>
+#include "Metrics.h"
+#include "Trace.h"
+
+// Umbral por defecto de consulta lenta (GALLERY_SLOW_QUERY_MS)
+const int DEFAULT_SLOW_QUERY_MS = 50;
+
+namespace {
+
+std::atomic<int> slowQueryMs { DEFAULT_SLOW_QUERY_MS };
+
+struct ProfilerState
+{
+    QMutex mutex;
+    QHash<QString, QueryStats> statements;
+    QString statsPath;
+};
+
+ProfilerState& profilerState()
+{
+    static ProfilerState state;
+    return state;
+}
+
+}
+
+/**
+ * Constructor de ProfiledQuery
+ * @param database Conexión; si no es válida se usa la conexión por defecto,
+ *        igual que QSqlQuery
+ */
+ProfiledQuery::ProfiledQuery(const QSqlDatabase& database) :
+    QSqlQuery(database),
+    mDatabase(database.isValid() ? database : QSqlDatabase::database()),
+    mElapsedNs(0),
+    mRows(0),
+    mActive(false)
+{
+}
+
+/**
+ * Constructor que ejecuta la sentencia directamente, como el de QSqlQuery
+ */
+ProfiledQuery::ProfiledQuery(const QString& sql, const QSqlDatabase& database) :
+    ProfiledQuery(database)
+{
+    exec(sql);
+}
+
+/**
+ * Destructor: suma la ejecución pendiente, si la hay
+ */
+ProfiledQuery::~ProfiledQuery()
+{
+    complete();
+}
+
+/**
+ * Prepara una sentencia (la ejecución anterior se da por terminada)
+ */
+bool ProfiledQuery::prepare(const QString& sql)
+{
+    complete();
+    return QSqlQuery::prepare(sql);
+}
+
+/**
+ * Ejecuta la sentencia preparada
+ */
+bool ProfiledQuery::exec()
+{
+    complete();
+    mTimer.start();
+    bool success = QSqlQuery::exec();
+    mElapsedNs = mTimer.nsecsElapsed();
+    return checkResult(success);
+}
+
+/**
+ * Ejecuta una sentencia sin preparar
+ */
+bool ProfiledQuery::exec(const QString& sql)
+{
+    complete();
+    mTimer.start();
+    bool success = QSqlQuery::exec(sql);
+    mElapsedNs = mTimer.nsecsElapsed();
+    return checkResult(success);
+}
+
+/**
+ * Avanza a la siguiente fila, sumando el tiempo que tarda SQLite en calcularla
+ */
+bool ProfiledQuery::next()
+{
+    if (!mActive) {
+        return QSqlQuery::next();
+    }
+
+    mTimer.start();
+    bool hasRow = QSqlQuery::next();
+    mElapsedNs += mTimer.nsecsElapsed();
+    if (hasRow) {
+        ++mRows;
+    } else {
+        complete();
+    }
+    return hasRow;
+}
+
+/**
+ * Termina la ejecución (libera el cursor) y la suma a las estadísticas
+ */
+void ProfiledQuery::finish()
+{
+    complete();
+    QSqlQuery::finish();
+}
+
+/**
+ * Registra el resultado de exec()
+ * @return El mismo resultado, para devolverlo al DAO
+ *
+ * Las sentencias que no devuelven filas, y las que fallan, terminan aquí; las
+ * SELECT siguen abiertas hasta que se leen todas sus filas.
+ */
+bool ProfiledQuery::checkResult(bool success)
+{
+    mRows = 0;
+    mActive = true;
+
+    if (!success) {
+        qCWarning(lcDatabase).noquote() << "Error SQL:" << lastError().text()
+                                        << "en" << lastQuery();
+        mActive = false;
+        QueryProfiler::record(lastQuery(), mElapsedNs, 0, true, mDatabase, QVariantList());
+    } else if (!isSelect()) {
+        complete();
+    }
+    return success;
+}
+
+/**
+ * Suma la ejecución en curso a las estadísticas de su sentencia
+ */
+void ProfiledQuery::complete()
+{
+    if (!mActive) {
+        return;
+    }
+    mActive = false;
+
+    const qint64 rows = isSelect() ? mRows : numRowsAffected();
+
+    // Los valores solo hacen falta para calcular el plan de una consulta lenta
+    const bool slow = mElapsedNs >= qint64(QueryProfiler::slowQueryThreshold()) * 1000000;
+    QueryProfiler::record(lastQuery(), mElapsedNs, rows, false, mDatabase,
+                          slow ? boundValues() : QVariantList());
+}
+
+/**
+ * Configura el perfil según las variables de entorno
+ *
+ * GALLERY_SLOW_QUERY_MS fija el umbral de consulta lenta y, si
+ * GALLERY_SQL_STATS indica un archivo, las estadísticas se escriben en él al
+ * destruir la QCoreApplication.
+ */
+void QueryProfiler::startFromEnvironment()
+{
+    bool ok = false;
+    int threshold = qEnvironmentVariableIntValue("GALLERY_SLOW_QUERY_MS", &ok);
+    if (ok && threshold > 0) {
+        setSlowQueryThreshold(threshold);
+    }
+
+    ProfilerState& state = profilerState();
+    QMutexLocker locker(&state.mutex);
+    if (!state.statsPath.isEmpty()) {
+        return;
+    }
+    state.statsPath = qEnvironmentVariable("GALLERY_SQL_STATS");
+    if (!state.statsPath.isEmpty()) {
+        qAddPostRoutine([] { QueryProfiler::writeJson(profilerState().statsPath); });
+    }
+}
+
+/**
+ * Fija el umbral a partir del cual una ejecución es una consulta lenta
+ */
+void QueryProfiler::setSlowQueryThreshold(int milliseconds)
+{
+    slowQueryMs.store(qMax(1, milliseconds), std::memory_order_relaxed);
+}
+
+/**
+ * Umbral de consulta lenta, en ms
+ */
+int QueryProfiler::slowQueryThreshold()
+{
+    return slowQueryMs.load(std::memory_order_relaxed);
+}
+
+/**
+ * Suma una ejecución a las estadísticas de su sentencia
+ * @param sql Sentencia, tal como se ha preparado
+ * @param elapsedNs Tiempo de exec() y de las llamadas a next()
+ * @param rows Filas leídas (SELECT) o modificadas
+ * @param failed La ejecución ha fallado
+ * @param database Conexión de la consulta, para calcular el plan
+ * @param boundValues Valores de la ejecución, para calcular el plan
+ */
+void QueryProfiler::record(const QString& sql, qint64 elapsedNs, qint64 rows, bool failed,
+                           const QSqlDatabase& database, const QVariantList& boundValues)
+{
+    GALLERY_METRIC_RECORD("db.query.us", elapsedNs / 1000);
+
+    const bool slow = elapsedNs >= qint64(slowQueryThreshold()) * 1000000;
+    ProfilerState& state = profilerState();
+    QString plan;
+    {
+        QMutexLocker locker(&state.mutex);
+        QueryStats& stats = state.statements[sql];
+        if (stats.calls == 0) {
+            stats.sql = sql;
+        }
+        ++stats.calls;
+        stats.errors += failed ? 1 : 0;
+        stats.rows += rows;
+        stats.totalNs += elapsedNs;
+        stats.maxNs = qMax(stats.maxNs, elapsedNs);
+        plan = stats.plan;
+    }
+
+    if (!slow || failed) {
+        return;
+    }
+    GALLERY_METRIC_ADD("db.slowQueries", 1);
+
+    // El plan se calcula fuera del mutex, y solo la primera vez
+    if (plan.isEmpty()) {
+        plan = queryPlan(sql, database, boundValues);
+        QMutexLocker locker(&state.mutex);
+        state.statements[sql].plan = plan;
+    }
+
+    qCWarning(lcDatabase).noquote()
+        << QString("Consulta lenta (%1 ms, %2 filas): %3\n%4")
+               .arg(elapsedNs / 1000000.0, 0, 'f', 1)
+               .arg(rows)
+               .arg(sql.simplified(), plan);
+}
+
+/**
+ * Copia de las estadísticas, de la sentencia con más tiempo total a la de menos
+ */
+QVector<QueryStats> QueryProfiler::statements()
+{
+    ProfilerState& state = profilerState();
+    QVector<QueryStats> statements;
+    {
+        QMutexLocker locker(&state.mutex);
+        statements.reserve(state.statements.size());
+        for (const QueryStats& stats : std::as_const(state.statements)) {
+            statements.append(stats);
+        }
+    }
+    std::sort(statements.begin(), statements.end(),
+              [](const QueryStats& a, const QueryStats& b) { return a.totalNs > b.totalNs; });
+    return statements;
+}
+
+/**
+ * Estadísticas en JSON: una entrada por sentencia con calls, errors, rows,
+ * totalMs, meanUs, maxUs y, si ha sido lenta, su plan
+ */
+QJsonArray QueryProfiler::toJson()
+{
+    QJsonArray json;
+    for (const QueryStats& stats : statements()) {
+        QJsonObject entry;
+        entry.insert("sql", stats.sql.simplified());
+        entry.insert("calls", stats.calls);
+        entry.insert("errors", stats.errors);
+        entry.insert("rows", stats.rows);
+        entry.insert("totalMs", stats.totalNs / 1000000.0);
+        entry.insert("meanUs", stats.totalNs / 1000.0 / stats.calls);
+        entry.insert("maxUs", stats.maxNs / 1000.0);
+        if (!stats.plan.isEmpty()) {
+            entry.insert("plan", stats.plan);
+        }
+        json.append(entry);
+    }
+    return json;
+}
+
+/**
+ * Escribe las estadísticas en un archivo JSON
+ * @return false si no se ha podido escribir
+ */
+bool QueryProfiler::writeJson(const QString& filePath)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcDatabase) << "No se pueden escribir las estadísticas SQL en" << filePath;
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    return file.commit();
+}
+
+/**
+ * Calcula el plan de una sentencia con EXPLAIN QUERY PLAN (solo SQLite)
+ * @return Una línea por paso, sangrada según su nivel en el árbol del plan
+ */
+QString QueryProfiler::queryPlan(const QString& sql, const QSqlDatabase& database,
+                                 const QVariantList& boundValues)
+{
+    // QSqlQuery, no ProfiledQuery: el plan no cuenta en las estadísticas
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.prepare("EXPLAIN QUERY PLAN " + sql)) {
+        return "(sin plan: " + query.lastError().text() + ")";
+    }
+    for (int index = 0; index < boundValues.size(); ++index) {
+        query.bindValue(index, boundValues.at(index));
+    }
+    if (!query.exec()) {
+        return "(sin plan: " + query.lastError().text() + ")";
+    }
+
+    // Columnas: id, parent, notused, detail
+    QHash<int, int> depths;
+    QStringList lines;
+    while (query.next()) {
+        const int depth = depths.value(query.value(1).toInt(), -1) + 1;
+        depths.insert(query.value(0).toInt(), depth);
+        lines << QString(2 * (depth + 1), ' ') + query.value(3).toString();
+    }
+    return lines.join('\n');
+}
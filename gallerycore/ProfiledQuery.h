@@ -0,0 +1,102 @@
+#ifndef PROFILEDQUERY_H
+#define PROFILEDQUERY_H
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVector>
+#include "gallerycore_global.h"
+
+/**
+ * Estadísticas acumuladas de una sentencia SQL
+ */
+struct QueryStats
+{
+    QString sql;
+    qint64 calls = 0;
+    qint64 errors = 0;
+    qint64 rows = 0;
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+    QString plan;           // EXPLAIN QUERY PLAN, si alguna vez ha sido lenta
+};
+
+/**
+ * QSqlQuery que mide cada ejecución
+ *
+ * Se usa igual que QSqlQuery en los DAO. Cada ejecución cuenta el tiempo de
+ * exec() más el de todas las llamadas a next() (SQLite calcula las filas a
+ * medida que se leen) y las filas leídas o modificadas. Al terminar (al
+ * llegar a la última fila, al volver a preparar o ejecutar, con finish() o al
+ * destruirse) la ejecución se suma a las estadísticas de su sentencia en
+ * QueryProfiler. Los errores de exec() se registran siempre con la sentencia
+ * que ha fallado.
+ *
+ * Solo oculta los métodos de QSqlQuery que necesita (no son virtuales): hay
+ * que usar el objeto como ProfiledQuery, no a través de un QSqlQuery&.
+ */
+class GALLERYCORE_EXPORT ProfiledQuery : public QSqlQuery
+{
+public:
+    explicit ProfiledQuery(const QSqlDatabase& database = QSqlDatabase());
+    ProfiledQuery(const QString& sql, const QSqlDatabase& database);
+    ~ProfiledQuery();
+
+    ProfiledQuery(const ProfiledQuery&) = delete;
+    ProfiledQuery& operator=(const ProfiledQuery&) = delete;
+
+    bool prepare(const QString& sql);
+    bool exec();
+    bool exec(const QString& sql);
+    bool next();
+    void finish();
+
+private:
+    bool checkResult(bool success);
+    void complete();
+
+    QSqlDatabase mDatabase;
+    QElapsedTimer mTimer;
+    qint64 mElapsedNs;
+    qint64 mRows;
+    bool mActive;           // Hay una ejecución sin sumar a las estadísticas
+};
+
+/**
+ * Perfil de las consultas SQL de la galería
+ *
+ * Agrupa las ejecuciones de ProfiledQuery por sentencia (el texto preparado,
+ * sin los valores) y guarda llamadas, filas, errores y tiempo total y máximo.
+ * Las ejecuciones que pasan del umbral de consulta lenta se registran en la
+ * categoría gallery.database con su EXPLAIN QUERY PLAN, que se calcula una
+ * sola vez por sentencia: un "SCAN" donde se esperaba un "SEARCH ... USING
+ * INDEX" es el próximo índice que falta.
+ *
+ * Variables de entorno (ver startFromEnvironment()):
+ * - GALLERY_SLOW_QUERY_MS: umbral de consulta lenta (50 ms por defecto)
+ * - GALLERY_SQL_STATS=<archivo.json>: escribe las estadísticas al salir
+ */
+class GALLERYCORE_EXPORT QueryProfiler
+{
+public:
+    static void startFromEnvironment();
+
+    static void setSlowQueryThreshold(int milliseconds);
+    static int slowQueryThreshold();
+
+    static void record(const QString& sql, qint64 elapsedNs, qint64 rows, bool failed,
+                       const QSqlDatabase& database, const QVariantList& boundValues);
+    static QVector<QueryStats> statements();
+    static QJsonArray toJson();
+    static bool writeJson(const QString& filePath);
+
+private:
+    QueryProfiler() = delete;
+
+    static QString queryPlan(const QString& sql, const QSqlDatabase& database,
+                             const QVariantList& boundValues);
+};
+
+#endif // PROFILEDQUERY_H
@@ -0,0 +1,244 @@
+#include "SearchDao.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QDebug>
+#include <utility>
+#include "PictureRows.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "Trace.h"
+
+/**
+ * Sentencias que crean los índices de texto completo y los triggers que los
+ * mantienen sincronizados con las tablas "albums", "pictures" y "directories".
+ *
+ * El rowid de cada tabla FTS5 coincide con el id de la fila indexada. Las
+ * rutas se indexan por carpeta (directory_search) y se unen con las imágenes
+ * al buscar: reubicar una carpeta actualiza una fila del índice, no una por
+ * imagen. Si en el futuro se añaden etiquetas, basta con una columna más en
+ * picture_search y su correspondiente trigger.
+ */
+static const QStringList SEARCH_SCHEMA = {
+    "CREATE VIRTUAL TABLE IF NOT EXISTS album_search USING fts5"
+    "(name, tokenize = 'unicode61 remove_diacritics 2')",
+
+    "CREATE VIRTUAL TABLE IF NOT EXISTS picture_search USING fts5"
+    "(name, tokenize = 'unicode61 remove_diacritics 2')",
+
+    "CREATE VIRTUAL TABLE IF NOT EXISTS directory_search USING fts5"
+    "(path, tokenize = 'unicode61 remove_diacritics 2')",
+
+    "CREATE TRIGGER IF NOT EXISTS albums_search_insert AFTER INSERT ON albums BEGIN "
+    "INSERT INTO album_search (rowid, name) VALUES (new.id, new.name); END",
+
+    "CREATE TRIGGER IF NOT EXISTS albums_search_update AFTER UPDATE OF name ON albums BEGIN "
+    "UPDATE album_search SET name = new.name WHERE rowid = new.id; END",
+
+    "CREATE TRIGGER IF NOT EXISTS albums_search_delete AFTER DELETE ON albums BEGIN "
+    "DELETE FROM album_search WHERE rowid = old.id; END",
+
+    "CREATE TRIGGER IF NOT EXISTS pictures_search_insert AFTER INSERT ON pictures BEGIN "
+    "INSERT INTO picture_search (rowid, name) VALUES (new.id, new.name); END",
+
+    "CREATE TRIGGER IF NOT EXISTS pictures_search_rename AFTER UPDATE OF name ON pictures BEGIN "
+    "UPDATE picture_search SET name = new.name WHERE rowid = new.id; END",
+
+    "CREATE TRIGGER IF NOT EXISTS pictures_search_delete AFTER DELETE ON pictures BEGIN "
+    "DELETE FROM picture_search WHERE rowid = old.id; END",
+
+    "CREATE TRIGGER IF NOT EXISTS directories_search_insert AFTER INSERT ON directories BEGIN "
+    "INSERT INTO directory_search (rowid, path) VALUES (new.id, new.path); END",
+
+    "CREATE TRIGGER IF NOT EXISTS directories_search_relocate AFTER UPDATE OF path ON directories BEGIN "
+    "UPDATE directory_search SET path = new.path WHERE rowid = new.id; END",
+
+    "CREATE TRIGGER IF NOT EXISTS directories_search_delete AFTER DELETE ON directories BEGIN "
+    "DELETE FROM directory_search WHERE rowid = old.id; END",
+};
+
+/**
+ * Índice de catálogos anteriores, con la ruta de la carpeta copiada en cada
+ * imagen; se sustituye por picture_search + directory_search
+ */
+static const QStringList LEGACY_SEARCH_SCHEMA = {
+    "DROP TRIGGER IF EXISTS pictures_search_insert",
+    "DROP TRIGGER IF EXISTS pictures_search_update",
+    "DROP TRIGGER IF EXISTS directories_search_update",
+    "DROP TABLE IF EXISTS picture_search",
+};
+
+/**
+ * Constructor de SearchDao
+ * @param database Referencia a la base de datos SQL que se utilizará para las operaciones
+ */
+SearchDao::SearchDao(QSqlDatabase& database) :
+    mDatabase(database),
+    mStatements(database),
+    mAvailable(false)
+{
+}
+
+/**
+ * Inicializa el índice de búsqueda de texto completo (FTS5)
+ *
+ * Debe llamarse después de AlbumDao::init(), DirectoryDao::init() y
+ * PictureDao::init(), ya que los triggers hacen referencia a las tres tablas. La primera vez que se crean las
+ * tablas FTS se rellenan con los álbumes, imágenes y carpetas ya existentes; el
+ * índice de catálogos anteriores (con la ruta en cada imagen) se reconstruye.
+ *
+ * Si el driver SQLite no incluye FTS5, la búsqueda queda desactivada y
+ * searchPictures() devuelve siempre una lista vacía.
+ */
+void SearchDao::init() const
+{
+    const QStringList tables = mDatabase.tables();
+    bool legacy = tables.contains("picture_search") && !tables.contains("directory_search");
+    bool firstTime = legacy || !tables.contains("picture_search");
+
+    ProfiledQuery query(mDatabase);
+    mDatabase.transaction();
+    QStringList statements = SEARCH_SCHEMA;
+    if (legacy) {
+        statements = LEGACY_SEARCH_SCHEMA + statements;
+    }
+    for (const QString& statement : std::as_const(statements)) {
+        if (!query.exec(statement)) {
+            qDebug() << "FTS5 no disponible, búsqueda desactivada:" << query.lastError();
+            mDatabase.rollback();
+            mAvailable = false;
+            return;
+        }
+    }
+
+    if (firstTime) {
+        if (!legacy) {
+            query.exec("INSERT INTO album_search (rowid, name) SELECT id, name FROM albums");
+        }
+        query.exec("INSERT INTO picture_search (rowid, name) SELECT id, name FROM pictures");
+        query.exec("DELETE FROM directory_search");
+        query.exec("INSERT INTO directory_search (rowid, path) SELECT id, path FROM directories");
+    }
+    mDatabase.commit();
+    mAvailable = true;
+}
+
+/**
+ * Indica si el índice de búsqueda está disponible
+ */
+bool SearchDao::isAvailable() const
+{
+    return mAvailable;
+}
+
+/**
+ * Fusiona los segmentos de los índices de búsqueda
+ *
+ * FTS5 añade un segmento por cada transacción; tras muchas importaciones
+ * pequeñas las búsquedas recorren decenas de segmentos. Es una operación
+ * de mantenimiento (gallerycli vacuum): reescribe el índice completo.
+ */
+void SearchDao::optimize() const
+{
+    if (!mAvailable) {
+        return;
+    }
+
+    ProfiledQuery query(mDatabase);
+    if (!query.exec("INSERT INTO album_search (album_search) VALUES ('optimize')")
+        || !query.exec("INSERT INTO picture_search (picture_search) VALUES ('optimize')")
+        || !query.exec("INSERT INTO directory_search (directory_search) VALUES ('optimize')")) {
+        qDebug() << "Error al optimizar el índice de búsqueda:" << query.lastError();
+    }
+}
+
+/**
+ * Convierte el texto escrito por el usuario en una expresión MATCH de FTS5
+ * @param text Texto libre, por ejemplo "playa 2023"
+ * @return Expresión con cada palabra entre comillas y como prefijo: "playa"* "2023"*
+ *
+ * Las comillas evitan que la sintaxis de FTS5 (AND, OR, NEAR, paréntesis...)
+ * del texto del usuario provoque errores, y el prefijo permite la búsqueda
+ * incremental mientras se escribe.
+ */
+QString SearchDao::matchExpression(const QString& text)
+{
+    static const QRegularExpression separators("[\\s\"]+");
+
+    QStringList terms;
+    for (const QString& word : text.split(separators, Qt::SkipEmptyParts)) {
+        terms << "\"" + word + "\"*";
+    }
+    return terms.join(' ');
+}
+
+/**
+ * Busca imágenes por nombre, ruta o nombre del álbum que las contiene
+ * @param text Texto de búsqueda
+ * @param cursor Posición de la última fila cargada; se avanza con los resultados
+ * @param limit Número máximo de resultados de esta página
+ * @param rows Almacén al que se añaden los resultados, ordenados por ID
+ * @return Número de filas añadidas
+ *
+ * Cada rama de la unión está limitada a una página y recorre su índice en
+ * orden de rowid a partir del cursor, de modo que el coste no depende del
+ * número total de coincidencias sino del tamaño de la página. Las palabras
+ * deben coincidir todas en el nombre, todas en la ruta de la carpeta o todas
+ * en el nombre del álbum.
+ */
+int SearchDao::searchPictures(const QString& text, PictureCursor& cursor, int limit, PictureRows& rows) const
+{
+    GALLERY_TRACE_SCOPE(lcDatabase, "SearchDao::searchPictures");
+    GALLERY_METRIC_TIMER("db.search.us");
+
+    QString match = matchExpression(text);
+    if (!mAvailable || match.isEmpty()) {
+        return 0;
+    }
+
+    CachedQuery query = mStatements.prepared(
+        "SELECT id, directory_id, name, album_id FROM pictures WHERE id IN ("
+        "  SELECT rowid FROM (SELECT rowid FROM picture_search"
+        "    WHERE picture_search MATCH :pictureMatch AND rowid > :pictureCursor"
+        "    ORDER BY rowid LIMIT :pictureLimit)"
+        "  UNION ALL"
+        "  SELECT id FROM (SELECT id FROM pictures"
+        "    WHERE directory_id IN (SELECT rowid FROM directory_search WHERE directory_search MATCH :directoryMatch)"
+        "    AND id > :directoryCursor ORDER BY id LIMIT :directoryLimit)"
+        "  UNION ALL"
+        "  SELECT id FROM (SELECT id FROM pictures"
+        "    WHERE album_id IN (SELECT rowid FROM album_search WHERE album_search MATCH :albumMatch)"
+        "    AND id > :albumCursor ORDER BY id LIMIT :albumLimit)"
+        ") ORDER BY id LIMIT :limit");
+    query->bindValue(":pictureMatch", match);
+    query->bindValue(":pictureCursor", cursor.id);
+    query->bindValue(":pictureLimit", limit);
+    query->bindValue(":directoryMatch", match);
+    query->bindValue(":directoryCursor", cursor.id);
+    query->bindValue(":directoryLimit", limit);
+    query->bindValue(":albumMatch", match);
+    query->bindValue(":albumCursor", cursor.id);
+    query->bindValue(":albumLimit", limit);
+    query->bindValue(":limit", limit);
+
+    if (!query->exec()) {
+        qDebug() << "Error en la búsqueda:" << query->lastError();
+        return 0;
+    }
+
+    rows.reserve(limit, limit * 24);
+
+    int added = 0;
+    while (query->next()) {
+        const int id = query->value(0).toInt();
+        rows.append(id, query->value(3).toInt(), query->value(1).toInt(), query->value(2).toString());
+        ++added;
+
+        cursor.id = id;
+        cursor.key = id;
+    }
+
+    return added;
+}
@@ -0,0 +1,28 @@
+#ifndef SEARCHDAO_H
+#define SEARCHDAO_H
+
+#include "PictureQuery.h"
+#include "StatementCache.h"
+
+class QSqlDatabase;
+class PictureRows;
+class SearchDao
+{
+public:
+    explicit SearchDao(QSqlDatabase& database);
+
+    void init() const;
+    bool isAvailable() const;
+    void optimize() const;
+
+    int searchPictures(const QString& text, PictureCursor& cursor, int limit, PictureRows& rows) const;
+
+    static QString matchExpression(const QString& text);
+
+private:
+    QSqlDatabase& mDatabase;
+    mutable StatementCache mStatements;
+    mutable bool mAvailable;
+};
+
+#endif // SEARCHDAO_H
@@ -0,0 +1,148 @@
+#include "SimilarityIndex.h"
+#include <algorithm>
+#include <QPair>
+#include "PerceptualHash.h"
+
+namespace {
+
+inline quint16 chunk(quint64 hash, int index)
+{
+    return quint16(hash >> (index * 16));
+}
+
+/**
+ * Visita todos los valores de 16 bits a distancia <= radius de value
+ * Cada combinación de bits cambiados se genera una sola vez (bits crecientes).
+ */
+template <typename Visitor>
+void probe(quint16 value, int radius, int firstBit, Visitor& visit)
+{
+    visit(value);
+    if (radius == 0) {
+        return;
+    }
+    for (int bit = firstBit; bit < 16; ++bit) {
+        probe(quint16(value ^ (1u << bit)), radius - 1, bit + 1, visit);
+    }
+}
+
+}
+
+/**
+ * Constructor de SimilarityIndex (índice vacío)
+ */
+SimilarityIndex::SimilarityIndex()
+{
+}
+
+/**
+ * Construye el índice
+ * @param pictureIds IDs de las imágenes
+ * @param hashes Hash perceptual de cada imagen (mismo orden que pictureIds)
+ *
+ * Cada tabla se ordena por conteo (dos pasadas, sin comparaciones), así que
+ * construir el índice de un millón de imágenes cuesta unos milisegundos.
+ */
+void SimilarityIndex::build(const QVector<int>& pictureIds, const QVector<quint64>& hashes)
+{
+    Q_ASSERT(pictureIds.count() == hashes.count());
+    mPictureIds = pictureIds;
+    mHashes = hashes;
+
+    const int count = mHashes.count();
+    for (int c = 0; c < CHUNK_COUNT; ++c) {
+        QVector<quint32>& offsets = mOffsets[c];
+        QVector<quint32>& entries = mEntries[c];
+
+        // Cuenta las entradas de cada valor y las convierte en posiciones
+        offsets.fill(0, (1 << CHUNK_BITS) + 1);
+        for (int i = 0; i < count; ++i) {
+            ++offsets[chunk(mHashes[i], c) + 1];
+        }
+        for (int value = 0; value < (1 << CHUNK_BITS); ++value) {
+            offsets[value + 1] += offsets[value];
+        }
+
+        entries.resize(count);
+        QVector<quint32> next(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < count; ++i) {
+            entries[next[chunk(mHashes[i], c)]++] = quint32(i);
+        }
+    }
+}
+
+/**
+ * Vacía el índice y libera su memoria
+ */
+void SimilarityIndex::clear()
+{
+    mPictureIds.clear();
+    mHashes.clear();
+    for (int c = 0; c < CHUNK_COUNT; ++c) {
+        mEntries[c].clear();
+        mOffsets[c].clear();
+    }
+}
+
+/**
+ * Indica si el índice está vacío (o sin construir)
+ */
+bool SimilarityIndex::isEmpty() const
+{
+    return mHashes.isEmpty();
+}
+
+/**
+ * Retorna el número de imágenes del índice
+ */
+int SimilarityIndex::count() const
+{
+    return mHashes.count();
+}
+
+/**
+ * Busca las imágenes parecidas a un hash
+ * @param hash Hash perceptual buscado
+ * @param maxDistance Distancia de Hamming máxima (bits distintos)
+ * @return IDs de las imágenes encontradas, de la más parecida a la menos
+ */
+QVector<int> SimilarityIndex::search(quint64 hash, int maxDistance) const
+{
+    QVector<QPair<int, int>> matches;   // (distancia, posición)
+    if (isEmpty()) {
+        return {};
+    }
+
+    // Una imagen puede aparecer en varias tablas; se marca la primera vez
+    QVector<bool> seen(mHashes.count(), false);
+    const int radius = maxDistance / CHUNK_COUNT;
+
+    for (int c = 0; c < CHUNK_COUNT; ++c) {
+        const QVector<quint32>& offsets = mOffsets[c];
+        const QVector<quint32>& entries = mEntries[c];
+
+        auto visit = [&] (quint16 value) {
+            for (quint32 e = offsets[value]; e < offsets[value + 1]; ++e) {
+                quint32 i = entries[e];
+                if (seen[i]) {
+                    continue;
+                }
+                seen[i] = true;
+                int distance = PerceptualHash::distance(hash, mHashes[i]);
+                if (distance <= maxDistance) {
+                    matches.append(qMakePair(distance, int(i)));
+                }
+            }
+        };
+        probe(chunk(hash, c), radius, 0, visit);
+    }
+
+    std::sort(matches.begin(), matches.end());
+
+    QVector<int> pictureIds;
+    pictureIds.reserve(matches.count());
+    for (const auto& match : matches) {
+        pictureIds.append(mPictureIds[match.second]);
+    }
+    return pictureIds;
+}
@@ -0,0 +1,45 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include <QVector>
+#include "gallerycore_global.h"
+
+/**
+ * Índice en memoria de hashes perceptuales para buscar imágenes parecidas
+ *
+ * Multi-index hashing: el hash de 64 bits se parte en 4 trozos de 16 bits y
+ * cada trozo tiene su propia tabla. Si dos hashes están a distancia <= r, al
+ * menos uno de sus trozos está a distancia <= r / 4 (principio del palomar),
+ * así que basta con consultar, en cada tabla, los valores a esa distancia del
+ * trozo buscado y comprobar después la distancia real de los candidatos.
+ *
+ * Cada tabla es un array de entradas ordenado por el valor del trozo más un
+ * array de 65536 + 1 desplazamientos: un millón de imágenes ocupan unos 30 MB
+ * y una búsqueda con r = 10 solo visita unos pocos cientos de cubetas.
+ */
+class GALLERYCORE_EXPORT SimilarityIndex
+{
+public:
+    SimilarityIndex();
+
+    void build(const QVector<int>& pictureIds, const QVector<quint64>& hashes);
+    void clear();
+    bool isEmpty() const;
+    int count() const;
+
+    QVector<int> search(quint64 hash, int maxDistance) const;
+
+private:
+    static const int CHUNK_COUNT = 4;
+    static const int CHUNK_BITS = 16;
+
+    QVector<int> mPictureIds;
+    QVector<quint64> mHashes;
+
+    // Por cada trozo: entradas (posición en mHashes) ordenadas por el valor
+    // del trozo, y posición de la primera entrada de cada valor
+    QVector<quint32> mEntries[CHUNK_COUNT];
+    QVector<quint32> mOffsets[CHUNK_COUNT];
+};
+
+#endif // SIMILARITYINDEX_H
@@ -0,0 +1,200 @@
+#include "StallDetector.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include "Metrics.h"
+#include "Trace.h"
+
+// Umbral por defecto a partir del cual un latido tardío es un bloqueo
+const int DEFAULT_STALL_THRESHOLD_MS = 50;
+
+// Tamaño a partir del cual el log se rota (se conserva un archivo anterior)
+const qint64 MAX_LOG_BYTES = 1024 * 1024;
+
+/**
+ * Constructor de StallDetector
+ * @param thresholdMs Duración mínima de un bloqueo, en ms
+ * @param logPath Log rotativo donde se apuntan los bloqueos
+ * @param parent Objeto padre
+ *
+ * Debe crearse en el hilo de la interfaz: es el hilo que se vigila.
+ */
+StallDetector::StallDetector(int thresholdMs, const QString& logPath, QObject* parent)
+    : QThread(parent),
+    mThresholdMs(qMax(1, thresholdMs)),
+    mLogPath(logPath),
+    mHeartbeatReceiver(new QObject(this)),
+    mAnsweredBeat(0),
+    mAnsweredAt(0),
+    mStallCount(0),
+    mStopping(false)
+{
+    setObjectName("StallDetector");
+    mClock.start();
+}
+
+/**
+ * Destructor: detiene el hilo del vigilante
+ */
+StallDetector::~StallDetector()
+{
+    stop();
+}
+
+/**
+ * Arranca el vigilante en el hilo actual según las variables de entorno
+ * (la QCoreApplication debe existir ya)
+ * @param parent Objeto padre (normalmente la aplicación)
+ * @return El vigilante, o nullptr si está desactivado
+ *
+ * GALLERY_STALL_THRESHOLD_MS fija el umbral (50 ms por defecto; 0 lo
+ * desactiva) y GALLERY_STALL_LOG el archivo de log (por defecto
+ * defaultLogPath()).
+ */
+StallDetector* StallDetector::startFromEnvironment(QObject* parent)
+{
+    bool ok = false;
+    int thresholdMs = qEnvironmentVariableIntValue("GALLERY_STALL_THRESHOLD_MS", &ok);
+    if (!ok) {
+        thresholdMs = DEFAULT_STALL_THRESHOLD_MS;
+    }
+    if (thresholdMs <= 0) {
+        return nullptr;
+    }
+
+    QString logPath = qEnvironmentVariable("GALLERY_STALL_LOG");
+    if (logPath.isEmpty()) {
+        logPath = defaultLogPath();
+    }
+
+    Trace::trackCurrentThread();
+    StallDetector* detector = new StallDetector(thresholdMs, logPath, parent);
+    detector->start(QThread::LowPriority);
+
+    // Al salir del bucle de eventos ya no hay nada que vigilar
+    QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                     detector, &StallDetector::stop);
+    return detector;
+}
+
+/**
+ * Log por defecto: stalls.log en la carpeta de datos de la aplicación
+ */
+QString StallDetector::defaultLogPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/stalls.log";
+}
+
+/**
+ * Detiene el vigilante y espera a que termine su hilo
+ */
+void StallDetector::stop()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mStopping = true;
+        mWakeUp.wakeAll();
+    }
+    wait();
+}
+
+/**
+ * Número de bloqueos detectados desde el arranque
+ */
+int StallDetector::stallCount() const
+{
+    return mStallCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Bucle del vigilante
+ *
+ * Cada latido es una llamada encolada en el hilo de la interfaz que apunta
+ * cuándo se ha atendido. Mientras no se atiende, el vigilante se despierta
+ * cada pocos ms; al pasar el umbral toma el span activo (en ese momento el
+ * hilo de la interfaz sigue dentro del código que lo bloquea).
+ */
+void StallDetector::run()
+{
+    const unsigned long tickMs = qBound(5, mThresholdMs / 5, 50);
+    quint64 beat = 0;
+
+    QMutexLocker locker(&mMutex);
+    while (!mStopping) {
+        ++beat;
+        const qint64 sentAt = mClock.elapsed();
+        QMetaObject::invokeMethod(mHeartbeatReceiver, [this, beat] {
+            mAnsweredAt.store(mClock.elapsed(), std::memory_order_relaxed);
+            mAnsweredBeat.store(beat, std::memory_order_release);
+        }, Qt::QueuedConnection);
+
+        const char* span = nullptr;
+        bool spanSampled = false;
+        while (mAnsweredBeat.load(std::memory_order_acquire) < beat) {
+            mWakeUp.wait(&mMutex, tickMs);
+            if (mStopping) {
+                return;
+            }
+            if (!spanSampled && mClock.elapsed() - sentAt >= mThresholdMs) {
+                span = Trace::trackedSpan();
+                spanSampled = true;
+            }
+        }
+
+        const qint64 durationMs = mAnsweredAt.load(std::memory_order_relaxed) - sentAt;
+        if (durationMs >= mThresholdMs) {
+            locker.unlock();
+            reportStall(durationMs, span);
+            locker.relock();
+        }
+
+        mWakeUp.wait(&mMutex, tickMs);
+    }
+}
+
+/**
+ * Apunta un bloqueo en el log, en las métricas y en la salida de depuración
+ * @param durationMs Duración del bloqueo
+ * @param span Span activo al pasar el umbral (nullptr si no había ninguno)
+ */
+void StallDetector::reportStall(qint64 durationMs, const char* span)
+{
+    const QByteArray spanName = span ? QByteArray(span) : QByteArrayLiteral("(sin span)");
+    const int spanCount = ++mStallsBySpan[spanName];
+    const int total = ++mStallCount;
+
+    GALLERY_METRIC_ADD("ui.stalls", 1);
+    GALLERY_METRIC_RECORD("ui.stall.us", durationMs * 1000);
+
+    qCWarning(lcUi).noquote() << "Interfaz bloqueada" << durationMs << "ms en" << spanName;
+
+    writeLog(QDateTime::currentDateTime().toString(Qt::ISODateWithMs).toUtf8()
+             + " bloqueo de " + QByteArray::number(durationMs) + " ms en " + spanName
+             + " (" + QByteArray::number(spanCount) + " en este span, "
+             + QByteArray::number(total) + " en total)\n");
+}
+
+/**
+ * Añade una línea al log, rotándolo si ha crecido demasiado
+ */
+void StallDetector::writeLog(const QByteArray& line)
+{
+    const QFileInfo info(mLogPath);
+    if (info.size() > MAX_LOG_BYTES) {
+        const QString previousPath = mLogPath + ".1";
+        QFile::remove(previousPath);
+        QFile::rename(mLogPath, previousPath);
+    } else if (!info.exists()) {
+        QDir().mkpath(info.absolutePath());
+    }
+
+    QFile file(mLogPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(lcUi) << "No se puede escribir el log de bloqueos en" << mLogPath;
+        return;
+    }
+    file.write(line);
+}
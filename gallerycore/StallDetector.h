@@ -0,0 +1,66 @@
+#ifndef STALLDETECTOR_H
+#define STALLDETECTOR_H
+
+#include <atomic>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QWaitCondition>
+#include "gallerycore_global.h"
+
+/**
+ * Vigilante de bloqueos del bucle de eventos de la interfaz
+ *
+ * Un hilo propio envía un latido (una llamada encolada) al hilo de la
+ * interfaz y mide cuánto tarda en atenderse. Si pasa del umbral, el bucle
+ * ha estado bloqueado: el bloqueo se apunta en un log rotativo con su
+ * duración y el span activo en ese momento (ver Trace::trackedSpan), junto
+ * con cuántas veces se ha bloqueado ya ese mismo span. Así se ve qué código
+ * congela la galería y se comprueba que cada camino lento ha salido del
+ * hilo de la interfaz.
+ *
+ * El vigilante apenas cuesta nada: un latido cada pocos ms y, mientras
+ * está activo, una operación atómica por span en el hilo de la interfaz.
+ */
+class GALLERYCORE_EXPORT StallDetector : public QThread
+{
+    Q_OBJECT
+public:
+    explicit StallDetector(int thresholdMs, const QString& logPath, QObject* parent = nullptr);
+    ~StallDetector();
+
+    static StallDetector* startFromEnvironment(QObject* parent);
+    static QString defaultLogPath();
+
+    void stop();
+
+    int stallCount() const;
+
+protected:
+    void run() override;
+
+private:
+    void reportStall(qint64 durationMs, const char* span);
+    void writeLog(const QByteArray& line);
+
+    const int mThresholdMs;
+    const QString mLogPath;
+    QObject* mHeartbeatReceiver;
+    QElapsedTimer mClock;
+
+    // Número del último latido atendido por el hilo de la interfaz y cuándo
+    std::atomic<quint64> mAnsweredBeat;
+    std::atomic<qint64> mAnsweredAt;
+    std::atomic<int> mStallCount;
+
+    QMutex mMutex;
+    QWaitCondition mWakeUp;
+    bool mStopping;
+
+    // Solo los usa el hilo del vigilante
+    QHash<QByteArray, int> mStallsBySpan;
+};
+
+#endif // STALLDETECTOR_H
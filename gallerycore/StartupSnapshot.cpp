@@ -0,0 +1,242 @@
+#include "StartupSnapshot.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "Albumdao.h"
+#include "Databasemanager.h"
+#include "DirectoryDao.h"
+#include "PictureDao.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+// Identificador y versión del formato; una versión distinta se descarta
+const quint32 SNAPSHOT_MAGIC = 0x47534e50;     // "GSNP"
+const quint32 SNAPSHOT_VERSION = 1;
+
+namespace {
+
+// Los thumbnails se guardan como píxeles sin comprimir: leerlos es copiar
+// memoria, sin decodificar JPEG ni PNG
+void writeImage(QDataStream& stream, const QImage& image)
+{
+    QImage pixels = image.hasAlphaChannel()
+                        ? image.convertToFormat(QImage::Format_ARGB32_Premultiplied)
+                        : image.convertToFormat(QImage::Format_RGB888);
+    stream << qint32(pixels.format()) << qint32(pixels.width()) << qint32(pixels.height())
+           << qint32(pixels.bytesPerLine());
+    stream.writeRawData(reinterpret_cast<const char*>(pixels.constBits()),
+                        int(pixels.sizeInBytes()));
+}
+
+QImage readImage(QDataStream& stream)
+{
+    qint32 format, width, height, bytesPerLine;
+    stream >> format >> width >> height >> bytesPerLine;
+    if (stream.status() != QDataStream::Ok || width <= 0 || height <= 0
+        || (format != QImage::Format_ARGB32_Premultiplied && format != QImage::Format_RGB888)) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return QImage();
+    }
+
+    QImage image(width, height, QImage::Format(format));
+    if (image.isNull() || image.bytesPerLine() != bytesPerLine) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return QImage();
+    }
+    stream.readRawData(reinterpret_cast<char*>(image.bits()), int(image.sizeInBytes()));
+    return image;
+}
+
+}
+
+/**
+ * Ruta de la instantánea de un catálogo, en la caché de la aplicación
+ * @param catalogPath Ruta del catálogo (DatabaseManager::path())
+ * @return Ruta del archivo, o cadena vacía si el catálogo está en memoria
+ *
+ * Cada catálogo tiene su propia instantánea (el nombre lleva un hash de su
+ * ruta absoluta): abrir otro catálogo no arranca con los álbumes del anterior.
+ */
+QString StartupSnapshot::pathForCatalog(const QString& catalogPath)
+{
+    if (catalogPath == MEMORY_DATABASE) {
+        return QString();
+    }
+
+    QByteArray hash = QCryptographicHash::hash(QFileInfo(catalogPath).absoluteFilePath().toUtf8(),
+                                               QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/startup-" + QString::fromLatin1(hash) + ".snapshot";
+}
+
+/**
+ * Lee la instantánea de un archivo
+ * @param path Ruta del archivo
+ * @return false si no existe, es de otra versión o está dañado
+ */
+bool StartupSnapshot::load(const QString& path)
+{
+    GALLERY_TRACE_SCOPE(lcModel, "StartupSnapshot::load");
+    GALLERY_METRIC_TIMER("startup.snapshotLoad.us");
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    qint32 albumCount;
+    stream >> albumCount;
+    albums.clear();
+    albums.reserve(qMax(0, albumCount));
+    for (int i = 0; i < albumCount && stream.status() == QDataStream::Ok; ++i) {
+        qint32 id;
+        QString name;
+        stream >> id >> name;
+        Album album(name);
+        album.setID(id);
+        albums.append(album);
+    }
+
+    qint32 rowCount;
+    stream >> albumId >> cursor.key >> cursor.id >> maxPictureId >> hasMorePictures >> rowCount;
+    rows.clear();
+    for (int i = 0; i < rowCount && stream.status() == QDataStream::Ok; ++i) {
+        qint32 id, rowAlbumId, directoryId;
+        QString name;
+        stream >> id >> rowAlbumId >> directoryId >> name;
+        rows.append(id, rowAlbumId, directoryId, name);
+    }
+
+    qint32 thumbnailCount;
+    stream >> thumbnailCount;
+    thumbnails.clear();
+    for (int i = 0; i < thumbnailCount && stream.status() == QDataStream::Ok; ++i) {
+        QString filePath;
+        stream >> filePath;
+        QImage image = readImage(stream);
+        if (!image.isNull()) {
+            thumbnails.insert(filePath, image);
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(lcModel) << "Instantánea de arranque dañada:" << path;
+        *this = StartupSnapshot();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Guarda la instantánea en un archivo
+ * @param path Ruta del archivo
+ * @return true si se ha guardado
+ *
+ * QSaveFile escribe en un archivo temporal y lo renombra al terminar: si la
+ * aplicación se cierra a medias, la instantánea anterior sigue intacta.
+ */
+bool StartupSnapshot::save(const QString& path) const
+{
+    GALLERY_TRACE_SCOPE(lcModel, "StartupSnapshot::save");
+
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+
+    stream << qint32(albums.count());
+    for (const Album& album : albums) {
+        stream << qint32(album.id()) << album.name();
+    }
+
+    stream << qint32(albumId) << cursor.key << qint32(cursor.id) << qint32(maxPictureId)
+           << hasMorePictures << qint32(rows.count());
+    for (int row = 0; row < rows.count(); ++row) {
+        stream << qint32(rows.id(row)) << qint32(rows.albumId(row))
+               << qint32(rows.directoryId(row)) << rows.name(row).toString();
+    }
+
+    stream << qint32(thumbnails.count());
+    for (auto it = thumbnails.cbegin(); it != thumbnails.cend(); ++it) {
+        stream << it.key();
+        writeImage(stream, it.value());
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+/**
+ * Compara la instantánea con el catálogo
+ * @param database Conexión abierta a la base de datos (puede ser de otro hilo)
+ * @return Combinación de Part con las partes que han cambiado (0 si ninguna)
+ *
+ * Las filas se comparan volviendo a leer la misma página del álbum: es una
+ * sola consulta sobre el índice del álbum, igual que abrirlo normalmente,
+ * pero fuera del hilo de la interfaz.
+ */
+int StartupSnapshot::differences(QSqlDatabase& database) const
+{
+    int changed = 0;
+
+    AlbumDao albumDao(database);
+    const QVector<Album> currentAlbums = albumDao.albums();
+    if (currentAlbums.count() != albums.count()) {
+        changed |= AlbumsPart;
+    } else {
+        for (int i = 0; i < albums.count(); ++i) {
+            if (currentAlbums[i].id() != albums[i].id()
+                || currentAlbums[i].name() != albums[i].name()) {
+                changed |= AlbumsPart;
+                break;
+            }
+        }
+    }
+
+    if (albumId > 0) {
+        DirectoryDao directoryDao(database);
+        PictureDao pictureDao(database, directoryDao);
+
+        PictureRows currentRows;
+        PictureCursor currentCursor;
+        int currentMaxId = pictureDao.lastPictureIdForAlbum(albumId);
+        if (currentMaxId > 0 && !rows.isEmpty()) {
+            pictureDao.picturesPage(albumId, PictureQuery(), currentCursor, currentMaxId,
+                                    rows.count(), currentRows);
+        }
+
+        bool same = currentMaxId == maxPictureId && currentRows.count() == rows.count();
+        for (int row = 0; same && row < rows.count(); ++row) {
+            same = currentRows.id(row) == rows.id(row)
+                   && currentRows.directoryId(row) == rows.directoryId(row)
+                   && currentRows.name(row) == rows.name(row);
+        }
+        if (!same) {
+            changed |= PicturesPart;
+        }
+    }
+    return changed;
+}
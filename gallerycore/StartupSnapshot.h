@@ -0,0 +1,53 @@
+#ifndef STARTUPSNAPSHOT_H
+#define STARTUPSNAPSHOT_H
+
+#include <QHash>
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include "gallerycore_global.h"
+#include "Album.h"
+#include "PictureQuery.h"
+#include "PictureRows.h"
+
+class QSqlDatabase;
+
+/**
+ * Instantánea del estado de la ventana al cerrarse, para arrancar al instante
+ *
+ * Guarda en un archivo binario (QDataStream) la lista de álbumes, las filas
+ * cargadas del último álbum abierto y los thumbnails que estaban a la vista.
+ * Al arrancar, los modelos se rellenan con ella sin consultar el catálogo
+ * ni decodificar thumbnails, y differences() la compara con la base de datos
+ * en segundo plano para corregir lo que haya cambiado entretanto.
+ */
+class GALLERYCORE_EXPORT StartupSnapshot
+{
+public:
+    // Partes de la instantánea que ya no coinciden con el catálogo
+    enum Part {
+        AlbumsPart = 0x1,
+        PicturesPart = 0x2,
+    };
+
+    QVector<Album> albums;
+
+    // Último álbum abierto (-1 si no había ninguno) y sus filas cargadas,
+    // con el orden por defecto
+    int albumId = -1;
+    PictureRows rows;
+    PictureCursor cursor;
+    int maxPictureId = 0;
+    bool hasMorePictures = false;
+
+    // Thumbnails a la vista al cerrar, por ruta del archivo
+    QHash<QString, QImage> thumbnails;
+
+    bool load(const QString& path);
+    bool save(const QString& path) const;
+    int differences(QSqlDatabase& database) const;
+
+    static QString pathForCatalog(const QString& catalogPath);
+};
+
+#endif // STARTUPSNAPSHOT_H
@@ -0,0 +1,33 @@
+#include "StatementCache.h"
+
+/**
+ * Constructor de StatementCache
+ * @param database Conexión de las sentencias (debe vivir más que la caché)
+ */
+StatementCache::StatementCache(QSqlDatabase& database) :
+    mDatabase(database)
+{
+}
+
+/**
+ * Presta una sentencia preparada, preparándola la primera vez
+ * @param sql Sentencia con sus parámetros (":nombre" o "?")
+ * @return La sentencia, sin cursor abierto; los valores de la ejecución
+ *         anterior se sustituyen al volver a enlazarlos
+ */
+CachedQuery StatementCache::prepared(const QString& sql)
+{
+    Statement& statement = mStatements[sql];
+    if (!statement.query) {
+        statement.query = std::make_unique<ProfiledQuery>(mDatabase);
+        statement.query->setForwardOnly(true);
+    }
+
+    Q_ASSERT_X(!statement.query->isActive(), "StatementCache::prepared",
+               "la sentencia ya está en uso");
+
+    if (!statement.prepared) {
+        statement.prepared = statement.query->prepare(sql);
+    }
+    return CachedQuery(*statement.query);
+}
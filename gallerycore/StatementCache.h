@@ -0,0 +1,83 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <map>
+#include <memory>
+#include <QString>
+#include "ProfiledQuery.h"
+
+/**
+ * Sentencia preparada prestada por un StatementCache
+ *
+ * Se usa como un puntero a ProfiledQuery. Al destruirse llama a finish():
+ * la sentencia vuelve a la caché sin cursor abierto, así que una SELECT que
+ * no se ha leído hasta el final no mantiene abierta la transacción de lectura
+ * (en modo WAL eso impediría ver lo que escriben otras conexiones).
+ */
+class CachedQuery
+{
+public:
+    explicit CachedQuery(ProfiledQuery& query) :
+        mQuery(&query)
+    {
+    }
+
+    CachedQuery(CachedQuery&& other) noexcept :
+        mQuery(other.mQuery)
+    {
+        other.mQuery = nullptr;
+    }
+
+    ~CachedQuery()
+    {
+        if (mQuery) {
+            mQuery->finish();
+        }
+    }
+
+    CachedQuery(const CachedQuery&) = delete;
+    CachedQuery& operator=(const CachedQuery&) = delete;
+
+    ProfiledQuery* operator->() const { return mQuery; }
+    ProfiledQuery& operator*() const { return *mQuery; }
+
+private:
+    ProfiledQuery* mQuery;
+};
+
+/**
+ * Caché de sentencias preparadas de una conexión
+ *
+ * Cada DAO tiene la suya (un DAO trabaja siempre sobre la misma conexión y
+ * en el mismo hilo). La primera vez que se pide una sentencia se prepara y
+ * se guarda; las siguientes se reutiliza, así que SQLite no vuelve a
+ * analizar el SQL en los bucles de importación, renombrado o paginación.
+ * Todas las sentencias son de solo avance (setForwardOnly).
+ *
+ * Una sentencia no puede usarse dos veces a la vez: un método que la tiene
+ * prestada no debe llamar a otro que pida el mismo SQL.
+ *
+ * La caché no tiene límite ni expulsa sentencias: solo deben pasar por ella
+ * sentencias de un conjunto fijo. El SQL que se construye con combinaciones
+ * ilimitadas (filtros) se prepara con un ProfiledQuery propio.
+ */
+class StatementCache
+{
+public:
+    explicit StatementCache(QSqlDatabase& database);
+
+    CachedQuery prepared(const QString& sql);
+
+private:
+    // Sentencia guardada; si prepare() falló se vuelve a intentar
+    struct Statement
+    {
+        std::unique_ptr<ProfiledQuery> query;
+        bool prepared = false;
+    };
+
+    QSqlDatabase& mDatabase;
+    std::map<QString, Statement> mStatements;
+};
+
+#endif // STATEMENTCACHE_H
@@ -0,0 +1,149 @@
+#include "ThumbnailCache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "MetadataExtractor.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+// Calidad JPEG de los thumbnails guardados en disco
+const int THUMBNAIL_JPEG_QUALITY = 85;
+
+/**
+ * Constructor de ThumbnailCache
+ * @param size Tamaño máximo (ancho y alto) de los thumbnails
+ * @param directory Carpeta donde se guardan los archivos de la caché
+ */
+ThumbnailCache::ThumbnailCache(int size, const QString& directory) :
+    mSize(size),
+    mDirectory(directory)
+{
+}
+
+/**
+ * Carpeta por defecto de la caché: "thumbnails" dentro de la caché de la aplicación
+ */
+QString ThumbnailCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+/**
+ * Retorna el tamaño máximo de los thumbnails de esta caché
+ */
+int ThumbnailCache::size() const
+{
+    return mSize;
+}
+
+/**
+ * Obtiene el thumbnail de una imagen
+ * @param filePath Ruta local de la imagen
+ * @return Thumbnail leído de la caché, o generado (y guardado) si no existía
+ */
+QImage ThumbnailCache::thumbnail(const QString& filePath) const
+{
+    GALLERY_TRACE_SCOPE(lcThumbnails, "ThumbnailCache::thumbnail");
+
+    QString cacheFilePath = cacheFile(filePath);
+
+    QImage image;
+    if (image.load(cacheFilePath)) {
+        GALLERY_METRIC_ADD("thumbnails.disk.hits", 1);
+        return image;
+    }
+    GALLERY_METRIC_ADD("thumbnails.disk.misses", 1);
+
+    image = generate(filePath);
+    if (!image.isNull()) {
+        store(cacheFilePath, image);
+    }
+    return image;
+}
+
+/**
+ * Indica si el thumbnail de una imagen ya está en la caché
+ */
+bool ThumbnailCache::contains(const QString& filePath) const
+{
+    return QFileInfo::exists(cacheFile(filePath));
+}
+
+/**
+ * Decodifica una imagen directamente al tamaño del thumbnail
+ * @param filePath Ruta local de la imagen
+ * @return Imagen escalada, o QImage nula si no se puede leer
+ *
+ * QImageReader::setScaledSize() permite al decodificador reducir la imagen
+ * mientras la lee (en JPEG, escalando los bloques DCT), mucho más rápido
+ * que decodificar a tamaño completo y escalar después.
+ */
+QImage ThumbnailCache::generate(const QString& filePath) const
+{
+    GALLERY_TRACE_SCOPE(lcThumbnails, "ThumbnailCache::generate");
+    GALLERY_METRIC_TIMER("thumbnails.decode.us");
+
+    QImageReader reader(filePath);
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > mSize || size.height() > mSize)) {
+        reader.setScaledSize(size.scaled(mSize, mSize, Qt::KeepAspectRatio));
+    }
+    return reader.read();
+}
+
+/**
+ * Calcula el archivo de la caché de una imagen
+ * @param filePath Ruta local de la imagen
+ * @return Ruta del archivo en la caché
+ *
+ * La clave combina la identidad del archivo (inodo), su tamaño, su fecha de
+ * modificación y el tamaño del thumbnail; no incluye la ruta, así que un
+ * archivo renombrado o movido dentro del mismo volumen conserva su thumbnail.
+ * Si el sistema no da la identidad del archivo se usa la ruta en su lugar.
+ * Los archivos se reparten en 256 subcarpetas para no tener cientos de miles
+ * de archivos en una sola carpeta.
+ */
+QString ThumbnailCache::cacheFile(const QString& filePath) const
+{
+    QFileInfo fileInfo(filePath);
+    quint64 fileId = MetadataExtractor::fileId(filePath);
+    QByteArray key = (fileId ? QByteArray::number(fileId) : filePath.toUtf8()) + '\n'
+                     + QByteArray::number(fileInfo.size()) + '\n'
+                     + QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()) + '\n'
+                     + QByteArray::number(mSize);
+    QString hash = QString::fromLatin1(
+        QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+
+    return mDirectory + '/' + hash.left(2) + '/' + hash + ".thumb";
+}
+
+/**
+ * Guarda un thumbnail en la caché
+ * @param cacheFilePath Ruta del archivo en la caché
+ * @param image Thumbnail a guardar
+ *
+ * QSaveFile escribe en un archivo temporal y lo renombra al terminar, así que
+ * otro hilo nunca lee un thumbnail a medio escribir. Las imágenes con
+ * transparencia se guardan en PNG y el resto en JPEG; al leer, el formato se
+ * detecta por el contenido.
+ */
+void ThumbnailCache::store(const QString& cacheFilePath, const QImage& image) const
+{
+    QDir().mkpath(QFileInfo(cacheFilePath).absolutePath());
+
+    QSaveFile file(cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QImageWriter writer(&file, image.hasAlphaChannel() ? "png" : "jpg");
+    writer.setQuality(THUMBNAIL_JPEG_QUALITY);
+    if (writer.write(image)) {
+        file.commit();
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QImage>
+#include <QString>
+#include "gallerycore_global.h"
+
+/**
+ * Caché en disco de thumbnails
+ *
+ * Cada thumbnail se guarda en un archivo cuyo nombre depende de la identidad
+ * del archivo (inodo), su tamaño, su fecha de modificación y el tamaño del
+ * thumbnail: un archivo modificado genera automáticamente una entrada nueva y
+ * uno renombrado o movido reutiliza la que ya tenía.
+ *
+ * Los métodos son const y no comparten estado: se pueden llamar desde varios
+ * hilos a la vez (por ejemplo, desde ImportPipeline).
+ */
+class GALLERYCORE_EXPORT ThumbnailCache
+{
+public:
+    explicit ThumbnailCache(int size, const QString& directory = defaultDirectory());
+
+    QImage thumbnail(const QString& filePath) const;
+    bool contains(const QString& filePath) const;
+    QImage generate(const QString& filePath) const;
+
+    int size() const;
+    static QString defaultDirectory();
+
+private:
+    QString cacheFile(const QString& filePath) const;
+    void store(const QString& cacheFilePath, const QImage& image) const;
+
+    int mSize;
+    QString mDirectory;
+};
+
+#endif // THUMBNAILCACHE_H
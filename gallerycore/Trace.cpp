@@ -0,0 +1,284 @@
+#include "Trace.h"
+#include <memory>
+#include <vector>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+Q_LOGGING_CATEGORY(lcDatabase, "gallery.database", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcModel, "gallery.model", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcImport, "gallery.import", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcThumbnails, "gallery.thumbnails", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcUi, "gallery.ui", QtInfoMsg)
+
+// Límite de spans guardados: una sesión larga no debe agotar la memoria
+const int MAX_TRACE_EVENTS = 4 * 1024 * 1024;
+
+std::atomic<bool> Trace::sEnabled(false);
+std::atomic<bool> Trace::sTracking(false);
+
+namespace {
+
+struct TraceEvent
+{
+    const char* category;
+    const char* name;
+    qint64 start;       // ns desde Trace::start()
+    qint64 end;
+};
+
+// Búfer de un hilo; solo ese hilo escribe en él, el mutex solo compite
+// con stop() al volcar la traza
+struct ThreadBuffer
+{
+    int id;
+    QString threadName;
+    QMutex mutex;
+    QVector<TraceEvent> events;
+};
+
+struct TraceState
+{
+    QMutex mutex;
+    QString filePath;
+    QElapsedTimer clock;
+    // Los búferes viven hasta el final del proceso: un hilo terminado
+    // conserva sus spans hasta que se escribe la traza
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<int> eventCount { 0 };
+    std::atomic<int> dropped { 0 };
+    bool postRoutineAdded = false;
+};
+
+// Span activo del hilo vigilado; lo escribe ese hilo y lo lee StallDetector
+std::atomic<const char*> trackedSpanName { nullptr };
+thread_local bool threadTracked = false;
+
+TraceState& traceState()
+{
+    static TraceState state;
+    return state;
+}
+
+/**
+ * Búfer del hilo actual, creado la primera vez que el hilo registra un span
+ */
+ThreadBuffer* threadBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceState& state = traceState();
+        QMutexLocker locker(&state.mutex);
+
+        auto owned = std::make_unique<ThreadBuffer>();
+        owned->id = int(state.buffers.size()) + 1;
+        QThread* thread = QThread::currentThread();
+        owned->threadName = thread->objectName();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            owned->threadName = "Principal";
+        } else if (owned->threadName.isEmpty()) {
+            owned->threadName = QString("Hilo %1").arg(owned->id);
+        }
+
+        buffer = owned.get();
+        state.buffers.push_back(std::move(owned));
+    }
+    return buffer;
+}
+
+/**
+ * Cadena JSON entre comillas (los nombres son literales, pero los de los
+ * hilos pueden contener cualquier carácter)
+ */
+QByteArray jsonString(const QByteArray& text)
+{
+    QByteArray escaped;
+    escaped.reserve(text.size() + 2);
+    escaped += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += (uchar(c) < 0x20) ? ' ' : c;
+    }
+    escaped += '"';
+    return escaped;
+}
+
+}
+
+/**
+ * Activa la traza si la variable de entorno GALLERY_TRACE indica un archivo
+ * @return true si la traza se ha activado
+ */
+bool Trace::startFromEnvironment()
+{
+    const QString filePath = qEnvironmentVariable("GALLERY_TRACE");
+    if (filePath.isEmpty()) {
+        return false;
+    }
+    start(filePath);
+    return true;
+}
+
+/**
+ * Empieza a registrar spans
+ * @param filePath Archivo JSON donde stop() escribirá la traza
+ *
+ * La traza se escribe automáticamente al destruir la QCoreApplication.
+ */
+void Trace::start(const QString& filePath)
+{
+    TraceState& state = traceState();
+    {
+        QMutexLocker locker(&state.mutex);
+        for (const auto& buffer : state.buffers) {
+            QMutexLocker bufferLocker(&buffer->mutex);
+            buffer->events.clear();
+        }
+        state.filePath = filePath;
+        state.eventCount = 0;
+        state.dropped = 0;
+        state.clock.start();
+
+        if (!state.postRoutineAdded) {
+            qAddPostRoutine([] { Trace::stop(); });
+            state.postRoutineAdded = true;
+        }
+    }
+    sEnabled.store(true, std::memory_order_release);
+}
+
+/**
+ * Deja de registrar spans y escribe la traza en formato Chrome trace (JSON)
+ * @return false si la traza no estaba activa o no se ha podido escribir
+ *
+ * Cada span es un evento completo ("ph": "X") con su inicio y duración en
+ * microsegundos; cada hilo tiene además un evento de metadatos con su nombre.
+ */
+bool Trace::stop()
+{
+    if (!sEnabled.exchange(false)) {
+        return false;
+    }
+
+    TraceState& state = traceState();
+    QMutexLocker locker(&state.mutex);
+
+    QSaveFile file(state.filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se puede escribir la traza en" << state.filePath;
+        return false;
+    }
+
+    const QByteArray processName = QCoreApplication::applicationName().toUtf8();
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":"
+                      + jsonString(processName) + "}}";
+
+    for (const auto& buffer : state.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        const QByteArray tid = QByteArray::number(buffer->id);
+        json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+                + ",\"args\":{\"name\":" + jsonString(buffer->threadName.toUtf8()) + "}}";
+
+        for (const TraceEvent& event : std::as_const(buffer->events)) {
+            json += ",\n{\"name\":" + jsonString(event.name)
+                    + ",\"cat\":" + jsonString(event.category)
+                    + ",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid
+                    + ",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((event.end - event.start) / 1000.0, 'f', 3)
+                    + "}";
+        }
+        buffer->events.clear();
+
+        // Volcado por hilo: la traza completa puede ocupar cientos de MB
+        file.write(json);
+        json.clear();
+    }
+    json += "\n]}\n";
+    file.write(json);
+
+    if (state.dropped > 0) {
+        qWarning() << "Traza llena:" << state.dropped.load() << "spans descartados";
+    }
+    return file.commit();
+}
+
+/**
+ * Instante actual de la traza, en nanosegundos desde start()
+ */
+qint64 Trace::now()
+{
+    return traceState().clock.nsecsElapsed();
+}
+
+/**
+ * Guarda un span terminado en el búfer del hilo actual
+ * @param category Nombre de la categoría (se guarda el puntero)
+ * @param name Nombre del span (cadena literal)
+ * @param start Inicio, según now()
+ * @param end Fin, según now()
+ */
+void Trace::record(const char* category, const char* name, qint64 start, qint64 end)
+{
+    TraceState& state = traceState();
+    if (!isEnabled()) {
+        return;
+    }
+    if (state.eventCount.fetch_add(1, std::memory_order_relaxed) >= MAX_TRACE_EVENTS) {
+        ++state.dropped;
+        return;
+    }
+
+    ThreadBuffer* buffer = threadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.append({ category, name, start, end });
+}
+
+/**
+ * Empieza a seguir el span activo del hilo actual (normalmente el de la
+ * interfaz); solo se sigue un hilo
+ */
+void Trace::trackCurrentThread()
+{
+    threadTracked = true;
+    sTracking.store(true, std::memory_order_release);
+}
+
+/**
+ * Span más interno activo ahora mismo en el hilo vigilado
+ * @return Nombre del span, o nullptr si no hay ninguno. Se puede llamar
+ *         desde cualquier hilo.
+ */
+const char* Trace::trackedSpan()
+{
+    return trackedSpanName.load(std::memory_order_acquire);
+}
+
+/**
+ * Marca un span como activo si se está ejecutando en el hilo vigilado
+ * @param name Nombre del span (cadena literal)
+ * @param previous Recibe el span que estaba activo, para restaurarlo
+ * @return false si el hilo actual no es el vigilado
+ */
+bool Trace::enterTrackedSpan(const char* name, const char** previous)
+{
+    if (!threadTracked) {
+        return false;
+    }
+    *previous = trackedSpanName.exchange(name, std::memory_order_acq_rel);
+    return true;
+}
+
+/**
+ * Restaura el span activo al terminar un span del hilo vigilado
+ */
+void Trace::leaveTrackedSpan(const char* previous)
+{
+    trackedSpanName.store(previous, std::memory_order_release);
+}
@@ -0,0 +1,134 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <QLoggingCategory>
+#include <QString>
+#include "gallerycore_global.h"
+
+/**
+ * Categorías de log de la galería
+ *
+ * Los mensajes de depuración están desactivados por defecto (nivel mínimo
+ * QtInfoMsg); se activan con QT_LOGGING_RULES, por ejemplo
+ * QT_LOGGING_RULES="gallery.model.debug=true".
+ */
+Q_DECLARE_EXPORTED_LOGGING_CATEGORY(lcDatabase, GALLERYCORE_EXPORT)
+Q_DECLARE_EXPORTED_LOGGING_CATEGORY(lcModel, GALLERYCORE_EXPORT)
+Q_DECLARE_EXPORTED_LOGGING_CATEGORY(lcImport, GALLERYCORE_EXPORT)
+Q_DECLARE_EXPORTED_LOGGING_CATEGORY(lcThumbnails, GALLERYCORE_EXPORT)
+Q_DECLARE_EXPORTED_LOGGING_CATEGORY(lcUi, GALLERYCORE_EXPORT)
+
+/**
+ * Registro de spans (intervalos de tiempo con nombre) en formato Chrome trace
+ *
+ * Con la variable de entorno GALLERY_TRACE=<archivo.json> (ver
+ * startFromEnvironment()) cada GALLERY_TRACE_SCOPE guarda su inicio, su
+ * duración y el hilo en el que se ha ejecutado; al salir de la aplicación
+ * se escribe el archivo, que se abre en chrome://tracing o en Perfetto
+ * (ui.perfetto.dev) para ver en qué se va el tiempo en cada hilo.
+ *
+ * Desactivado, un span cuesta una lectura atómica y un salto. Activado, cada
+ * hilo escribe en su propio búfer (sin competir por un mutex global).
+ *
+ * Los spans de una categoría desactivada por completo con QT_LOGGING_RULES
+ * (por ejemplo "gallery.thumbnails=false") no se registran.
+ */
+class GALLERYCORE_EXPORT Trace
+{
+public:
+    static bool startFromEnvironment();
+    static void start(const QString& filePath);
+    static bool stop();
+
+    static bool isEnabled()
+    {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    static qint64 now();
+    static void record(const char* category, const char* name, qint64 start, qint64 end);
+
+    // Span activo del hilo vigilado (ver StallDetector)
+    static void trackCurrentThread();
+    static const char* trackedSpan();
+
+    static bool isTracking()
+    {
+        return sTracking.load(std::memory_order_relaxed);
+    }
+
+    static bool enterTrackedSpan(const char* name, const char** previous);
+    static void leaveTrackedSpan(const char* previous);
+
+private:
+    Trace() = delete;
+
+    static std::atomic<bool> sEnabled;
+    static std::atomic<bool> sTracking;
+};
+
+/**
+ * Span de la traza: mide desde su construcción hasta su destrucción
+ *
+ * Se usa a través de GALLERY_TRACE_SCOPE. El nombre debe ser una cadena
+ * literal: solo se guarda el puntero.
+ *
+ * En el hilo vigilado por StallDetector el span además queda como "span
+ * activo" mientras dura, aunque la traza esté desactivada.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const QLoggingCategory& (*category)(), const char* name) :
+        mCategory(nullptr),
+        mName(name),
+        mStart(0),
+        mPrevious(nullptr),
+        mTracked(false)
+    {
+        if (Trace::isTracking()) {
+            mTracked = Trace::enterTrackedSpan(name, &mPrevious);
+        }
+        if (Q_UNLIKELY(Trace::isEnabled())) {
+            const QLoggingCategory& loggingCategory = category();
+            if (loggingCategory.isInfoEnabled()) {
+                mCategory = loggingCategory.categoryName();
+                mStart = Trace::now();
+            }
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (Q_UNLIKELY(mCategory != nullptr)) {
+            Trace::record(mCategory, mName, mStart, Trace::now());
+        }
+        if (mTracked) {
+            Trace::leaveTrackedSpan(mPrevious);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* mCategory;      // nullptr si el span no se registra
+    const char* mName;
+    qint64 mStart;
+    const char* mPrevious;      // Span activo antes de este (hilo vigilado)
+    bool mTracked;
+};
+
+#define GALLERY_TRACE_CONCAT_(a, b) a##b
+#define GALLERY_TRACE_CONCAT(a, b) GALLERY_TRACE_CONCAT_(a, b)
+
+/**
+ * Registra un span desde este punto hasta el final del bloque
+ * @param category Categoría de log (lcModel, lcThumbnails...)
+ * @param name Nombre del span (cadena literal)
+ */
+#define GALLERY_TRACE_SCOPE(category, name) \
+    TraceSpan GALLERY_TRACE_CONCAT(traceSpan_, __LINE__)(&category, name)
+
+#endif // TRACE_H
@@ -1,5 +1,4 @@
-QT       += sql
-QT -= gui
+QT       += sql gui
 
 TEMPLATE = lib
 DEFINES += GALLERYCORE_LIBRARY
@@ -13,19 +12,55 @@ CONFIG += c++17
 SOURCES += \
     AlbumModel.cpp \
     Albumdao.cpp \
+    ContentHash.cpp \
     Databasemanager.cpp \
+    DirectoryDao.cpp \
+    ImportPipeline.cpp \
+    LibraryWatcher.cpp \
+    MetadataExtractor.cpp \
+    Metrics.cpp \
+    PerceptualHash.cpp \
     Picture.cpp \
     PictureDao.cpp \
+    PictureRows.cpp \
+    ProfiledQuery.cpp \
     Picturemodel.cpp \
+    SearchDao.cpp \
+    SimilarityIndex.cpp \
+    StallDetector.cpp \
+    StartupSnapshot.cpp \
+    StatementCache.cpp \
+    ThumbnailCache.cpp \
+    Trace.cpp \
     album.cpp
 
 HEADERS += \
     AlbumModel.h \
     Albumdao.h \
+    BoundedQueue.h \
+    CatalogNotifier.h \
+    ContentHash.h \
     Databasemanager.h \
+    DirectoryDao.h \
+    ImportPipeline.h \
+    LibraryWatcher.h \
+    MetadataExtractor.h \
+    Metrics.h \
+    PerceptualHash.h \
     Picture.h \
+    PictureMetadata.h \
+    PictureQuery.h \
+    PictureRows.h \
+    ProfiledQuery.h \
     PictureDao.h \
     Picturemodel.h \
+    SearchDao.h \
+    SimilarityIndex.h \
+    StallDetector.h \
+    StartupSnapshot.h \
+    StatementCache.h \
+    ThumbnailCache.h \
+    Trace.h \
     gallerycore_global.h \
     album.h
 
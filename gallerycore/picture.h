@@ -1,6 +1,10 @@
+#ifndef PICTURE_H
+#define PICTURE_H
+
 #include <QUrl>
 #include <QString>
 #include "gallerycore_global.h"
+#include "PictureMetadata.h"
 
 class GALLERYCORE_EXPORT Picture
 {
@@ -14,11 +18,18 @@ public:
     void setId(int id);
     void setAlbumId(int albumId);
     void setFileUrl(const QUrl& fileUrl);
+    void setFilePath(const QString& filePath);
+    void setMetadata(const PictureMetadata& metadata);
 
     QUrl fileUrl() const;
+    const QString& filePath() const;
+    const PictureMetadata& metadata() const;
 
 private:
     int mId;
     int mAlbumId;
-    QUrl mFileUrl;
+    QString mFilePath;
+    PictureMetadata mMetadata;
 };
+
+#endif // PICTURE_H
@@ -1,8 +1,15 @@
 #include "AlbumListWidget.h"
 #include <QInputDialog>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimer>
 #include "AlbumModel.h"
+#include "Trace.h"
 #include "ui_albumlistwidget.h"
 
+// Espera tras la última pulsación antes de lanzar la búsqueda incremental
+const int SEARCH_DELAY_MS = 150;
+
 /**
  * Constructor de AlbumListWidget
  * @param parent Widget padre para la jerarquía de Qt (gestión automática de memoria)
@@ -24,6 +31,32 @@ AlbumListWidget::AlbumListWidget(QWidget *parent) :
     // Cuando se hace clic en el botón, se llama a la función createAlbum()
     connect(ui->createAlbumButton, &QPushButton::clicked,
             this, &AlbumListWidget::createAlbum);
+
+    // CAJA DE BÚSQUEDA
+    // Se inserta encima de la lista de álbumes. La búsqueda se lanza de forma
+    // incremental mientras el usuario escribe, con un pequeño retardo para no
+    // consultar la base de datos en cada pulsación.
+    mSearchEdit = new QLineEdit(this);
+    mSearchEdit->setPlaceholderText(tr("Search albums and pictures"));
+    mSearchEdit->setClearButtonEnabled(true);
+    ui->verticalLayout->insertWidget(1, mSearchEdit);
+
+    mSearchTimer = new QTimer(this);
+    mSearchTimer->setSingleShot(true);
+    mSearchTimer->setInterval(SEARCH_DELAY_MS);
+    connect(mSearchEdit, &QLineEdit::textChanged,
+            mSearchTimer, qOverload<>(&QTimer::start));
+    connect(mSearchTimer, &QTimer::timeout, this, [this] {
+        emit searchTextChanged(mSearchEdit->text());
+    });
+
+    // BOTÓN DE DUPLICADOS
+    // Debajo de la búsqueda: muestra las imágenes repetidas del catálogo
+    mDuplicatesButton = new QPushButton(tr("Find duplicates"), this);
+    ui->verticalLayout->insertWidget(ui->verticalLayout->indexOf(mSearchEdit) + 1,
+                                     mDuplicatesButton);
+    connect(mDuplicatesButton, &QPushButton::clicked,
+            this, &AlbumListWidget::duplicatesRequested);
 }
 
 /**
@@ -51,7 +84,7 @@ AlbumListWidget::~AlbumListWidget()
  */
 void AlbumListWidget::setModel(AlbumModel* model)
 {
-    qDebug() << "=== AlbumListWidget::setModel ===";
+    qCDebug(lcUi) << "=== AlbumListWidget::setModel ===";
 
     // Almacena el puntero al modelo para uso posterior
     mAlbumModel = model;
@@ -67,8 +100,15 @@ void AlbumListWidget::setModel(AlbumModel* model)
     // La selección afecta a filas completas, no a celdas individuales
     ui->albumList->setSelectionBehavior(QAbstractItemView::SelectRows);
 
+    // Acepta imágenes arrastradas desde las miniaturas y soltadas sobre un álbum
+    // (ver AlbumModel::dropMimeData)
+    ui->albumList->setAcceptDrops(true);
+    ui->albumList->setDropIndicatorShown(true);
+    ui->albumList->setDragDropMode(QAbstractItemView::DropOnly);
+    ui->albumList->setDefaultDropAction(Qt::MoveAction);
+
     // Debug: muestra cuántas filas tiene el modelo
-    qDebug() << "Modelo asignado, filas:" << (model ? model->rowCount() : 0);
+    qCDebug(lcUi) << "Modelo asignado, filas:" << (model ? model->rowCount() : 0);
 }
 
 /**
@@ -85,8 +125,8 @@ void AlbumListWidget::setModel(AlbumModel* model)
  */
 void AlbumListWidget::setSelectionModel(QItemSelectionModel* selectionModel)
 {
-    qDebug() << "=== AlbumListWidget::setSelectionModel ===";
-    qDebug() << "selectionModel:" << selectionModel;
+    qCDebug(lcUi) << "=== AlbumListWidget::setSelectionModel ===";
+    qCDebug(lcUi) << "selectionModel:" << selectionModel;
 
     // Asocia el modelo de selección con el QListView
     // Esto permite que múltiples vistas compartan la misma selección
@@ -96,30 +136,41 @@ void AlbumListWidget::setSelectionModel(QItemSelectionModel* selectionModel)
     // Esta lambda se ejecuta cada vez que cambia la selección
     connect(selectionModel, &QItemSelectionModel::selectionChanged,
             [](const QItemSelection& selected, const QItemSelection& deselected) {
-                qDebug() << "*** AlbumListWidget capturó selectionChanged ***";
+                qCDebug(lcUi) << "*** AlbumListWidget capturó selectionChanged ***";
                 // Muestra cuántos elementos fueron seleccionados
-                qDebug() << "Selected count:" << selected.indexes().count();
+                qCDebug(lcUi) << "Selected count:" << selected.indexes().count();
                 // Muestra cuántos elementos fueron deseleccionados
-                qDebug() << "Deselected count:" << deselected.indexes().count();
+                qCDebug(lcUi) << "Deselected count:" << deselected.indexes().count();
             });
 
     // CONEXIÓN 2: Conectar el clic directo en la lista
     // Captura el evento de clic para forzar explícitamente la selección
     // Esto puede ser necesario si el comportamiento automático no funciona correctamente
     connect(ui->albumList, &QAbstractItemView::clicked,
-            [selectionModel](const QModelIndex& index) {
-                qDebug() << "*** albumList CLICKED ***";
+            [this, selectionModel](const QModelIndex& index) {
+                qCDebug(lcUi) << "*** albumList CLICKED ***";
                 // Debug: verifica si el índice es válido
-                qDebug() << "Index válido:" << index.isValid();
+                qCDebug(lcUi) << "Index válido:" << index.isValid();
                 // Muestra la fila del elemento clicado
-                qDebug() << "Row:" << index.row();
+                qCDebug(lcUi) << "Row:" << index.row();
                 // Muestra los datos (nombre del álbum) del elemento
-                qDebug() << "Data:" << index.data().toString();
+                qCDebug(lcUi) << "Data:" << index.data().toString();
 
                 // Forzar la selección explícitamente
                 // ClearAndSelect: limpia la selección anterior y selecciona el nuevo elemento
                 selectionModel->setCurrentIndex(index,
                                                 QItemSelectionModel::ClearAndSelect);
+
+                // Al elegir un álbum se abandona la búsqueda. Se avisa después de
+                // cambiar la selección para que, si el álbum ya estaba seleccionado,
+                // la vista vuelva a mostrarlo en lugar de los resultados
+                if (!mSearchEdit->text().isEmpty()) {
+                    mSearchTimer->stop();
+                    mSearchEdit->blockSignals(true);
+                    mSearchEdit->clear();
+                    mSearchEdit->blockSignals(false);
+                    emit searchTextChanged(QString());
+                }
             });
 }
 
@@ -168,7 +219,7 @@ void AlbumListWidget::createAlbum()
         ui->albumList->setCurrentIndex(createdIndex);
 
         // Debug: confirma que el álbum fue creado y muestra su posición
-        qDebug() << "Álbum creado en index:" << createdIndex.row();
+        qCDebug(lcUi) << "Álbum creado en index:" << createdIndex.row();
     }
     // Si el usuario cancela o el nombre está vacío, no se hace nada
 }
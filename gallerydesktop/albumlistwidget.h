@@ -9,6 +9,9 @@ class AlbumListWidget;
 }
 
 class AlbumModel;
+class QLineEdit;
+class QPushButton;
+class QTimer;
 class AlbumListWidget : public QWidget
 {
     Q_OBJECT
@@ -19,9 +22,16 @@ public:
     void setModel(AlbumModel* model);
     void setSelectionModel(QItemSelectionModel* selectionModel);
 
+signals:
+    void searchTextChanged(const QString& text);
+    void duplicatesRequested();
+
 private:
     Ui::AlbumListWidget* ui;
     AlbumModel* mAlbumModel = nullptr;
+    QLineEdit* mSearchEdit = nullptr;
+    QTimer* mSearchTimer = nullptr;
+    QPushButton* mDuplicatesButton = nullptr;
 
 private slots:
     void createAlbum();
@@ -4,8 +4,27 @@
 #include "ui_albumwidget.h"
 #include <QInputDialog>
 #include <QFileDialog>
+#include <QComboBox>
+#include <QImageReader>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QSet>
+#include <QTimer>
+#include <QToolButton>
 #include "AlbumModel.h"
+#include "ImportPipeline.h"
+#include "LibraryWatcher.h"
+#include <QCheckBox>
 #include "PictureModel.h"
+#include "Trace.h"
+
+// Tiempo de espera tras la última pulsación antes de aplicar el filtro por nombre
+const int FILTER_DELAY_MS = 250;
+
+// Páginas que se cargan como máximo para recuperar la imagen actual tras reordenar
+const int PAGES_TO_RESTORE_SELECTION = 8;
 
 /**
  * Constructor de AlbumWidget
@@ -25,11 +44,69 @@ AlbumWidget::AlbumWidget(QWidget *parent) :
     mAlbumModel(nullptr),              // Inicializa puntero al modelo de álbumes
     mAlbumSelectionModel(nullptr),     // Inicializa puntero al modelo de selección de álbumes
     mPictureModel(nullptr),            // Inicializa puntero al modelo proxy de imágenes
-    mPictureSelectionModel(nullptr)    // Inicializa puntero al modelo de selección de imágenes
+    mPictureSelectionModel(nullptr),   // Inicializa puntero al modelo de selección de imágenes
+    mSortCombo(new QComboBox(this)),
+    mSortOrderButton(new QToolButton(this)),
+    mNameFilterEdit(new QLineEdit(this)),
+    mExtensionCombo(new QComboBox(this)),
+    mFilterTimer(new QTimer(this)),
+    mImportFolderButton(new QPushButton(tr("Import folder..."), this)),
+    mImportPipeline(nullptr),
+    mImportProgress(nullptr),
+    mLibraryWatcher(nullptr),
+    mWatchAlbumId(-1)
 {
     // Configura todos los widgets definidos en el archivo .ui
     ui->setupUi(this);
 
+    // BARRA DE ORDENACIÓN Y FILTRADO
+    // Se inserta entre la cabecera del álbum y el ListView de miniaturas
+
+    mSortCombo->addItem(tr("Import order"), PictureQuery::SortById);
+    mSortCombo->addItem(tr("Name"), PictureQuery::SortByName);
+    mSortCombo->addItem(tr("Date"), PictureQuery::SortByDate);
+    mSortCombo->addItem(tr("Size"), PictureQuery::SortBySize);
+    mSortCombo->addItem(tr("Dimensions"), PictureQuery::SortByDimensions);
+
+    // Botón conmutador ascendente / descendente
+    mSortOrderButton->setCheckable(true);
+    mSortOrderButton->setArrowType(Qt::UpArrow);
+    mSortOrderButton->setToolTip(tr("Sort order"));
+
+    mNameFilterEdit->setPlaceholderText(tr("Filter by name"));
+    mNameFilterEdit->setClearButtonEnabled(true);
+
+    mExtensionCombo->addItem(tr("All types"));
+
+    QHBoxLayout* queryLayout = new QHBoxLayout();
+    queryLayout->addWidget(mSortCombo);
+    queryLayout->addWidget(mSortOrderButton);
+    queryLayout->addWidget(mNameFilterEdit, 1);
+    queryLayout->addWidget(mExtensionCombo);
+    ui->verticalLayout->insertLayout(1, queryLayout);
+
+    // El filtro por nombre se aplica cuando el usuario deja de escribir
+    mFilterTimer->setSingleShot(true);
+    mFilterTimer->setInterval(FILTER_DELAY_MS);
+    connect(mFilterTimer, &QTimer::timeout,
+            this, &AlbumWidget::applyPictureQuery);
+    connect(mNameFilterEdit, &QLineEdit::textChanged,
+            mFilterTimer, qOverload<>(&QTimer::start));
+
+    connect(mSortCombo, qOverload<int>(&QComboBox::currentIndexChanged),
+            this, &AlbumWidget::applyPictureQuery);
+    connect(mExtensionCombo, qOverload<int>(&QComboBox::currentIndexChanged),
+            this, &AlbumWidget::applyPictureQuery);
+    connect(mSortOrderButton, &QToolButton::toggled, this, [this] (bool descending) {
+        mSortOrderButton->setArrowType(descending ? Qt::DownArrow : Qt::UpArrow);
+        applyPictureQuery();
+    });
+
+    // Botón de importar carpeta, junto al de añadir imágenes
+    ui->horizontalLayout->insertWidget(
+        ui->horizontalLayout->indexOf(ui->addPictureButton) + 1, mImportFolderButton);
+    mImportFolderButton->setVisible(ui->addPictureButton->isVisible());
+
     // CONFIGURACIÓN DEL LISTVIEW DE MINIATURAS
 
     // Establece el espacio entre elementos en píxeles
@@ -49,6 +126,13 @@ AlbumWidget::AlbumWidget(QWidget *parent) :
     ui->thumbnailListView->setItemDelegate(
         new PictureDelegate(this));
 
+    // Selección múltiple (Ctrl/Mayús) y arrastre de las imágenes seleccionadas
+    // sobre la lista de álbumes: mover por defecto, copiar con Ctrl
+    ui->thumbnailListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->thumbnailListView->setDragEnabled(true);
+    ui->thumbnailListView->setDragDropMode(QAbstractItemView::DragOnly);
+    ui->thumbnailListView->setDefaultDropAction(Qt::MoveAction);
+
     // CONEXIONES DE SEÑALES Y SLOTS
 
     // Conecta el doble clic en una imagen con la función pictureActivated
@@ -67,6 +151,11 @@ AlbumWidget::AlbumWidget(QWidget *parent) :
     // Conecta el botón de añadir imágenes con la función addPictures
     connect(ui->addPictureButton, &QPushButton::clicked,
             this, &AlbumWidget::addPictures);
+
+    // Conecta el botón de importar carpeta (la importación se crea con el
+    // modelo de álbumes, que fija el catálogo en el que se importa)
+    connect(mImportFolderButton, &QPushButton::clicked,
+            this, &AlbumWidget::importFolder);
 }
 
 /**
@@ -85,23 +174,74 @@ AlbumWidget::~AlbumWidget()
  *
  * Conecta el modelo de álbumes con el widget y establece una conexión
  * para detectar cuando los datos de un álbum cambian (por ejemplo, cuando
- * se renombra). Si el álbum modificado es el que está actualmente
- * seleccionado, recarga la interfaz para mostrar los cambios.
+ * se renombra). Si cambia el nombre del álbum actualmente seleccionado,
+ * solo se actualiza el título: las imágenes no se vuelven a cargar.
  */
 void AlbumWidget::setAlbumModel(AlbumModel* albumModel)
 {
     // Almacena el puntero al modelo de álbumes
     mAlbumModel = albumModel;
 
+    // La importación de carpetas escribe en el catálogo del modelo
+    if (!mImportPipeline) {
+        mImportPipeline = new ImportPipeline(mAlbumModel->database(), this);
+        connectImportPipeline();
+    }
+
     // Conecta la señal dataChanged del modelo
     // Esta señal se emite cuando los datos de un álbum cambian
     connect(mAlbumModel, &QAbstractItemModel::dataChanged,
-            [this] (const QModelIndex &topLeft) {
+            [this] (const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                    const QList<int> &roles) {
+                // Solo interesa el nombre (una lista vacía significa "todos los roles")
+                if (!roles.isEmpty() && !roles.contains(AlbumModel::Roles::NameRole)
+                    && !roles.contains(Qt::DisplayRole)) {
+                    return;
+                }
+
                 // Verifica si el álbum modificado es el actualmente seleccionado
-                if (topLeft == mAlbumSelectionModel->currentIndex()) {
-                    // Recarga la interfaz para mostrar los datos actualizados
-                    loadAlbum(topLeft);
+                QModelIndex current = mAlbumSelectionModel->currentIndex();
+                if (current.isValid() && current.row() >= topLeft.row()
+                    && current.row() <= bottomRight.row()
+                    && !(mPictureModel && mPictureModel->pictureModel()->isSearchActive())) {
+                    // Actualiza solo el título del álbum
+                    ui->albumName->setText(
+                        mAlbumModel->data(current, Qt::DisplayRole).toString());
+                }
+            });
+}
+
+/**
+ * Conecta el progreso y el final de la importación de carpetas
+ *
+ * Al terminar se cierra el diálogo de progreso y, si se pidió, se empieza a
+ * vigilar la carpeta importada.
+ */
+void AlbumWidget::connectImportPipeline()
+{
+    connect(mImportPipeline, &ImportPipeline::progress, this,
+            [this] (int processed, int discovered) {
+                if (mImportProgress) {
+                    mImportProgress->setMaximum(discovered);
+                    mImportProgress->setValue(processed);
+                }
+            });
+    connect(mImportPipeline, &ImportPipeline::finished, this,
+            [this] (int imported, int duplicates, bool cancelled) {
+                if (mImportProgress) {
+                    mImportProgress->deleteLater();
+                    mImportProgress = nullptr;
+                }
+                mImportFolderButton->setEnabled(true);
+
+                // Solo se vigila cuando todo está importado: antes, el
+                // vigilante tomaría por nuevos los archivos aún sin escribir
+                if (!cancelled && mLibraryWatcher && !mWatchAfterImport.isEmpty()) {
+                    mLibraryWatcher->watchFolder(mWatchAfterImport, mWatchAlbumId);
                 }
+                mWatchAfterImport.clear();
+                qCInfo(lcImport) << "Importación terminada:" << imported << "imágenes,"
+                                 << duplicates << "duplicadas" << (cancelled ? "(cancelada)" : "");
             });
 }
 
@@ -124,10 +264,6 @@ void AlbumWidget::setAlbumSelectionModel(QItemSelectionModel* SelectionModel)
     // Almacena el puntero al modelo de selección
     mAlbumSelectionModel = SelectionModel;
 
-    qDebug() << "AlbumWidget::setAlbumSelectionModel llamado";
-    qDebug() << "SelectionModel tiene selección:"
-             << (SelectionModel ? SelectionModel->hasSelection() : false);
-
     // Conecta la señal de cambio de selección
     // Se ejecuta cada vez que el usuario selecciona un álbum diferente
     connect(SelectionModel,
@@ -147,7 +283,6 @@ void AlbumWidget::setAlbumSelectionModel(QItemSelectionModel* SelectionModel)
     if (SelectionModel->hasSelection()) {
         QModelIndex currentIndex = SelectionModel->currentIndex();
         if (currentIndex.isValid()) {
-            qDebug() << "Cargando álbum inicial automáticamente";
             loadAlbum(currentIndex);
         }
     }
@@ -165,28 +300,15 @@ void AlbumWidget::setAlbumSelectionModel(QItemSelectionModel* SelectionModel)
  *
  * Esta función es llamada cuando:
  * - El usuario selecciona un álbum diferente
- * - Se renombra el álbum actual
  * - Se inicializa el widget con un álbum ya seleccionado
  */
 void AlbumWidget::loadAlbum(const QModelIndex& albumIndex)
 {
-    qDebug() << "=== loadAlbum llamado ===";
-    qDebug() << "albumIndex válido:" << albumIndex.isValid();
+    GALLERY_TRACE_SCOPE(lcUi, "AlbumWidget::loadAlbum");
 
     // VALIDACIONES: Verifica que todos los elementos necesarios estén disponibles
 
-    if (!albumIndex.isValid()) {
-        qDebug() << "Index inválido, retornando";
-        return;
-    }
-
-    if (!mAlbumModel) {
-        qDebug() << "mAlbumModel es NULL!";
-        return;
-    }
-
-    if (!mPictureModel) {
-        qDebug() << "mPictureModel es NULL!";
+    if (!albumIndex.isValid() || !mAlbumModel || !mPictureModel) {
         return;
     }
 
@@ -198,14 +320,16 @@ void AlbumWidget::loadAlbum(const QModelIndex& albumIndex)
     // Obtiene el nombre del álbum usando el rol estándar DisplayRole
     QString albumName = mAlbumModel->data(albumIndex, Qt::DisplayRole).toString();
 
-    qDebug() << "Album ID:" << albumId;
-    qDebug() << "Album Name:" << albumName;
+    qCDebug(lcUi) << "loadAlbum:" << albumId << albumName;
 
     // ACTUALIZACIÓN DEL MODELO DE IMÁGENES
     // Configura el modelo de imágenes para mostrar solo las fotos de este álbum
     // pictureModel() accede al modelo subyacente dentro del proxy model
     mPictureModel->pictureModel()->setAlbumId(albumId);
 
+    // Actualiza las extensiones disponibles para el filtro
+    updateExtensionFilter();
+
     // ACTUALIZACIÓN DE LA INTERFAZ DE USUARIO
 
     // Muestra el nombre del álbum en el label correspondiente
@@ -215,8 +339,7 @@ void AlbumWidget::loadAlbum(const QModelIndex& albumIndex)
     ui->deleteButton->setVisible(true);
     ui->editButton->setVisible(true);
     ui->addPictureButton->setVisible(true);
-
-    qDebug() << "UI actualizada correctamente";
+    mImportFolderButton->setVisible(true);
 }
 
 /**
@@ -361,6 +484,17 @@ void AlbumWidget::setPictureSelectionModel(QItemSelectionModel* selectionModel)
     ui->thumbnailListView->setSelectionModel(selectionModel);
 }
 
+/**
+ * Establece el vigilante de carpetas
+ * @param libraryWatcher Sincroniza las carpetas vigiladas con el catálogo
+ *
+ * Permite mantener sincronizada una carpeta al importarla.
+ */
+void AlbumWidget::setLibraryWatcher(LibraryWatcher* libraryWatcher)
+{
+    mLibraryWatcher = libraryWatcher;
+}
+
 /**
  * Añade una o más imágenes al álbum actualmente seleccionado
  *
@@ -376,13 +510,19 @@ void AlbumWidget::setPictureSelectionModel(QItemSelectionModel* selectionModel)
  */
 void AlbumWidget::addPictures()
 {
+    // Filtro con todos los formatos que pueden leer los plugins de imagen instalados
+    QStringList patterns;
+    for (const QByteArray& format : QImageReader::supportedImageFormats()) {
+        patterns << "*." + QString::fromLatin1(format);
+    }
+
     // Muestra el diálogo de selección de archivos
     QStringList filenames =
         QFileDialog::getOpenFileNames(
             this,                                    // Widget padre
             "Add pictures",                          // Título del diálogo
             QDir::homePath(),                        // Directorio inicial (carpeta home)
-            "Picture files (*.jpg *.png)"           // Filtro de archivos
+            "Picture files (" + patterns.join(' ') + ")"  // Filtro de archivos
             );
 
     // Verifica que el usuario haya seleccionado al menos un archivo
@@ -406,6 +546,70 @@ void AlbumWidget::addPictures()
     }
 }
 
+/**
+ * Importa una carpeta completa (con sus subcarpetas) en segundo plano
+ *
+ * Los archivos de la carpeta elegida se añaden al álbum actual; si el
+ * usuario lo pide, cada subcarpeta se importa en un álbum nuevo con su ruta
+ * relativa como nombre. La importación (ImportPipeline) recorre el disco,
+ * lee los metadatos, genera los thumbnails e inserta en la base de datos en
+ * paralelo, así que la interfaz sigue respondiendo; el diálogo de progreso
+ * permite cancelarla.
+ */
+void AlbumWidget::importFolder()
+{
+    if (!mImportPipeline || mImportPipeline->isRunning() || !mAlbumSelectionModel
+        || !mAlbumSelectionModel->currentIndex().isValid()) {
+        return;
+    }
+
+    QString folder = QFileDialog::getExistingDirectory(
+        this, tr("Import folder"), QDir::homePath());
+    if (folder.isEmpty()) {
+        return;
+    }
+
+    ImportOptions options;
+    options.rootPath = folder;
+    options.albumId = mAlbumModel->data(mAlbumSelectionModel->currentIndex(),
+                                        AlbumModel::Roles::IdRole).toInt();
+
+    // Pregunta si crear un álbum por subcarpeta y si mantener la carpeta sincronizada
+    QMessageBox question(QMessageBox::Question, tr("Import folder"),
+                         tr("Create an album for each subfolder?"),
+                         QMessageBox::Yes | QMessageBox::No, this);
+    QCheckBox* watchCheckBox = new QCheckBox(tr("Keep this folder in sync"), &question);
+    watchCheckBox->setChecked(mLibraryWatcher != nullptr);
+    watchCheckBox->setEnabled(mLibraryWatcher != nullptr);
+    question.setCheckBox(watchCheckBox);
+    options.albumPerFolder = question.exec() == QMessageBox::Yes;
+
+    if (mPictureModel) {
+        options.thumbnailSize = mPictureModel->diskCache().size();
+    }
+
+    if (!mImportPipeline->start(options)) {
+        return;
+    }
+
+    if (watchCheckBox->isChecked()) {
+        mWatchAfterImport = folder;
+        mWatchAlbumId = options.albumId;
+    }
+
+    mImportFolderButton->setEnabled(false);
+    mImportProgress = new QProgressDialog(tr("Importing pictures..."), tr("Cancel"),
+                                          0, 0, this);
+    mImportProgress->setWindowModality(Qt::WindowModal);
+    mImportProgress->setMinimumDuration(0);
+    // El total crece mientras se recorren las carpetas: el diálogo no debe
+    // cerrarse solo cuando el progreso alcanza un total provisional
+    mImportProgress->setAutoReset(false);
+    mImportProgress->setAutoClose(false);
+    connect(mImportProgress, &QProgressDialog::canceled,
+            mImportPipeline, &ImportPipeline::cancel);
+}
+
 /**
  * Limpia la interfaz de usuario cuando no hay álbum seleccionado
  *
@@ -427,4 +631,208 @@ void AlbumWidget::clearUi()
     ui->deleteButton->setVisible(false);
     ui->editButton->setVisible(false);
     ui->addPictureButton->setVisible(false);
+    mImportFolderButton->setVisible(false);
+}
+
+/**
+ * Muestra los resultados de una búsqueda en lugar del álbum actual
+ * @param text Texto de búsqueda; vacío para volver al álbum seleccionado
+ *
+ * Los resultados se presentan como un álbum virtual en el mismo ListView de
+ * miniaturas. Mientras se muestran se ocultan las acciones de álbum
+ * (editar, eliminar, añadir imágenes), que no tienen sentido sobre ellos.
+ */
+void AlbumWidget::setSearchText(const QString& text)
+{
+    if (!mPictureModel) {
+        return;
+    }
+
+    PictureModel* pictureModel = mPictureModel->pictureModel();
+
+    if (text.trimmed().isEmpty()) {
+        // Vuelve al álbum seleccionado solo si se estaba mostrando una búsqueda
+        if (pictureModel->isSearchActive()) {
+            QModelIndex current = mAlbumSelectionModel
+                                      ? mAlbumSelectionModel->currentIndex() : QModelIndex();
+            if (current.isValid()) {
+                loadAlbum(current);
+            } else {
+                pictureModel->setAlbumId(-1);
+                clearUi();
+            }
+        }
+        return;
+    }
+
+    pictureModel->setSearchText(text);
+
+    ui->albumName->setText(tr("Search results"));
+    ui->deleteButton->setVisible(false);
+    ui->editButton->setVisible(false);
+    ui->addPictureButton->setVisible(false);
+    mImportFolderButton->setVisible(false);
+}
+
+/**
+ * Muestra las imágenes duplicadas del catálogo en lugar del álbum actual
+ *
+ * Igual que los resultados de búsqueda, se presentan como un álbum virtual;
+ * las imágenes de cada grupo aparecen seguidas para poder compararlas y
+ * eliminar las copias sobrantes.
+ */
+void AlbumWidget::showDuplicates()
+{
+    if (!mPictureModel) {
+        return;
+    }
+
+    int groups = mPictureModel->pictureModel()->showDuplicates();
+
+    ui->albumName->setText(tr("Duplicates (%1 groups)").arg(groups));
+    ui->deleteButton->setVisible(false);
+    ui->editButton->setVisible(false);
+    ui->addPictureButton->setVisible(false);
+    mImportFolderButton->setVisible(false);
+}
+
+/**
+ * Muestra las imágenes parecidas a una imagen en lugar del álbum actual
+ * @param pictureId ID de la imagen de referencia, que aparece la primera
+ */
+void AlbumWidget::showSimilarPictures(int pictureId)
+{
+    if (!mPictureModel) {
+        return;
+    }
+
+    int similar = mPictureModel->pictureModel()->showSimilar(pictureId);
+
+    ui->albumName->setText(tr("Similar pictures (%1)").arg(similar));
+    ui->deleteButton->setVisible(false);
+    ui->editButton->setVisible(false);
+    ui->addPictureButton->setVisible(false);
+    mImportFolderButton->setVisible(false);
+}
+
+/**
+ * Obtiene las rutas de las imágenes a la vista en el ListView de miniaturas
+ * @return Rutas en el orden de las filas (para la instantánea de arranque)
+ */
+QStringList AlbumWidget::visibleFilePaths() const
+{
+    QStringList filePaths;
+    if (!mPictureModel) {
+        return filePaths;
+    }
+
+    // Con el flujo LeftToRight las filas visibles son consecutivas
+    const QRect viewport = ui->thumbnailListView->viewport()->rect();
+    for (int row = 0; row < mPictureModel->rowCount(); ++row) {
+        QModelIndex index = mPictureModel->index(row, 0);
+        if (ui->thumbnailListView->visualRect(index).intersects(viewport)) {
+            filePaths << index.data(PictureModel::FilePathRole).toString();
+        } else if (!filePaths.isEmpty()) {
+            break;
+        }
+    }
+    return filePaths;
+}
+
+/**
+ * Rellena el filtro de extensiones con las presentes en el álbum actual
+ *
+ * Conserva la extensión seleccionada si sigue existiendo en el nuevo álbum;
+ * si no, el filtro vuelve a "todos los tipos" también en la consulta del
+ * modelo, que si no seguiría filtrando por la extensión anterior.
+ * Las señales se bloquean para no recargar el modelo mientras se rellena.
+ */
+void AlbumWidget::updateExtensionFilter()
+{
+    PictureModel* pictureModel = mPictureModel->pictureModel();
+    QString current = mExtensionCombo->currentIndex() > 0
+                          ? mExtensionCombo->currentText() : QString();
+
+    mExtensionCombo->blockSignals(true);
+    while (mExtensionCombo->count() > 1) {
+        mExtensionCombo->removeItem(1);
+    }
+    mExtensionCombo->addItems(pictureModel->availableExtensions());
+    int index = mExtensionCombo->findText(current);
+    mExtensionCombo->setCurrentIndex(qMax(0, index));
+    mExtensionCombo->blockSignals(false);
+
+    if (!current.isEmpty() && index < 0) {
+        PictureQuery query = pictureModel->query();
+        query.extensions.clear();
+        pictureModel->setQuery(query);
+    }
+}
+
+/**
+ * Aplica la ordenación y los filtros seleccionados al modelo de imágenes
+ *
+ * El PictureModel recarga la primera página en el nuevo orden directamente
+ * desde SQL. Antes de recargar se guardan los IDs de las imágenes
+ * seleccionadas y después se vuelven a seleccionar, de modo que la
+ * selección del usuario sobrevive a la reordenación.
+ */
+void AlbumWidget::applyPictureQuery()
+{
+    if (!mPictureModel) {
+        return;
+    }
+
+    PictureModel* pictureModel = mPictureModel->pictureModel();
+
+    PictureQuery query = pictureModel->query();
+    query.sortKey = static_cast<PictureQuery::SortKey>(mSortCombo->currentData().toInt());
+    query.sortOrder = mSortOrderButton->isChecked() ? Qt::DescendingOrder : Qt::AscendingOrder;
+    query.nameContains = mNameFilterEdit->text().trimmed();
+    query.extensions.clear();
+    if (mExtensionCombo->currentIndex() > 0) {
+        query.extensions << mExtensionCombo->currentText();
+    }
+
+    // Guarda la selección actual por ID de imagen
+    QItemSelectionModel* selectionModel = ui->thumbnailListView->selectionModel();
+    QVector<int> selectedIds;
+    int currentId = 0;
+    if (selectionModel) {
+        for (const QModelIndex& index : selectionModel->selectedIndexes()) {
+            selectedIds << index.data(PictureModel::PictureIdRole).toInt();
+        }
+        currentId = selectionModel->currentIndex().data(PictureModel::PictureIdRole).toInt();
+    }
+
+    pictureModel->setQuery(query);
+
+    if (!selectionModel) {
+        return;
+    }
+
+    // Restaura primero la imagen actual (puede requerir cargar algunas páginas)
+    QModelIndex current;
+    if (currentId > 0) {
+        current = mPictureModel->mapFromSource(
+            pictureModel->indexForPictureId(currentId, PAGES_TO_RESTORE_SELECTION));
+    }
+
+    // Restaura el resto de la selección entre las filas ya cargadas, en una
+    // sola pasada y sin cargar más páginas
+    QItemSelection restored;
+    const QSet<int> selectedSet(selectedIds.cbegin(), selectedIds.cend());
+    for (int row = 0; row < pictureModel->rowCount() && !selectedSet.isEmpty(); ++row) {
+        QModelIndex source = pictureModel->index(row, 0);
+        if (selectedSet.contains(source.data(PictureModel::PictureIdRole).toInt())) {
+            QModelIndex index = mPictureModel->mapFromSource(source);
+            restored.select(index, index);
+        }
+    }
+    selectionModel->select(restored, QItemSelectionModel::ClearAndSelect);
+
+    if (current.isValid()) {
+        selectionModel->setCurrentIndex(current, QItemSelectionModel::NoUpdate);
+        ui->thumbnailListView->scrollTo(current);
+    }
 }
@@ -8,8 +8,16 @@ namespace Ui {
 }
 
 class AlbumModel;
+class ImportPipeline;
+class LibraryWatcher;
 class PictureModel;
+class QComboBox;
 class QItemSelectionModel;
+class QLineEdit;
+class QProgressDialog;
+class QPushButton;
+class QTimer;
+class QToolButton;
 class ThumbnailProxyModel;
 class AlbumWidget : public QWidget
 {
@@ -22,6 +30,13 @@ public:
     void setPictureModel(ThumbnailProxyModel* pictureModel);
     void setSelectionModel(QItemSelectionModel* selectionModel);
     void setPictureSelectionModel(QItemSelectionModel* selectionModel);
+    void setLibraryWatcher(LibraryWatcher* libraryWatcher);
+    QStringList visibleFilePaths() const;
+
+public slots:
+    void setSearchText(const QString& text);
+    void showDuplicates();
+    void showSimilarPictures(int pictureId);
 
 signals:
     void pictureActivated(const QModelIndex& index);
@@ -29,16 +44,37 @@ signals:
 private:
     void clearUi();
     void loadAlbum(const QModelIndex& albumIndex);
+    void updateExtensionFilter();
+    void connectImportPipeline();
     Ui::AlbumWidget* ui;
     AlbumModel* mAlbumModel;
     QItemSelectionModel* mAlbumSelectionModel;
     ThumbnailProxyModel* mPictureModel;
     QItemSelectionModel* mPictureSelectionModel;
 
+    // Controles de ordenación y filtrado
+    QComboBox* mSortCombo;
+    QToolButton* mSortOrderButton;
+    QLineEdit* mNameFilterEdit;
+    QComboBox* mExtensionCombo;
+    QTimer* mFilterTimer;
+
+    // Importación de carpetas en segundo plano
+    QPushButton* mImportFolderButton;
+    ImportPipeline* mImportPipeline;
+    QProgressDialog* mImportProgress;
+
+    // Carpetas vigiladas; la carpeta importada se vigila al terminar la importación
+    LibraryWatcher* mLibraryWatcher;
+    QString mWatchAfterImport;
+    int mWatchAlbumId;
+
 private slots:
     void deleteAlbum();
     void editAlbum();
     void addPictures();
+    void importFolder();
+    void applyPictureQuery();
 
 };
 
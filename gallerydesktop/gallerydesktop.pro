@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,6 +14,7 @@ SOURCES += \
     gallerywidget.cpp \
     main.cpp \
     mainwindow.cpp \
+    metricspanel.cpp \
     picturedelegate.cpp \
     picturewidget.cpp \
     thumbnailproxymodel.cpp
@@ -23,6 +24,7 @@ HEADERS += \
     albumwidget.h \
     gallerywidget.h \
     mainwindow.h \
+    metricspanel.h \
     picturedelegate.h \
     picturewidget.h \
     thumbnailproxymodel.h
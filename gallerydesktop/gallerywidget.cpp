@@ -5,6 +5,7 @@
 #include "albummodel.h"
 #include "picturemodel.h"
 #include "thumbnailproxymodel.h"
+#include "Trace.h"
 #include <QItemSelectionModel>
 
 /**
@@ -42,10 +43,14 @@ GalleryWidget::GalleryWidget(QWidget* parent)
                 this, &GalleryWidget::onPictureActivated);
     }
 
-    // Información de debug para verificar geometría y visibilidad
-    qDebug() << "AlbumWidget geometry:" << mAlbumWidget->geometry();
-    qDebug() << "AlbumWidget visible:" << mAlbumWidget->isVisible();
-    qDebug() << "AlbumWidget size:" << mAlbumWidget->size();
+    // La caja de búsqueda y el botón de duplicados de la lista de álbumes
+    // muestran sus resultados en el AlbumWidget como un álbum virtual
+    if (mAlbumListWidget && mAlbumWidget) {
+        connect(mAlbumListWidget, &AlbumListWidget::searchTextChanged,
+                mAlbumWidget, &AlbumWidget::setSearchText);
+        connect(mAlbumListWidget, &AlbumListWidget::duplicatesRequested,
+                mAlbumWidget, &AlbumWidget::showDuplicates);
+    }
 }
 
 /**
@@ -70,10 +75,10 @@ GalleryWidget::~GalleryWidget()
  */
 void GalleryWidget::setAlbumModel(AlbumModel* model)
 {
-    qDebug() << "=== GalleryWidget::setAlbumModel ===";
-    qDebug() << "model:" << model;
-    qDebug() << "mAlbumListWidget:" << mAlbumListWidget;
-    qDebug() << "mAlbumWidget:" << mAlbumWidget;
+    qCDebug(lcUi) << "=== GalleryWidget::setAlbumModel ===";
+    qCDebug(lcUi) << "model:" << model;
+    qCDebug(lcUi) << "mAlbumListWidget:" << mAlbumListWidget;
+    qCDebug(lcUi) << "mAlbumWidget:" << mAlbumWidget;
 
     // Seguridad: si no existe la lista de álbumes, no continuar
     if (!mAlbumListWidget) return;
@@ -87,7 +92,7 @@ void GalleryWidget::setAlbumModel(AlbumModel* model)
 
     // Asignación del modelo también al visor de álbumes
     if (mAlbumWidget) {
-        qDebug() << "Llamando a mAlbumWidget->setAlbumModel";
+        qCDebug(lcUi) << "Llamando a mAlbumWidget->setAlbumModel";
         mAlbumWidget->setAlbumModel(model);
 
         // Comparte el mismo modelo de selección entre vistas
@@ -110,25 +115,25 @@ void GalleryWidget::setAlbumModel(AlbumModel* model)
  */
 void GalleryWidget::setAlbumSelectionModel(QItemSelectionModel* selectionModel)
 {
-    qDebug() << "=== GalleryWidget::setAlbumSelectionModel ===";
-    qDebug() << "selectionModel:" << selectionModel;
-    qDebug() << "mAlbumWidget:" << mAlbumWidget;
+    qCDebug(lcUi) << "=== GalleryWidget::setAlbumSelectionModel ===";
+    qCDebug(lcUi) << "selectionModel:" << selectionModel;
+    qCDebug(lcUi) << "mAlbumWidget:" << mAlbumWidget;
 
     // Almacena el selection model para uso posterior
     mAlbumSelectionModel = selectionModel;
 
     // Asigna el selection model a la lista de álbumes
     if (mAlbumListWidget) {
-        qDebug() << "Asignando selectionModel a AlbumListWidget";
+        qCDebug(lcUi) << "Asignando selectionModel a AlbumListWidget";
         mAlbumListWidget->setSelectionModel(selectionModel);
     }
 
     // Asigna el mismo selection model al AlbumWidget
     if (mAlbumWidget) {
-        qDebug() << "Llamando a mAlbumWidget->setAlbumSelectionModel";
+        qCDebug(lcUi) << "Llamando a mAlbumWidget->setAlbumSelectionModel";
         mAlbumWidget->setAlbumSelectionModel(selectionModel);
     } else {
-        qDebug() << "ERROR: mAlbumWidget es NULL!";
+        qCWarning(lcUi) << "GalleryWidget sin AlbumWidget";
     }
 }
 
@@ -164,6 +169,36 @@ void GalleryWidget::setPictureSelectionModel(QItemSelectionModel* selectionModel
     mPictureSelectionModel = selectionModel;
 }
 
+/**
+ * Asigna el vigilante de carpetas al AlbumWidget
+ * @param libraryWatcher Sincroniza las carpetas vigiladas con el catálogo
+ */
+void GalleryWidget::setLibraryWatcher(LibraryWatcher* libraryWatcher)
+{
+    if (mAlbumWidget) {
+        mAlbumWidget->setLibraryWatcher(libraryWatcher);
+    }
+}
+
+/**
+ * Muestra en el AlbumWidget las imágenes parecidas a una imagen
+ * @param pictureId ID de la imagen de referencia
+ */
+void GalleryWidget::showSimilarPictures(int pictureId)
+{
+    if (mAlbumWidget) {
+        mAlbumWidget->showSimilarPictures(pictureId);
+    }
+}
+
+/**
+ * Rutas de las imágenes a la vista en el AlbumWidget
+ */
+QStringList GalleryWidget::visibleFilePaths() const
+{
+    return mAlbumWidget ? mAlbumWidget->visibleFilePaths() : QStringList();
+}
+
 /**
  * Slot que captura la activación de una imagen
  * @param index Índice del modelo correspondiente a la imagen activada
@@ -7,6 +7,7 @@
 class AlbumListWidget;
 class AlbumWidget;
 class AlbumModel;
+class LibraryWatcher;
 class ThumbnailProxyModel;
 class QItemSelectionModel;
 
@@ -26,6 +27,9 @@ public:
 
     void setPictureModel(ThumbnailProxyModel* model);
     void setPictureSelectionModel(QItemSelectionModel* selectionModel);
+    void setLibraryWatcher(LibraryWatcher* libraryWatcher);
+    void showSimilarPictures(int pictureId);
+    QStringList visibleFilePaths() const;
 
 signals:
     void pictureActivated(const QModelIndex& index);
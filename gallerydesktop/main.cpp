@@ -2,7 +2,49 @@
 #include "qfileinfo.h"
 #include <QTranslator>
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QImageReader>
+#include "DatabaseManager.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "StallDetector.h"
+#include "Trace.h"
+
+/**
+ * Diagnóstico de formatos de imagen (opción --diagnostics)
+ *
+ * Lista los formatos que Qt puede leer y comprueba que se puede guardar y
+ * volver a cargar una imagen. Se ejecuta después del primer frame, así que
+ * no retrasa la aparición de la ventana.
+ */
+static void runImageDiagnostics()
+{
+    // Muestra todos los formatos de imagen soportados por Qt
+    qDebug() << "=== Formatos de imagen soportados ===";
+    QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for (const QByteArray& format : formats) {
+        qDebug() << "  -" << format;
+    }
+
+    // Crea una imagen de prueba en memoria, rellena de rojo
+    QImage testImage(200, 200, QImage::Format_RGB32);
+    testImage.fill(Qt::red);
+
+    // La imagen de prueba se guarda en la carpeta temporal del sistema
+    QString testNewPath = QDir::temp().filePath("gallery-diagnostics.png");
+
+    // Guarda la imagen en formato PNG
+    bool saved = testImage.save(testNewPath, "PNG");
+    qDebug() << "Imagen de prueba guardada:" << saved << "en" << testNewPath;
+
+    // Intenta cargar la imagen guardada como QPixmap
+    QPixmap testPixmap(testNewPath);
+    qDebug() << "Test pixmap null:" << testPixmap.isNull();
+
+    QFile::remove(testNewPath);
+}
 
 /**
  * Punto de entrada principal de la aplicación Qt
@@ -11,16 +53,43 @@
  * - Inicializar QApplication
  * - Detectar el idioma del sistema
  * - Cargar traducciones si están disponibles
- * - Verificar formatos de imagen soportados
- * - Realizar pruebas de guardado y carga de imágenes
  * - Crear y mostrar la ventana principal
+ * - Medir el tiempo hasta el primer frame
+ * - Activar la traza de rendimiento si se ha pedido (ver Trace)
+ * - Activar el volcado de métricas si se ha pedido (ver Metrics)
+ * - Vigilar los bloqueos del hilo de la interfaz (ver StallDetector)
+ *
+ * Opciones:
+ * --diagnostics          Verifica los formatos de imagen tras el arranque
+ * --no-startup-snapshot  Arranca sin la instantánea (carga todo del catálogo)
+ * --catalog <archivo>    Catálogo a abrir (":memory:" para uno en memoria);
+ *                        sin la opción, GALLERY_CATALOG o la configuración
  */
 int main(int argc, char *argv[])
 {
+    // Mide el arranque desde el primer momento
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     // Inicializa la aplicación Qt
     // Gestiona el loop de eventos, estilos, traducciones, etc.
     QApplication a(argc, argv);
 
+    // Traza de rendimiento (GALLERY_TRACE=archivo.json): se escribe al salir
+    Trace::startFromEnvironment();
+
+    // Métricas (GALLERY_METRICS=archivo.json): volcado periódico y al salir
+    Metrics::instance().startFromEnvironment();
+
+    // Consultas SQL lentas (GALLERY_SLOW_QUERY_MS) y estadísticas por
+    // sentencia (GALLERY_SQL_STATS=archivo.json)
+    QueryProfiler::startFromEnvironment();
+
+    // Vigilante de bloqueos de la interfaz: apunta en un log cada vez que el
+    // bucle de eventos tarda más de 50 ms (GALLERY_STALL_THRESHOLD_MS=0 lo
+    // desactiva)
+    StallDetector::startFromEnvironment(&a);
+
     /**
      * =========================
      * DETECCIÓN DE IDIOMA
@@ -33,7 +102,7 @@ int main(int argc, char *argv[])
     // Extrae el idioma base ("es", "en", etc.)
     // Ejemplo: "es_ES" -> "es"
     QString language = locale.name().section('_', 0, 0);
-    qDebug() << "Idioma del sistema:" << language;
+    qCDebug(lcUi) << "Idioma del sistema:" << language;
 
     /**
      * =========================
@@ -50,51 +119,37 @@ int main(int argc, char *argv[])
         if(translator.load(":/translations/translations/ch03_gallery_core_es_ES.qm")) {
             // Instala el traductor en la aplicación
             a.installTranslator(&translator);
-            qDebug() << "Traducción española cargada.";
+            qCDebug(lcUi) << "Traducción española cargada.";
         } else {
             // Debug en caso de error de carga
-            qDebug() << "No se pudo cargar app_es.qm";
+            qCWarning(lcUi) << "No se pudo cargar app_es.qm";
         }
     }
 
     /**
      * =========================
-     * DEBUG: FORMATOS DE IMAGEN
+     * OPCIONES DE LÍNEA DE COMANDOS
      * =========================
      */
 
-    // Muestra todos los formatos de imagen soportados por Qt
-    qDebug() << "=== Formatos de imagen soportados ===";
-    QList<QByteArray> formats = QImageReader::supportedImageFormats();
-    for (const QByteArray& format : formats) {
-        qDebug() << "  -" << format;
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption diagnosticsOption(
+        "diagnostics", QApplication::translate("main", "Check the supported image formats after startup."));
+    QCommandLineOption noSnapshotOption(
+        "no-startup-snapshot", QApplication::translate("main", "Load everything from the catalog instead of the startup snapshot."));
+    QCommandLineOption catalogOption(
+        "catalog", QApplication::translate("main", "Catalog file to open, or :memory: for an empty in-memory catalog."), "file");
+    parser.addOption(diagnosticsOption);
+    parser.addOption(noSnapshotOption);
+    parser.addOption(catalogOption);
+    parser.process(a);
+
+    // Debe fijarse antes de que algo abra el catálogo
+    if (parser.isSet(catalogOption)) {
+        DatabaseManager::setCatalogPath(parser.value(catalogOption));
     }
 
-    /**
-     * =========================
-     * DEBUG: PRUEBA DE IMÁGENES
-     * =========================
-     */
-
-    // Crea una imagen de prueba en memoria
-    QImage testImage(200, 200, QImage::Format_RGB32);
-
-    // Rellena la imagen con color rojo
-    testImage.fill(Qt::red);
-
-    // Ruta donde se guardará la imagen de prueba
-    QString testNewPath = "C:/Users/Edgar/Pictures/Gallery/test.png";
-
-    // Guarda la imagen en formato PNG
-    bool saved = testImage.save(testNewPath, "PNG");
-    qDebug() << "Imagen de prueba guardada:" << saved << "en" << testNewPath;
-
-    // Intenta cargar la imagen guardada como QPixmap
-    QPixmap testPixmap(testNewPath);
-
-    // Verifica si el pixmap se cargó correctamente
-    qDebug() << "Test pixmap null:" << testPixmap.isNull();
-
     /**
      * =========================
      * CREACIÓN DE LA UI
@@ -102,7 +157,17 @@ int main(int argc, char *argv[])
      */
 
     // Crea la ventana principal de la aplicación
-    MainWindow w;
+    MainWindow w(nullptr, !parser.isSet(noSnapshotOption));
+
+    // Tiempo hasta el primer frame: desde el inicio del proceso hasta que la
+    // ventana se ha pintado por primera vez. El diagnóstico va después.
+    QObject::connect(&w, &MainWindow::firstFrameShown, &w, [&] {
+        qInfo() << "Primer frame en" << startupTimer.elapsed() << "ms"
+                << (w.isStartupSnapshotUsed() ? "(desde la instantánea de arranque)" : "");
+        if (parser.isSet(diagnosticsOption)) {
+            runImageDiagnostics();
+        }
+    });
 
     // Muestra la ventana principal
     w.show();
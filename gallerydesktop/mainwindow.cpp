@@ -5,8 +5,17 @@
 #include "albummodel.h"
 #include "picturemodel.h"
 #include "thumbnailproxymodel.h"
+#include "LibraryWatcher.h"
+#include "metricspanel.h"
+#include "Trace.h"
 #include <QStackedWidget>
 #include <QItemSelectionModel>
+#include <QCloseEvent>
+#include <QFutureWatcher>
+#include <QSqlDatabase>
+#include <QTimer>
+#include <QShortcut>
+#include <QtConcurrent>
 #include <QDebug>
 
 /**
@@ -18,9 +27,16 @@
  * - Inicializa los widgets principales
  * - Centraliza los QItemSelectionModel
  * - Controla la navegación entre vistas (galería ↔ imagen)
+ *
+ * @param useStartupSnapshot Arrancar desde la instantánea guardada al cerrar
+ *        (lista de álbumes, último álbum y sus thumbnails visibles) y
+ *        comprobarla con el catálogo en segundo plano
  */
-MainWindow::MainWindow(QWidget* parent)
-    : QMainWindow(parent)
+MainWindow::MainWindow(QWidget* parent, bool useStartupSnapshot)
+    : QMainWindow(parent),
+    mMetricsPanel(nullptr),
+    mStartupSnapshotUsed(false),
+    mFirstFrameShown(false)
 {
     /**
      * =========================
@@ -55,8 +71,19 @@ MainWindow::MainWindow(QWidget* parent)
      * =========================
      */
 
+    // Catálogo de la ventana: todos los modelos trabajan sobre el mismo
+    DatabaseManager& database = DatabaseManager::instance();
+
+    // Instantánea de arranque del catálogo: si existe, los modelos se
+    // rellenan con ella sin consultar el catálogo ni decodificar los
+    // thumbnails visibles. Un catálogo en memoria empieza vacío y no tiene
+    mStartupSnapshotUsed = useStartupSnapshot && !database.isInMemory()
+                           && mStartupSnapshot.load(StartupSnapshot::pathForCatalog(database.path()));
+
     // Modelo que contiene la lista de álbumes
-    AlbumModel* albumModel = new AlbumModel(this);
+    AlbumModel* albumModel = mStartupSnapshotUsed
+                                 ? new AlbumModel(database, mStartupSnapshot.albums, this)
+                                 : new AlbumModel(database, this);
 
     // Modelo de selección para los álbumes (compartido entre vistas)
     QItemSelectionModel* albumSelectionModel =
@@ -67,36 +94,56 @@ MainWindow::MainWindow(QWidget* parent)
         new PictureModel(*albumModel, this);
 
     // Proxy model para mostrar miniaturas (thumbnails)
-    ThumbnailProxyModel* thumbnailModel = new ThumbnailProxyModel(this);
+    ThumbnailProxyModel* thumbnailModel = new ThumbnailProxyModel(database, this);
     thumbnailModel->setSourceModel(pictureModel);
 
     // Modelo de selección para las imágenes (basado en el proxy model)
     QItemSelectionModel* pictureSelectionModel =
         new QItemSelectionModel(thumbnailModel, this);
 
+    if (mStartupSnapshotUsed) {
+        pictureModel->restoreStartupState(mStartupSnapshot);
+        thumbnailModel->preloadThumbnails(mStartupSnapshot.thumbnails);
+        mStartupSnapshot.thumbnails.clear();
+    }
+
+    // Sincroniza las carpetas vigiladas con el catálogo (después de crear
+    // los modelos, que reciben sus avisos a través de CatalogNotifier)
+    // Recorrer las carpetas puede tardar: empieza tras el primer frame
+    LibraryWatcher* libraryWatcher = new LibraryWatcher(database, this);
+
+    mAlbumModel = albumModel;
+    mAlbumSelectionModel = albumSelectionModel;
+    mPictureModel = pictureModel;
+    mThumbnailModel = thumbnailModel;
+    mLibraryWatcher = libraryWatcher;
+
     /**
      * =========================
      * ASIGNACIÓN DE MODELOS
      * =========================
      */
 
-    qDebug() << "=== MainWindow: Asignando modelos ===";
+    qCDebug(lcUi) << "=== MainWindow: Asignando modelos ===";
 
     // Asigna el modelo de álbumes a GalleryWidget
     mGalleryWidget->setAlbumModel(albumModel);
-    qDebug() << "AlbumModel asignado";
+    qCDebug(lcUi) << "AlbumModel asignado";
 
     // Asigna el modelo de selección de álbumes
     mGalleryWidget->setAlbumSelectionModel(albumSelectionModel);
-    qDebug() << "AlbumSelectionModel asignado";
+    qCDebug(lcUi) << "AlbumSelectionModel asignado";
 
     // Asigna el modelo de imágenes (thumbnails)
     mGalleryWidget->setPictureModel(thumbnailModel);
-    qDebug() << "PictureModel asignado";
+    qCDebug(lcUi) << "PictureModel asignado";
 
     // Asigna el modelo de selección de imágenes
     mGalleryWidget->setPictureSelectionModel(pictureSelectionModel);
-    qDebug() << "PictureSelectionModel asignado";
+    qCDebug(lcUi) << "PictureSelectionModel asignado";
+
+    // Asigna el vigilante de carpetas (para vigilar las carpetas importadas)
+    mGalleryWidget->setLibraryWatcher(libraryWatcher);
 
     // Asigna los modelos directamente al PictureWidget
     mPictureWidget->setModel(thumbnailModel);
@@ -116,6 +163,18 @@ MainWindow::MainWindow(QWidget* parent)
     connect(mPictureWidget, &PictureWidget::backToGallery,
             this, &MainWindow::displayGallery);
 
+    // Botón "similares" desde PictureWidget → galería con las imágenes parecidas
+    connect(mPictureWidget, &PictureWidget::similarPicturesRequested,
+            this, [this](int pictureId) {
+                mGalleryWidget->showSimilarPictures(pictureId);
+                displayGallery();
+            });
+
+    // Ctrl+Shift+D → panel de métricas (latencias, aciertos de caché...)
+    QShortcut* metricsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    connect(metricsShortcut, &QShortcut::activated,
+            this, &MainWindow::toggleMetricsPanel);
+
     /**
      * =========================
      * CONFIGURACIÓN DEL STACK
@@ -129,6 +188,15 @@ MainWindow::MainWindow(QWidget* parent)
     // Vista inicial: galería
     displayGallery();
 
+    // Con la instantánea, se vuelve a abrir el último álbum (sus filas ya
+    // están en el modelo, así que no se consulta la base de datos)
+    if (mStartupSnapshotUsed) {
+        QModelIndex albumIndex = albumModel->indexForAlbumId(mStartupSnapshot.albumId);
+        if (albumIndex.isValid()) {
+            albumSelectionModel->setCurrentIndex(albumIndex, QItemSelectionModel::ClearAndSelect);
+        }
+    }
+
     // Establece el stacked widget como contenido central
     setCentralWidget(mStackedWidget);
 
@@ -160,6 +228,142 @@ MainWindow::~MainWindow()
 {
 }
 
+/**
+ * Indica si la ventana ha arrancado desde la instantánea de arranque
+ */
+bool MainWindow::isStartupSnapshotUsed() const
+{
+    return mStartupSnapshotUsed;
+}
+
+/**
+ * Pinta la ventana y detecta el primer frame
+ *
+ * El trabajo que no hace falta para mostrar la ventana se lanza justo
+ * después (con un temporizador a 0, cuando el frame ya se ha pintado).
+ */
+void MainWindow::paintEvent(QPaintEvent* event)
+{
+    QMainWindow::paintEvent(event);
+
+    if (!mFirstFrameShown) {
+        mFirstFrameShown = true;
+        QTimer::singleShot(0, this, &MainWindow::onFirstFrame);
+    }
+}
+
+/**
+ * Trabajo aplazado hasta después del primer frame
+ */
+void MainWindow::onFirstFrame()
+{
+    emit firstFrameShown();
+
+    mLibraryWatcher->start();
+    if (mStartupSnapshotUsed) {
+        reconcileStartupSnapshot();
+    }
+}
+
+/**
+ * Compara la instantánea de arranque con el catálogo en segundo plano
+ *
+ * La comparación usa su propia conexión (SQLite en modo WAL) en un hilo del
+ * pool; al terminar, en el hilo de la interfaz, se recarga solo lo que haya
+ * cambiado desde que se guardó la instantánea.
+ */
+void MainWindow::reconcileStartupSnapshot()
+{
+    const DatabaseManager* database = &mAlbumModel->database();
+    const StartupSnapshot snapshot = std::move(mStartupSnapshot);
+    mStartupSnapshot = StartupSnapshot();
+
+    auto* watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this,
+            [this, watcher, albumId = snapshot.albumId] {
+                int changed = watcher->result();
+                watcher->deleteLater();
+                qCDebug(lcUi) << "Instantánea de arranque comprobada, cambios:" << changed;
+
+                if (changed & StartupSnapshot::PicturesPart) {
+                    mPictureModel->invalidateAlbum(albumId);
+                }
+                if (changed & StartupSnapshot::AlbumsPart) {
+                    // Recargar los álbumes pierde la selección; se restaura
+                    int currentAlbumId = mAlbumSelectionModel->currentIndex()
+                                             .data(AlbumModel::IdRole).toInt();
+                    mAlbumModel->reload();
+                    QModelIndex albumIndex = mAlbumModel->indexForAlbumId(currentAlbumId);
+                    if (albumIndex.isValid()) {
+                        mAlbumSelectionModel->setCurrentIndex(
+                            albumIndex, QItemSelectionModel::ClearAndSelect);
+                    }
+                }
+            });
+
+    watcher->setFuture(QtConcurrent::run([snapshot, database] {
+        const QString connectionName = QStringLiteral("gallery-startup");
+        int changed = StartupSnapshot::AlbumsPart | StartupSnapshot::PicturesPart;
+        {
+            QSqlDatabase connection = database->openConnection(connectionName);
+            if (connection.isOpen()) {
+                changed = snapshot.differences(connection);
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+        return changed;
+    }));
+}
+
+/**
+ * Guarda la instantánea de arranque al cerrar la ventana
+ */
+void MainWindow::closeEvent(QCloseEvent* event)
+{
+    saveStartupSnapshot();
+    QMainWindow::closeEvent(event);
+}
+
+/**
+ * Guarda la lista de álbumes, el álbum abierto y sus thumbnails a la vista
+ */
+void MainWindow::saveStartupSnapshot() const
+{
+    // Un catálogo en memoria desaparece al cerrar: no hay nada que recordar
+    DatabaseManager& database = mAlbumModel->database();
+    if (database.isInMemory()) {
+        return;
+    }
+
+    StartupSnapshot snapshot;
+    snapshot.albums = mAlbumModel->albums();
+    mPictureModel->saveStartupState(snapshot);
+
+    if (!snapshot.rows.isEmpty()) {
+        for (const QString& filePath : mGalleryWidget->visibleFilePaths()) {
+            QImage thumbnail = mThumbnailModel->cachedThumbnail(filePath);
+            if (!thumbnail.isNull()) {
+                snapshot.thumbnails.insert(filePath, thumbnail);
+            }
+        }
+    }
+
+    if (!snapshot.save(StartupSnapshot::pathForCatalog(database.path()))) {
+        qCWarning(lcUi) << "No se pudo guardar la instantánea de arranque";
+    }
+}
+
+/**
+ * Muestra u oculta el panel de métricas
+ */
+void MainWindow::toggleMetricsPanel()
+{
+    if (!mMetricsPanel) {
+        mMetricsPanel = new MetricsPanel(this);
+    }
+    mMetricsPanel->setVisible(!mMetricsPanel->isVisible());
+}
+
 /**
  * Muestra la vista de galería
  *
@@ -180,9 +384,7 @@ void MainWindow::displayGallery()
  */
 void MainWindow::displayPicture(const QModelIndex& index)
 {
-    qDebug() << "=== MainWindow::displayPicture ===";
-    qDebug() << "Index row:" << index.row();
-    qDebug() << "Index válido:" << index.isValid();
+    GALLERY_TRACE_SCOPE(lcUi, "MainWindow::displayPicture");
 
     // Establece la imagen actual antes de cambiar de vista
     mPictureWidget->setCurrentIndex(index);
@@ -3,27 +3,64 @@
 
 #include <QMainWindow>
 #include <QStackedWidget>
+#include "StartupSnapshot.h"
 namespace Ui {
 class MainWindow;
 }
 
+class AlbumModel;
 class GalleryWidget;
+class LibraryWatcher;
+class MetricsPanel;
+class PictureModel;
 class PictureWidget;
+class QItemSelectionModel;
+class ThumbnailProxyModel;
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    explicit MainWindow(QWidget *parent = 0, bool useStartupSnapshot = true);
     ~MainWindow();
 
+    bool isStartupSnapshotUsed() const;
+
+signals:
+    // Se emite una vez, justo después de pintar la ventana por primera vez
+    void firstFrameShown();
+
 public slots:
     void displayGallery();
     void displayPicture(const QModelIndex& index);
 
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
+
 private:
+    void onFirstFrame();
+    void reconcileStartupSnapshot();
+    void saveStartupSnapshot() const;
+    void toggleMetricsPanel();
+
     Ui::MainWindow *ui;
     GalleryWidget* mGalleryWidget;
     PictureWidget* mPictureWidget;
     QStackedWidget* mStackedWidget;
+
+    AlbumModel* mAlbumModel;
+    QItemSelectionModel* mAlbumSelectionModel;
+    PictureModel* mPictureModel;
+    ThumbnailProxyModel* mThumbnailModel;
+    LibraryWatcher* mLibraryWatcher;
+
+    // Panel de métricas (Ctrl+Shift+D), se crea la primera vez que se abre
+    MetricsPanel* mMetricsPanel;
+
+    // Instantánea con la que se ha arrancado, pendiente de comprobar con el
+    // catálogo (ver reconcileStartupSnapshot)
+    StartupSnapshot mStartupSnapshot;
+    bool mStartupSnapshotUsed;
+    bool mFirstFrameShown;
 };
 #endif // MAINWINDOW_H
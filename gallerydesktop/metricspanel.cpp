@@ -0,0 +1,150 @@
+#include "metricspanel.h"
+#include "Metrics.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonObject>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+// Intervalo de refresco del panel mientras está visible
+const int REFRESH_INTERVAL_MS = 1000;
+
+// Columnas del árbol de métricas
+enum MetricColumn {
+    NameColumn = 0,
+    ValueColumn,
+    P50Column,
+    P90Column,
+    P99Column,
+    MaxColumn
+};
+
+/**
+ * Busca el hijo de un grupo con un nombre dado o lo crea
+ */
+static QTreeWidgetItem* childItem(QTreeWidgetItem* group, const QString& name)
+{
+    for (int row = 0; row < group->childCount(); ++row) {
+        if (group->child(row)->text(NameColumn) == name) {
+            return group->child(row);
+        }
+    }
+    QTreeWidgetItem* item = new QTreeWidgetItem(group, QStringList(name));
+    for (int column = ValueColumn; column <= MaxColumn; ++column) {
+        item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    return item;
+}
+
+/**
+ * Constructor de MetricsPanel
+ * @param parent Widget padre (la ventana principal)
+ *
+ * Ventana de herramientas con las métricas de Metrics agrupadas en
+ * contadores, indicadores e histogramas. Solo se refresca mientras está
+ * visible, así que cerrada no cuesta nada.
+ */
+MetricsPanel::MetricsPanel(QWidget* parent)
+    : QWidget(parent, Qt::Tool),
+    mTree(new QTreeWidget(this)),
+    mRefreshTimer(new QTimer(this))
+{
+    setWindowTitle(tr("Metrics"));
+    resize(640, 480);
+
+    mTree->setColumnCount(MaxColumn + 1);
+    mTree->setHeaderLabels({ tr("Metric"), tr("Value"), tr("p50"), tr("p90"), tr("p99"), tr("Max") });
+    mTree->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    mTree->header()->setStretchLastSection(false);
+    mTree->setRootIsDecorated(true);
+
+    // Un grupo por tipo de métrica, en el mismo orden que el JSON
+    for (const QString& group : { tr("Counters"), tr("Gauges"), tr("Histograms") }) {
+        QTreeWidgetItem* item = new QTreeWidgetItem(mTree, QStringList(group));
+        item->setExpanded(true);
+    }
+
+    QPushButton* saveButton = new QPushButton(tr("Save JSON..."), this);
+    connect(saveButton, &QPushButton::clicked, this, &MetricsPanel::saveJson);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(saveButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(mTree);
+    layout->addLayout(buttonLayout);
+
+    mRefreshTimer->setInterval(REFRESH_INTERVAL_MS);
+    connect(mRefreshTimer, &QTimer::timeout, this, &MetricsPanel::refresh);
+}
+
+/**
+ * Actualiza los valores con una instantánea del registro de métricas
+ *
+ * Las filas se actualizan en su sitio (no se recrean) para conservar la
+ * selección y el desplazamiento; las métricas nuevas se añaden al final.
+ */
+void MetricsPanel::refresh()
+{
+    const QJsonObject json = Metrics::instance().toJson();
+
+    const QJsonObject counters = json.value("counters").toObject();
+    QTreeWidgetItem* countersGroup = mTree->topLevelItem(0);
+    for (auto it = counters.begin(); it != counters.end(); ++it) {
+        childItem(countersGroup, it.key())->setText(ValueColumn, QString::number(it.value().toInteger()));
+    }
+
+    const QJsonObject gauges = json.value("gauges").toObject();
+    QTreeWidgetItem* gaugesGroup = mTree->topLevelItem(1);
+    for (auto it = gauges.begin(); it != gauges.end(); ++it) {
+        childItem(gaugesGroup, it.key())->setText(ValueColumn, QString::number(it.value().toInteger()));
+    }
+
+    // En los histogramas la columna "valor" es el número de muestras
+    const QJsonObject histograms = json.value("histograms").toObject();
+    QTreeWidgetItem* histogramsGroup = mTree->topLevelItem(2);
+    for (auto it = histograms.begin(); it != histograms.end(); ++it) {
+        const QJsonObject values = it.value().toObject();
+        QTreeWidgetItem* item = childItem(histogramsGroup, it.key());
+        item->setText(ValueColumn, QString::number(values.value("count").toInteger()));
+        item->setText(P50Column, QString::number(values.value("p50").toInteger()));
+        item->setText(P90Column, QString::number(values.value("p90").toInteger()));
+        item->setText(P99Column, QString::number(values.value("p99").toInteger()));
+        item->setText(MaxColumn, QString::number(values.value("max").toInteger()));
+    }
+}
+
+/**
+ * Refresca al mostrarse y mientras siga visible
+ */
+void MetricsPanel::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    mRefreshTimer->start();
+}
+
+/**
+ * Deja de refrescar al ocultarse
+ */
+void MetricsPanel::hideEvent(QHideEvent* event)
+{
+    mRefreshTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+/**
+ * Guarda una instantánea de las métricas en el archivo que elija el usuario
+ */
+void MetricsPanel::saveJson()
+{
+    const QString filePath = QFileDialog::getSaveFileName(
+        this, tr("Save metrics"), "metrics.json", tr("JSON files (*.json)"));
+    if (!filePath.isEmpty()) {
+        Metrics::instance().writeJson(filePath);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef METRICSPANEL_H
+#define METRICSPANEL_H
+
+#include <QWidget>
+
+class QTimer;
+class QTreeWidget;
+
+class MetricsPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MetricsPanel(QWidget* parent = 0);
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    void saveJson();
+
+    QTreeWidget* mTree;
+    QTimer* mRefreshTimer;
+};
+
+#endif // METRICSPANEL_H
@@ -6,6 +6,7 @@
 #include <QMessageBox>
 #include <QFile>
 #include "PictureModel.h"
+#include "Trace.h"
 
 /**
  * Constructor de PictureWidget
@@ -16,12 +17,14 @@
  * - Permitir navegación (anterior / siguiente)
  * - Mostrar el nombre del archivo
  * - Eliminar la imagen seleccionada
+ * - Buscar imágenes parecidas a la actual
  */
 PictureWidget::PictureWidget(QWidget *parent)
     : QWidget(parent),
     ui(new Ui::PictureWidget),
     mModel(nullptr),
-    mSelectionModel(nullptr)
+    mSelectionModel(nullptr),
+    mSimilarButton(new QPushButton(tr("Similar"), this))
 {
     // Inicializa la interfaz gráfica
     ui->setupUi(this);
@@ -43,6 +46,19 @@ PictureWidget::PictureWidget(QWidget *parent)
     connect(ui->backButton, &QPushButton::clicked,
             this, &PictureWidget::backToGallery);
 
+    // Botón de imágenes parecidas, a la derecha de la barra
+    // Muestra en la galería las imágenes parecidas a la actual
+    ui->gridLayout->addWidget(mSimilarButton, 0, 6);
+    connect(mSimilarButton, &QPushButton::clicked, this, [this] {
+        if (!mModel || !mSelectionModel) return;
+
+        QModelIndex currentIndex = mSelectionModel->currentIndex();
+        if (currentIndex.isValid()) {
+            emit similarPicturesRequested(
+                mModel->data(currentIndex, PictureModel::PictureIdRole).toInt());
+        }
+    });
+
     // Botón imagen anterior
     connect(ui->previousButton, &QPushButton::clicked, this, [this] {
         if (!mSelectionModel) return;
@@ -61,6 +77,12 @@ PictureWidget::PictureWidget(QWidget *parent)
         if (!mSelectionModel) return;
 
         int row = mSelectionModel->currentIndex().row();
+
+        // Si estamos en la última imagen cargada, pide la siguiente página
+        if (mModel && row == mModel->rowCount() - 1 && mModel->canFetchMore(QModelIndex())) {
+            mModel->fetchMore(QModelIndex());
+        }
+
         if (mModel && row < mModel->rowCount() - 1) {
             mSelectionModel->setCurrentIndex(
                 mModel->index(row + 1, 0),
@@ -81,13 +103,11 @@ PictureWidget::PictureWidget(QWidget *parent)
  */
 void PictureWidget::setCurrentIndex(const QModelIndex& index)
 {
-    qDebug() << "=== PictureWidget::setCurrentIndex ===";
-    qDebug() << "Index válido:" << index.isValid();
-    qDebug() << "Index row:" << index.row();
+    GALLERY_TRACE_SCOPE(lcUi, "PictureWidget::setCurrentIndex");
+    qCDebug(lcUi) << "setCurrentIndex:" << index.row();
 
     // Validaciones básicas
     if (!index.isValid() || !mSelectionModel) {
-        qDebug() << "Index inválido o no hay selectionModel";
         return;
     }
 
@@ -103,9 +123,8 @@ void PictureWidget::setCurrentIndex(const QModelIndex& index)
         if (decoration.canConvert<QPixmap>()) {
             mPixmap = qvariant_cast<QPixmap>(decoration);
             updatePicturePixmap();
-            qDebug() << "Imagen cargada correctamente";
         } else {
-            qDebug() << "ERROR: No se pudo convertir a QPixmap";
+            qCDebug(lcUi) << "La imagen no se puede convertir a QPixmap:" << index.row();
         }
     }
 }
@@ -120,6 +139,8 @@ void PictureWidget::setCurrentIndex(const QModelIndex& index)
  */
 void PictureWidget::updatePicturePixmap()
 {
+    GALLERY_TRACE_SCOPE(lcUi, "PictureWidget::updatePicturePixmap");
+
     // Si no hay imagen, limpiar la vista
     if (mPixmap.isNull()) {
         ui->picturelabel->clear();
@@ -10,6 +10,7 @@ class PictureWidget;
 
     class PictureModel;
     class QItemSelectionModel;
+    class QPushButton;
     class ThumbnailProxyModel;
     class PictureWidget : public QWidget
 {
@@ -22,6 +23,7 @@ public:
 
 signals:
     void backToGallery();
+    void similarPicturesRequested(int pictureId);
 
 public slots:
     void setCurrentIndex(const QModelIndex& index);
@@ -39,6 +41,7 @@ private:
     ThumbnailProxyModel* mModel;
     QItemSelectionModel* mSelectionModel;
     QPixmap mPixmap;
+    QPushButton* mSimilarButton;
 
 };
 #endif // PICTUREWIDGET_H
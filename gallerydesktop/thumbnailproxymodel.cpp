@@ -1,17 +1,37 @@
 #include "thumbnailproxymodel.h"
 #include "Picturemodel.h"
-#include "qfileinfo.h"
-#include <QImageReader>
+#include "DatabaseManager.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 // Tamaño máximo (ancho y alto) de los thumbnails generados
-const unsigned int THUMBNAIL_SIZE = 350;
+const int THUMBNAIL_SIZE = 350;
+
+// Memoria máxima de la caché de thumbnails, en KB (unos 500 thumbnails)
+const int THUMBNAIL_CACHE_KB = 256 * 1024;
 
 // Constructor del proxy model
 // Usa QIdentityProxyModel porque no altera estructura ni índices,
 // solo modifica los datos que expone (en este caso, DecorationRole)
-ThumbnailProxyModel::ThumbnailProxyModel(QObject* parent)
-    : QIdentityProxyModel(parent)
+// database es el catálogo del modelo fuente, del que llegan los avisos
+ThumbnailProxyModel::ThumbnailProxyModel(DatabaseManager& database, QObject* parent)
+    : QIdentityProxyModel(parent),
+    mThumbnails(THUMBNAIL_CACHE_KB),
+    mDiskCache(THUMBNAIL_SIZE)
 {
+    mPrefetchTimer.setSingleShot(true);
+    mPrefetchTimer.setInterval(0);
+    connect(&mPrefetchTimer, &QTimer::timeout,
+            this, [this] { reloadThumbnails(); });
+
+    // Los archivos modificados en disco (ver LibraryWatcher) tienen un
+    // thumbnail nuevo en la caché de disco; se descarta el de memoria
+    connect(&database.notifier, &CatalogNotifier::filesModified,
+            this, [this] (const QStringList& paths) {
+                for (const QString& path : paths) {
+                    mThumbnails.remove(path);
+                }
+            });
 }
 
 // Genera thumbnails a partir de un índice inicial y una cantidad de filas
@@ -19,10 +39,8 @@ void ThumbnailProxyModel::generateThumbnails(
     const QModelIndex& startIndex,
     int count)
 {
-    // Mensajes de depuración
-    qDebug() << "=== generateThumbnails ===";
-    qDebug() << "startIndex válido:" << startIndex.isValid();
-    qDebug() << "count:" << count;
+    GALLERY_TRACE_SCOPE(lcThumbnails, "generateThumbnails");
+    qCDebug(lcThumbnails) << "generateThumbnails" << startIndex.row() << count;
 
     // Si el índice inicial no es válido, no se genera nada
     if (!startIndex.isValid()) {
@@ -42,74 +60,87 @@ void ThumbnailProxyModel::generateThumbnails(
         QString filepath = model->data(model->index(row, 0),
                                        PictureModel::PictureRole::FilePathRole).toString();
 
-        qDebug() << "  Generando thumbnail para:" << filepath;
-
-        // Convierte la ruta (posiblemente URL) a ruta local
-        QUrl url(filepath);
-        QString localPath = url.toLocalFile();
-
-        // Información de depuración sobre la ruta
-        qDebug() << "  URL original:" << filepath;
-        qDebug() << "  Ruta local:" << localPath;
-
-        // Información del archivo en disco
-        QFileInfo fileInfo(localPath);
-        qDebug() << "  Archivo existe:" << fileInfo.exists();
-        qDebug() << "  Es archivo:" << fileInfo.isFile();
-        qDebug() << "  Ruta absoluta:" << fileInfo.absoluteFilePath();
-        qDebug() << "  Tamaño:" << fileInfo.size() << "bytes";
-        qDebug() << "  Extensión:" << fileInfo.suffix();
-        qDebug() << "  Es legible:" << fileInfo.isReadable();
-
-        // Lector de imágenes para comprobar formato y lectura
-        QImageReader reader(localPath);
-        qDebug() << "  Formato detectado:" << reader.format();
-        qDebug() << "  Puede leer:" << reader.canRead();
-
-        // Si no puede leer, se muestra el error
-        if (!reader.canRead()) {
-            qDebug() << "  Error QImageReader:" << reader.errorString();
+        // Si el thumbnail sigue en la caché (por ejemplo, de un álbum visitado
+        // hace poco) no se vuelve a decodificar la imagen
+        if (mThumbnails.contains(filepath)) {
+            GALLERY_METRIC_ADD("thumbnails.memory.hits", 1);
+            continue;
         }
 
-        // Carga la imagen como QPixmap
-        QPixmap pixmap(localPath);
+        loadThumbnail(filepath);
+    }
+}
 
-        // Comprobación de carga correcta
-        if (pixmap.isNull()) {
-            qDebug() << "  ERROR: QPixmap es null para:" << localPath;
-        } else {
-            qDebug() << "  OK: Pixmap cargado, tamaño:" << pixmap.size();
-        }
+// Carga una imagen, crea su thumbnail y lo guarda en la caché
+// Devuelve el thumbnail (propiedad de la caché)
+QPixmap* ThumbnailProxyModel::loadThumbnail(const QString& filepath) const
+{
+    GALLERY_TRACE_SCOPE(lcThumbnails, "loadThumbnail");
+    GALLERY_METRIC_ADD("thumbnails.memory.misses", 1);
+
+    // Obtiene el thumbnail de la caché en disco (generado, por ejemplo, por
+    // la importación de carpetas) o lo decodifica directamente a su tamaño
+    auto thumbnail = new QPixmap(QPixmap::fromImage(mDiskCache.thumbnail(filepath)));
+    if (thumbnail->isNull()) {
+        qCDebug(lcThumbnails) << "Thumbnail nulo para:" << filepath;
+    }
+
+    return insertThumbnail(filepath, thumbnail);
+}
+
+// Guarda un thumbnail en la caché usando la ruta como clave
+// El coste es su tamaño en memoria (KB)
+QPixmap* ThumbnailProxyModel::insertThumbnail(const QString& filepath, QPixmap* thumbnail) const
+{
+    int cost = qMax(1, int(qint64(thumbnail->width()) * thumbnail->height()
+                           * thumbnail->depth() / 8 / 1024));
+    const qsizetype countBefore = mThumbnails.count() + (mThumbnails.contains(filepath) ? 0 : 1);
+    mThumbnails.insert(filepath, thumbnail, cost);
+
+    // Lo que falta respecto a antes de insertar lo ha expulsado QCache
+    GALLERY_METRIC_ADD("thumbnails.memory.evictions", countBefore - mThumbnails.count());
+    GALLERY_METRIC_SET("thumbnails.memory.kb", mThumbnails.totalCost());
+
+    // insert() libera el thumbnail si no cabe en la caché; se devuelve el
+    // que haya quedado guardado
+    return mThumbnails.object(filepath);
+}
 
-        // Se crea el thumbnail escalando el pixmap original
-        auto thumbnail = new QPixmap(
-            pixmap.scaled(
-                THUMBNAIL_SIZE,
-                THUMBNAIL_SIZE,
-                Qt::KeepAspectRatio,
-                Qt::SmoothTransformation
-                )
-            );
-
-        // Se guarda el thumbnail en el mapa usando la ruta como clave
-        mThumbnails.insert(filepath, thumbnail);
+// Añade a la caché thumbnails ya decodificados (instantánea de arranque),
+// para que el primer frame no tenga que leer la caché de disco
+void ThumbnailProxyModel::preloadThumbnails(const QHash<QString, QImage>& thumbnails)
+{
+    for (auto it = thumbnails.cbegin(); it != thumbnails.cend(); ++it) {
+        insertThumbnail(it.key(), new QPixmap(QPixmap::fromImage(it.value())));
     }
 }
 
-// Regenera todos los thumbnails desde cero
-void ThumbnailProxyModel::reloadThumbnails()
+// Devuelve el thumbnail de una imagen si está en la caché de memoria
+// (sin generarlo), o una imagen nula
+QImage ThumbnailProxyModel::cachedThumbnail(const QString& filepath) const
+{
+    QPixmap* thumbnail = mThumbnails.object(filepath);
+    return thumbnail ? thumbnail->toImage() : QImage();
+}
+
+// Indica si el thumbnail de una imagen ya está en la caché de memoria
+// (aunque sea nulo porque el archivo no existe), es decir, si pintarla no
+// tiene que decodificar nada
+bool ThumbnailProxyModel::isThumbnailCached(const QString& filepath) const
 {
-    qDebug() << "=== ThumbnailProxyModel::reloadThumbnails ===";
-    qDebug() << "rowCount():" << rowCount();
+    return mThumbnails.contains(filepath);
+}
 
-    // Elimina todos los QPixmap almacenados
-    qDeleteAll(mThumbnails);
-    mThumbnails.clear();
+// Genera los thumbnails que falten para las filas actuales del modelo
+// Los que siguen en la caché se reutilizan
+void ThumbnailProxyModel::reloadThumbnails()
+{
+    GALLERY_TRACE_SCOPE(lcThumbnails, "reloadThumbnails");
 
     // Genera thumbnails para todas las filas del modelo
     generateThumbnails(index(0, 0), rowCount());
 
-    qDebug() << "Thumbnails generados:" << mThumbnails.count();
+    qCDebug(lcThumbnails) << "Thumbnails en caché:" << mThumbnails.count();
 }
 
 // Asigna el modelo fuente al proxy
@@ -124,24 +155,32 @@ void ThumbnailProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
     }
 
     // Cuando el modelo se resetea completamente
+    // La carga se aplaza para que la vista pinte primero las filas visibles
     connect(sourceModel, &QAbstractItemModel::modelReset,
             [this] {
-                qDebug() << "ThumbnailProxyModel: modelReset recibido";
-                reloadThumbnails();
+                mPrefetchTimer.start();
             });
 
     // Cuando se insertan nuevas filas
     connect(sourceModel, &QAbstractItemModel::rowsInserted,
             [this] (const QModelIndex& parent, int first, int last) {
-                qDebug() << "ThumbnailProxyModel: rowsInserted" << first << last;
                 generateThumbnails(index(first, 0), last - first + 1);
             });
 
-    // Cuando cambian datos del modelo
+    // Cuando cambian datos del modelo, solo se regeneran las filas afectadas
+    // y solo si ha cambiado la ruta del archivo (lista vacía = todos los roles)
     connect(sourceModel, &QAbstractItemModel::dataChanged,
-            [this] (const QModelIndex& topLeft, const QModelIndex& bottomRight) {
-                qDebug() << "ThumbnailProxyModel: dataChanged recibido";
-                reloadThumbnails();
+            [this] (const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                    const QList<int>& roles) {
+                if (!roles.isEmpty() && !roles.contains(PictureModel::PictureRole::FilePathRole)) {
+                    return;
+                }
+                for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                    mThumbnails.remove(index(row, 0).data(
+                        PictureModel::PictureRole::FilePathRole).toString());
+                }
+                generateThumbnails(index(topLeft.row(), 0),
+                                   bottomRight.row() - topLeft.row() + 1);
             });
 }
 
@@ -158,8 +197,15 @@ QVariant ThumbnailProxyModel::data(const QModelIndex& index, int role) const
     QString filepath = sourceModel()->data(index,
                                            PictureModel::PictureRole::FilePathRole).toString();
 
-    // Devuelve el thumbnail asociado a esa ruta
-    return *mThumbnails[filepath];
+    // Devuelve el thumbnail asociado a esa ruta; si la caché lo ha
+    // descartado, se vuelve a generar
+    QPixmap* thumbnail = mThumbnails.object(filepath);
+    if (thumbnail) {
+        GALLERY_METRIC_ADD("thumbnails.memory.hits", 1);
+    } else {
+        thumbnail = loadThumbnail(filepath);
+    }
+    return thumbnail ? QVariant(*thumbnail) : QVariant();
 }
 
 // Devuelve el modelo fuente tipado como PictureModel
@@ -167,3 +213,9 @@ PictureModel* ThumbnailProxyModel::pictureModel() const
 {
     return static_cast<PictureModel*>(sourceModel());
 }
+
+// Devuelve la caché de thumbnails en disco (para generarlos por adelantado)
+const ThumbnailCache& ThumbnailProxyModel::diskCache() const
+{
+    return mDiskCache;
+}
@@ -2,24 +2,45 @@
 #define THUMBNAILPROXYMODEL_H
 
 #include <QIdentityProxyModel>
+#include <QCache>
 #include <QHash>
+#include <QImage>
 #include <QPixmap>
+#include <QTimer>
+#include "ThumbnailCache.h"
 
+class DatabaseManager;
 class PictureModel;
 
 class ThumbnailProxyModel : public QIdentityProxyModel
 {
 public:
-    ThumbnailProxyModel(QObject* parent = 0);
+    explicit ThumbnailProxyModel(DatabaseManager& database, QObject* parent = 0);
     QVariant data(const QModelIndex& index, int role) const override;
     PictureModel* pictureModel() const;
     void setSourceModel(QAbstractItemModel* sourceModel) override;
     void pictureActivated(QModelIndex const&);
+    const ThumbnailCache& diskCache() const;
+    void preloadThumbnails(const QHash<QString, QImage>& thumbnails);
+    QImage cachedThumbnail(const QString& filepath) const;
+    bool isThumbnailCached(const QString& filepath) const;
 
 private:
     void generateThumbnails(const QModelIndex& startIndex, int count);
     void reloadThumbnails();
-    QHash<QString, QPixmap*> mThumbnails;
+    QPixmap* loadThumbnail(const QString& filepath) const;
+    QPixmap* insertThumbnail(const QString& filepath, QPixmap* thumbnail) const;
+
+    // Thumbnails por ruta, limitados por memoria (coste en KB). Se conservan
+    // entre cambios de álbum, así que volver a un álbum reciente no decodifica nada
+    mutable QCache<QString, QPixmap> mThumbnails;
+
+    // Thumbnails en disco, compartidos con la importación de carpetas
+    ThumbnailCache mDiskCache;
+
+    // Tras un reinicio del modelo, los thumbnails que no están a la vista se
+    // cargan después de pintar (los visibles los pide la vista con data())
+    QTimer mPrefetchTimer;
 
 };
 
@@ -0,0 +1,439 @@
+#include "corpusgenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include "Album.h"
+#include "Albumdao.h"
+#include "DirectoryDao.h"
+#include "MetadataExtractor.h"
+#include "Picture.h"
+#include "PictureDao.h"
+#include "SearchDao.h"
+
+// Imágenes insertadas por transacción
+const int CATALOG_BATCH_SIZE = 1000;
+
+// Exponente de la distribución de Zipf de los tamaños de álbum
+const double ZIPF_EXPONENT = 1.1;
+
+// Fechas de captura generadas: de 2010 a 2025
+const qint64 FIRST_CAPTURE_TIME = 1262304000;       // 2010-01-01
+const qint64 CAPTURE_TIME_RANGE = 15LL * 365 * 24 * 3600;
+const qint64 ALBUM_TIME_SPAN = 30LL * 24 * 3600;    // Un álbum dura como mucho un mes
+
+// Figuras pintadas sobre el degradado de cada imagen
+const int SHAPES_PER_IMAGE = 12;
+
+// Etiquetas y tipos TIFF/EXIF escritos en los JPEG
+const quint16 TIFF_TYPE_ASCII = 2;
+const quint16 TIFF_TYPE_SHORT = 3;
+const quint16 TIFF_TYPE_LONG = 4;
+
+namespace {
+
+struct Resolution
+{
+    int width;
+    int height;
+    int weight;     // Frecuencia relativa
+};
+
+// Resoluciones de cámara y de móvil habituales (horizontales y verticales)
+const Resolution PHOTO_RESOLUTIONS[] = {
+    { 4032, 3024, 40 }, { 3024, 4032, 15 }, { 6000, 4000, 15 }, { 4000, 6000, 5 },
+    { 4000, 3000, 15 }, { 2048, 1536, 5 }, { 1600, 1200, 5 },
+};
+
+// Capturas de pantalla (PNG)
+const Resolution SCREENSHOT_RESOLUTIONS[] = {
+    { 1920, 1080, 40 }, { 2560, 1440, 25 }, { 1170, 2532, 25 }, { 2880, 1800, 10 },
+};
+
+struct Camera
+{
+    const char* make;
+    const char* model;
+};
+
+const Camera CAMERAS[] = {
+    { "Apple", "iPhone 13" }, { "Google", "Pixel 7" }, { "Canon", "Canon EOS R6" },
+    { "SONY", "ILCE-7M3" }, { "NIKON CORPORATION", "NIKON Z 6" },
+};
+
+/**
+ * Generador propio de cada imagen, derivado de la semilla global
+ * @param salt Distingue los usos (planificación, contenido) de la misma imagen
+ */
+QRandomGenerator pictureRandom(quint64 seed, int index, quint32 salt)
+{
+    const quint32 seeds[] = { quint32(seed), quint32(seed >> 32), quint32(index), salt };
+    return QRandomGenerator(seeds, 4);
+}
+
+template <size_t N>
+const Resolution& pickResolution(const Resolution (&resolutions)[N], QRandomGenerator& random)
+{
+    int total = 0;
+    for (const Resolution& resolution : resolutions) {
+        total += resolution.weight;
+    }
+    int value = random.bounded(total);
+    for (const Resolution& resolution : resolutions) {
+        if (value < resolution.weight) {
+            return resolution;
+        }
+        value -= resolution.weight;
+    }
+    return resolutions[0];
+}
+
+/**
+ * Construye un segmento APP1 "Exif" como el de una cámara
+ *
+ * IFD0 con fabricante, modelo, orientación y fecha, y un sub-IFD EXIF con
+ * DateTimeOriginal y las dimensiones (lo que lee MetadataExtractor).
+ */
+QByteArray exifSegment(const Camera& camera, int orientation, qint64 takenAt, QSize size)
+{
+    const QByteArray make = QByteArray(camera.make) + '\0';
+    const QByteArray model = QByteArray(camera.model) + '\0';
+    // Misma convención que MetadataExtractor: la hora EXIF es takenAt en UTC
+    const QByteArray date = QDateTime::fromSecsSinceEpoch(takenAt).toUTC()
+                                .toString("yyyy:MM:dd HH:mm:ss").toLatin1() + '\0';
+
+    const quint32 ifd0Offset = 8;
+    const quint32 exifIfdOffset = ifd0Offset + 2 + 5 * 12 + 4;
+    const quint32 makeOffset = exifIfdOffset + 2 + 3 * 12 + 4;
+    const quint32 modelOffset = makeOffset + make.size();
+    const quint32 dateOffset = modelOffset + model.size();
+    const quint32 dateOriginalOffset = dateOffset + date.size();
+
+    QByteArray tiff;
+    QDataStream out(&tiff, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    auto entry = [&out] (quint16 tag, quint16 type, quint32 count, quint32 value) {
+        out << tag << type << count << value;
+    };
+
+    out << quint8('I') << quint8('I') << quint16(42) << ifd0Offset;
+
+    out << quint16(5);
+    entry(0x010F, TIFF_TYPE_ASCII, make.size(), makeOffset);
+    entry(0x0110, TIFF_TYPE_ASCII, model.size(), modelOffset);
+    entry(0x0112, TIFF_TYPE_SHORT, 1, quint32(orientation));
+    entry(0x0132, TIFF_TYPE_ASCII, date.size(), dateOffset);
+    entry(0x8769, TIFF_TYPE_LONG, 1, exifIfdOffset);
+    out << quint32(0);
+
+    out << quint16(3);
+    entry(0x9003, TIFF_TYPE_ASCII, date.size(), dateOriginalOffset);
+    entry(0xA002, TIFF_TYPE_LONG, 1, quint32(size.width()));
+    entry(0xA003, TIFF_TYPE_LONG, 1, quint32(size.height()));
+    out << quint32(0);
+
+    out.writeRawData(make.constData(), make.size());
+    out.writeRawData(model.constData(), model.size());
+    out.writeRawData(date.constData(), date.size());
+    out.writeRawData(date.constData(), date.size());
+
+    const QByteArray payload = QByteArray("Exif\0\0", 6) + tiff;
+    const quint16 length = quint16(payload.size() + 2);
+    QByteArray segment;
+    segment.append(char(0xFF)).append(char(0xE1));
+    segment.append(char(length >> 8)).append(char(length & 0xFF));
+    return segment + payload;
+}
+
+}
+
+/**
+ * Constructor de CorpusGenerator
+ * @param options Opciones de generación
+ */
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options) :
+    mOptions(options)
+{
+}
+
+/**
+ * Genera el corpus completo: plan, imágenes (si se piden) y catálogo
+ * @return false si no se ha podido escribir el catálogo
+ */
+bool CorpusGenerator::run()
+{
+    QTextStream out(stdout);
+
+    planPictures();
+    out << "Planificadas " << mPictures.count() << " imágenes en "
+        << mOptions.albumCount << " álbumes (semilla " << mOptions.seed << ")\n";
+    out.flush();
+
+    if (!mOptions.imageDirectory.isEmpty()) {
+        renderPictures();
+    }
+    return writeCatalog();
+}
+
+/**
+ * Decide el álbum, la resolución, el formato y las fechas de cada imagen
+ *
+ * Los tamaños de los álbumes salen de la distribución elegida; el orden de
+ * los álbumes se baraja para que el más grande no sea siempre el primero.
+ */
+void CorpusGenerator::planPictures()
+{
+    QRandomGenerator random = pictureRandom(mOptions.seed, -1, 0);
+    const int albumCount = qMax(1, mOptions.albumCount);
+
+    // Peso de cada álbum
+    QVector<double> weights(albumCount, 1.0);
+    if (mOptions.distribution == CorpusOptions::ZipfAlbums) {
+        for (int album = 0; album < albumCount; ++album) {
+            weights[album] = 1.0 / std::pow(album + 1, ZIPF_EXPONENT);
+        }
+        std::shuffle(weights.begin(), weights.end(), random);
+    }
+    double totalWeight = 0;
+    for (double weight : std::as_const(weights)) {
+        totalWeight += weight;
+    }
+
+    // Número de imágenes de cada álbum; el resto del redondeo va a los primeros
+    QVector<int> sizes(albumCount);
+    int assigned = 0;
+    for (int album = 0; album < albumCount; ++album) {
+        sizes[album] = int(mOptions.pictureCount * weights[album] / totalWeight);
+        assigned += sizes[album];
+    }
+    for (int album = 0; assigned < mOptions.pictureCount; album = (album + 1) % albumCount) {
+        ++sizes[album];
+        ++assigned;
+    }
+
+    // Cada álbum cubre unas semanas a partir de una fecha aleatoria
+    QVector<qint64> albumStart(albumCount);
+    for (int album = 0; album < albumCount; ++album) {
+        albumStart[album] = FIRST_CAPTURE_TIME + qint64(random.bounded(double(CAPTURE_TIME_RANGE)));
+    }
+
+    mPictures.clear();
+    mPictures.reserve(mOptions.pictureCount);
+    for (int album = 0; album < albumCount; ++album) {
+        for (int i = 0; i < sizes[album]; ++i) {
+            const int index = mPictures.count();
+            QRandomGenerator pictureRng = pictureRandom(mOptions.seed, index, 1);
+
+            PlannedPicture picture;
+            picture.index = index;
+            picture.album = album;
+
+            const bool png = pictureRng.generateDouble() < mOptions.pngRatio;
+            const Resolution& resolution = png
+                ? pickResolution(SCREENSHOT_RESOLUTIONS, pictureRng)
+                : pickResolution(PHOTO_RESOLUTIONS, pictureRng);
+
+            PictureMetadata& metadata = picture.metadata;
+            metadata.width = resolution.width;
+            metadata.height = resolution.height;
+            metadata.takenAt = albumStart[album] + qint64(pictureRng.bounded(double(ALBUM_TIME_SPAN)));
+            metadata.modifiedAt = metadata.takenAt + pictureRng.bounded(3 * 24 * 3600);
+            metadata.mimeType = png ? "image/png" : "image/jpeg";
+
+            // Tamaño típico: 0,25-0,6 bytes por píxel en JPEG, 0,8-2 en PNG
+            const double bytesPerPixel = png ? 0.8 + 1.2 * pictureRng.generateDouble()
+                                             : 0.25 + 0.35 * pictureRng.generateDouble();
+            metadata.byteSize = qint64(double(resolution.width) * resolution.height * bytesPerPixel);
+
+            const int orientationRoll = pictureRng.bounded(100);
+            picture.orientation = orientationRoll < 90 ? 1 : orientationRoll < 96 ? 6
+                                  : orientationRoll < 98 ? 3 : 8;
+            picture.exif = !png && pictureRng.bounded(100) < 90;
+            picture.camera = pictureRng.bounded(int(std::size(CAMERAS)));
+
+            picture.relativePath = QString("album-%1/%2_%3.%4")
+                                       .arg(album, 4, 10, QChar('0'))
+                                       .arg(png ? "Screenshot" : "IMG")
+                                       .arg(index, 7, 10, QChar('0'))
+                                       .arg(png ? "png" : "jpg");
+            mPictures.append(picture);
+        }
+    }
+}
+
+/**
+ * Renderiza todas las imágenes en paralelo
+ */
+void CorpusGenerator::renderPictures()
+{
+    QThreadPool pool;
+    if (mOptions.threads > 0) {
+        pool.setMaxThreadCount(mOptions.threads);
+    }
+
+    QTextStream out(stdout);
+    out << "Renderizando imágenes en " << mOptions.imageDirectory << " con "
+        << pool.maxThreadCount() << " hilos\n";
+    out.flush();
+
+    QtConcurrent::blockingMap(&pool, mPictures, [this] (PlannedPicture& picture) {
+        renderPicture(picture);
+    });
+}
+
+/**
+ * Renderiza y guarda una imagen, y lee sus metadatos reales del archivo
+ *
+ * El contenido (degradado, figuras y ruido de sensor) hace que el JPEG pese
+ * aproximadamente lo mismo que una foto de esa resolución.
+ */
+void CorpusGenerator::renderPicture(PlannedPicture& picture) const
+{
+    QRandomGenerator random = pictureRandom(mOptions.seed, picture.index, 2);
+
+    QSize size(picture.metadata.width, picture.metadata.height);
+    if (mOptions.maxDimension > 0
+        && (size.width() > mOptions.maxDimension || size.height() > mOptions.maxDimension)) {
+        size.scale(mOptions.maxDimension, mOptions.maxDimension, Qt::KeepAspectRatio);
+    }
+
+    QImage image(size, QImage::Format_RGB32);
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        QLinearGradient gradient(0, 0, size.width(), size.height());
+        gradient.setColorAt(0, QColor::fromRgb(random.generate() | 0xFF000000));
+        gradient.setColorAt(1, QColor::fromRgb(random.generate() | 0xFF000000));
+        painter.fillRect(image.rect(), gradient);
+
+        painter.setPen(Qt::NoPen);
+        for (int shape = 0; shape < SHAPES_PER_IMAGE; ++shape) {
+            QColor color = QColor::fromRgb(random.generate());
+            color.setAlpha(64 + random.bounded(160));
+            painter.setBrush(color);
+            QRect rect(random.bounded(size.width()), random.bounded(size.height()),
+                       1 + random.bounded(size.width() / 2), 1 + random.bounded(size.height() / 2));
+            if (shape % 2) {
+                painter.drawEllipse(rect);
+            } else {
+                painter.drawRect(rect);
+            }
+        }
+    }
+
+    // Ruido de sensor: un xorshift basta y es mucho más rápido por píxel
+    quint32 noise = random.generate() | 1;
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+            const int delta = int(noise & 0x0F) - 8;
+            line[x] = qRgb(qBound(0, qRed(line[x]) + delta, 255),
+                           qBound(0, qGreen(line[x]) + delta, 255),
+                           qBound(0, qBlue(line[x]) + delta, 255));
+        }
+    }
+
+    const bool png = picture.metadata.mimeType == "image/png";
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, png ? "PNG" : "JPEG", png ? -1 : 85 + random.bounded(11));
+    buffer.close();
+
+    // El segmento EXIF va justo después del marcador SOI
+    if (!png && picture.exif && data.startsWith("\xFF\xD8")) {
+        data.insert(2, exifSegment(CAMERAS[picture.camera], picture.orientation,
+                                   picture.metadata.takenAt, size));
+    }
+
+    const QString filePath = QDir(mOptions.imageDirectory).filePath(picture.relativePath);
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        qWarning() << "No se pudo escribir" << filePath;
+        return;
+    }
+    file.setFileTime(QDateTime::fromSecsSinceEpoch(picture.metadata.modifiedAt),
+                     QFileDevice::FileModificationTime);
+    file.close();
+
+    picture.metadata = MetadataExtractor::extract(filePath);
+}
+
+/**
+ * Escribe los álbumes y las imágenes en el catálogo
+ *
+ * Usa los DAOs de gallerycore sobre una conexión propia, con las mismas
+ * tablas, índices y triggers que crea DatabaseManager.
+ */
+bool CorpusGenerator::writeCatalog()
+{
+    const QString connectionName = "gallerygen";
+    bool ok = true;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(mOptions.catalogPath);
+        if (!database.open()) {
+            qWarning() << "No se pudo abrir el catálogo" << mOptions.catalogPath;
+            ok = false;
+        } else {
+            QSqlQuery(database).exec("PRAGMA journal_mode = WAL");
+
+            // Mismo orden de inicialización que DatabaseManager
+            AlbumDao albumDao(database);
+            DirectoryDao directoryDao(database);
+            PictureDao pictureDao(database, directoryDao);
+            SearchDao searchDao(database);
+            albumDao.init();
+            directoryDao.init();
+            pictureDao.init();
+            searchDao.init();
+
+            database.transaction();
+            QVector<int> albumIds;
+            for (int album = 0; album < qMax(1, mOptions.albumCount); ++album) {
+                Album newAlbum(QString("Album %1").arg(album + 1, 4, 10, QChar('0')));
+                albumDao.addAlbum(newAlbum);
+                albumIds.append(newAlbum.id());
+            }
+            database.commit();
+
+            const QDir imageDirectory(mOptions.imageDirectory.isEmpty()
+                                          ? mOptions.pathPrefix : mOptions.imageDirectory);
+            QTextStream out(stdout);
+            for (int start = 0; start < mPictures.count(); start += CATALOG_BATCH_SIZE) {
+                const int end = qMin(start + CATALOG_BATCH_SIZE, int(mPictures.count()));
+                database.transaction();
+                for (int i = start; i < end; ++i) {
+                    const PlannedPicture& planned = mPictures[i];
+                    Picture picture(imageDirectory.filePath(planned.relativePath));
+                    picture.setMetadata(planned.metadata);
+                    pictureDao.addPictureInAlbum(albumIds[planned.album], picture);
+                }
+                database.commit();
+                out << "\rCatálogo: " << end << " / " << mPictures.count();
+                out.flush();
+            }
+            out << "\n";
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
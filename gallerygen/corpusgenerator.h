@@ -0,0 +1,71 @@
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include "PictureMetadata.h"
+
+/**
+ * Opciones de generación de un catálogo sintético
+ */
+struct CorpusOptions
+{
+    // Cómo se reparten las imágenes entre los álbumes
+    enum AlbumDistribution {
+        UniformAlbums,      // Todos los álbumes con un tamaño parecido
+        ZipfAlbums,         // Pocos álbumes enormes y muchos pequeños (como una galería real)
+    };
+
+    QString catalogPath = "gallery.db";     // Base de datos a crear o ampliar
+    QString imageDirectory;                 // Carpeta de las imágenes; vacía = no se generan archivos
+    QString pathPrefix = "/synthetic";      // Carpeta ficticia de las imágenes sin archivo
+    int albumCount = 200;
+    int pictureCount = 100000;
+    AlbumDistribution distribution = ZipfAlbums;
+    double pngRatio = 0.1;                  // Fracción de capturas de pantalla en PNG
+    int maxDimension = 0;                   // Límite de ancho y alto de los archivos (0 = real)
+    quint64 seed = 1;
+    int threads = 0;                        // Hilos de renderizado (0 = uno por núcleo)
+};
+
+/**
+ * Generador de catálogos e imágenes sintéticos y reproducibles
+ *
+ * Todo lo que se genera (tamaño de los álbumes, resolución, formato, fechas
+ * y contenido de cada imagen) sale de la semilla: cada imagen usa su propio
+ * generador, derivado de la semilla y de su número, así que el resultado es
+ * el mismo con cualquier número de hilos.
+ *
+ * Las imágenes se renderizan en paralelo; el catálogo se escribe con los DAOs
+ * de gallerycore en una conexión propia, por lotes dentro de transacciones.
+ */
+class CorpusGenerator
+{
+public:
+    explicit CorpusGenerator(const CorpusOptions& options);
+
+    bool run();
+
+private:
+    // Una imagen del corpus, decidida antes de renderizar nada
+    struct PlannedPicture
+    {
+        int index;                  // Número de la imagen en el corpus (semilla propia)
+        int album;                  // Posición del álbum (0..albumCount-1)
+        QString relativePath;       // Ruta relativa a la carpeta de imágenes
+        PictureMetadata metadata;
+        int orientation;            // Orientación EXIF (1 = normal)
+        bool exif;                  // Los JPEG sin EXIF simulan imágenes editadas
+        int camera;                 // Fabricante y modelo escritos en el EXIF
+    };
+
+    void planPictures();
+    void renderPictures();
+    void renderPicture(PlannedPicture& picture) const;
+    bool writeCatalog();
+
+    CorpusOptions mOptions;
+    QVector<PlannedPicture> mPictures;
+};
+
+#endif // CORPUSGENERATOR_H
@@ -0,0 +1,60 @@
+QT       += core gui sql concurrent widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = galleryreplay
+
+# Reproductor de escenarios de uso sobre la ventana de gallerydesktop
+#
+#   ./galleryreplay --catalog-dir corpus --cold scenarios/big-album.scenario --output replay.json
+#
+# Sale con código 1 si se supera algún presupuesto y 2 si el escenario no se
+# ha podido reproducir.
+
+SOURCES += \
+    main.cpp \
+    replayrunner.cpp \
+    scenario.cpp \
+    ../gallerydesktop/albumlistwidget.cpp \
+    ../gallerydesktop/albumwidget.cpp \
+    ../gallerydesktop/gallerywidget.cpp \
+    ../gallerydesktop/mainwindow.cpp \
+    ../gallerydesktop/metricspanel.cpp \
+    ../gallerydesktop/picturedelegate.cpp \
+    ../gallerydesktop/picturewidget.cpp \
+    ../gallerydesktop/thumbnailproxymodel.cpp
+
+HEADERS += \
+    replayrunner.h \
+    scenario.h \
+    ../gallerydesktop/albumlistwidget.h \
+    ../gallerydesktop/albumwidget.h \
+    ../gallerydesktop/gallerywidget.h \
+    ../gallerydesktop/mainwindow.h \
+    ../gallerydesktop/metricspanel.h \
+    ../gallerydesktop/picturedelegate.h \
+    ../gallerydesktop/picturewidget.h \
+    ../gallerydesktop/thumbnailproxymodel.h
+
+FORMS += \
+    ../gallerydesktop/albumlistwidget.ui \
+    ../gallerydesktop/albumwidget.ui \
+    ../gallerydesktop/gallerywidget.ui \
+    ../gallerydesktop/mainwindow.ui \
+    ../gallerydesktop/picturewidget.ui
+
+RESOURCES += \
+    ../gallerydesktop/resource.qrc
+
+DISTFILES += \
+    scenarios/big-album.scenario
+
+win32: LIBS += -lpsapi
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/release/ -lgallerycore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../gallerycore/debug/ -lgallerycore
+else:unix: LIBS += -L$$OUT_PWD/../gallerycore/ -lgallerycore
+
+INCLUDEPATH += $$PWD/../gallerycore $$PWD/../gallerydesktop
+DEPENDPATH += $$PWD/../gallerycore
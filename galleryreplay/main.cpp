@@ -0,0 +1,128 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QTextStream>
+#include "replayrunner.h"
+#include "scenario.h"
+#include "DatabaseManager.h"
+#include "Metrics.h"
+#include "ProfiledQuery.h"
+#include "ThumbnailCache.h"
+#include "Trace.h"
+
+/**
+ * Reproductor de escenarios de uso con presupuestos de latencia
+ *
+ * Abre la ventana de gallerydesktop sin pantalla (QT_QPA_PLATFORM=offscreen
+ * si no se indica otra plataforma) sobre un catálogo generado con gallerygen,
+ * reproduce un escenario (ver Scenario) y mide el arranque, el primer
+ * thumbnail, la pantalla completa, la latencia de cada paso y el pico de
+ * memoria. Termina con código 1 si se supera algún presupuesto, así que se
+ * puede lanzar cada noche contra cada versión candidata.
+ *
+ * Ejemplo:
+ * gallerygen --catalog corpus/gallery.db --pictures 100000 --images corpus/images
+ * galleryreplay --catalog-dir corpus --cold scenarios/big-album.scenario --output replay.json
+ */
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    // Caché de thumbnails e instantánea de arranque propias, separadas de
+    // las de gallerydesktop
+    QCoreApplication::setApplicationName("galleryreplay");
+
+    Trace::startFromEnvironment();
+    Metrics::instance().startFromEnvironment();
+    QueryProfiler::startFromEnvironment();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reproduce un escenario de uso y comprueba sus presupuestos de latencia");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scenario", "Archivo del escenario.");
+    QCommandLineOption catalogDirOption("catalog-dir", "Carpeta con el catálogo (gallery.db).", "directory", ".");
+    QCommandLineOption catalogOption("catalog", "Archivo del catálogo, relativo a --catalog-dir.", "file", DATABASE_FILENAME);
+    QCommandLineOption budgetOption("budget", "Presupuesto que sustituye al del escenario (métrica=valor).", "budget");
+    QCommandLineOption outputOption("output", "Archivo JSON con los resultados.", "file");
+    QCommandLineOption coldOption("cold", "Vacía la caché de thumbnails en disco antes de empezar.");
+    QCommandLineOption snapshotOption("startup-snapshot", "Arranca desde la instantánea de arranque.");
+    QCommandLineOption sizeOption("size", "Tamaño de la ventana.", "WxH", "1280x800");
+    parser.addOptions({ catalogDirOption, catalogOption, budgetOption, outputOption, coldOption, snapshotOption, sizeOption });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    Scenario scenario;
+    QString error;
+    if (!scenario.load(parser.positionalArguments().first(), &error)) {
+        err << error << "\n";
+        return 2;
+    }
+    for (const QString& budget : parser.values(budgetOption)) {
+        bool ok = false;
+        const double value = budget.section('=', 1).toDouble(&ok);
+        if (!ok || !budget.contains('=')) {
+            err << "Presupuesto incorrecto: " << budget << "\n";
+            return 2;
+        }
+        scenario.budgets.insert(budget.section('=', 0, 0), value);
+    }
+
+    const QStringList size = parser.value(sizeOption).split('x');
+    const QSize windowSize(size.value(0).toInt(), size.value(1).toInt());
+    if (windowSize.isEmpty()) {
+        err << "Tamaño de ventana incorrecto: " << parser.value(sizeOption) << "\n";
+        return 2;
+    }
+
+    // El catálogo se busca en la carpeta indicada; la variable GALLERY_CATALOG
+    // y la configuración no se usan, así que la medida no depende del entorno
+    if (!QDir::setCurrent(parser.value(catalogDirOption))) {
+        err << "No existe la carpeta " << parser.value(catalogDirOption) << "\n";
+        return 2;
+    }
+    DatabaseManager::setCatalogPath(parser.value(catalogOption));
+    if (parser.isSet(coldOption)) {
+        QDir(ThumbnailCache::defaultDirectory()).removeRecursively();
+    }
+
+    ReplayRunner runner(scenario, windowSize, parser.isSet(snapshotOption));
+    const bool completed = runner.run(&error);
+    runner.printReport(out);
+    out.flush();
+
+    if (parser.isSet(outputOption)) {
+        QSaveFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "No se puede escribir " << parser.value(outputOption) << "\n";
+            return 2;
+        }
+        file.write(QJsonDocument(runner.toJson()).toJson());
+        file.commit();
+    }
+
+    if (!completed) {
+        err << "Escenario interrumpido: " << error << "\n";
+        return 2;
+    }
+    const QStringList violations = runner.budgetViolations();
+    if (!violations.isEmpty()) {
+        err << "Presupuestos superados:\n";
+        for (const QString& violation : violations) {
+            err << "  " << violation << "\n";
+        }
+        return 1;
+    }
+    return 0;
+}
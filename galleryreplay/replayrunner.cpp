@@ -0,0 +1,536 @@
+#include "replayrunner.h"
+#include <algorithm>
+#include <cmath>
+#include <QApplication>
+#include <QJsonArray>
+#include <QListView>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSqlQuery>
+#include <QTextStream>
+#include "mainwindow.h"
+#include "thumbnailproxymodel.h"
+#include "AlbumModel.h"
+#include "Metrics.h"
+#include "Picturemodel.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// Tiempo máximo de un paso (o de una repetición) antes de darlo por colgado
+const qint64 STEP_TIMEOUT_MS = 30000;
+
+/**
+ * Percentil de unas muestras (nearest-rank), en ms
+ */
+static double percentileMs(QVector<qint64> samples, double percent)
+{
+    if (samples.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const int rank = qBound(1, int(std::ceil(percent / 100.0 * samples.size())), int(samples.size()));
+    return samples.at(rank - 1) / 1000000.0;
+}
+
+/**
+ * Constructor de ReplayRunner
+ * @param scenario Escenario a reproducir
+ * @param windowSize Tamaño de la ventana (fijo, para que el número de
+ *        thumbnails a la vista sea el mismo en todas las ejecuciones)
+ * @param useStartupSnapshot Arrancar desde la instantánea de arranque
+ */
+ReplayRunner::ReplayRunner(const Scenario& scenario, const QSize& windowSize, bool useStartupSnapshot) :
+    mScenario(scenario),
+    mWindowSize(windowSize),
+    mUseStartupSnapshot(useStartupSnapshot),
+    mWindow(nullptr),
+    mAlbumList(nullptr),
+    mThumbnailList(nullptr),
+    mThumbnailModel(nullptr),
+    mNextButton(nullptr),
+    mPreviousButton(nullptr),
+    mBackButton(nullptr),
+    mStartupNs(-1)
+{
+}
+
+ReplayRunner::~ReplayRunner()
+{
+    delete mWindow;
+}
+
+/**
+ * Abre la ventana y reproduce todos los pasos
+ * @param error Recibe el motivo si el escenario no se puede reproducir (un
+ *        álbum o una fila que no existen...); los presupuestos se comprueban
+ *        después con budgetViolations()
+ */
+bool ReplayRunner::run(QString* error)
+{
+    if (!openWindow(error)) {
+        return false;
+    }
+
+    for (const ScenarioStep& step : std::as_const(mScenario.steps)) {
+        StepResult result;
+        result.step = step;
+        const bool ok = runStep(step, result, error);
+        mResults.append(result);
+        if (!ok) {
+            *error = QString("línea %1 (%2): %3").arg(step.line).arg(step.command, *error);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Crea la ventana principal, espera a su primer frame y localiza los widgets
+ */
+bool ReplayRunner::openWindow(QString* error)
+{
+    bool firstFrame = false;
+    mStepTimer.start();
+    mWindow = new MainWindow(nullptr, mUseStartupSnapshot);
+    const QMetaObject::Connection connection =
+        QObject::connect(mWindow, &MainWindow::firstFrameShown, mWindow, [this, &firstFrame] {
+            mStartupNs = mStepTimer.nsecsElapsed();
+            firstFrame = true;
+        });
+    mWindow->resize(mWindowSize);
+    mWindow->show();
+
+    while (!firstFrame && mStepTimer.elapsed() < STEP_TIMEOUT_MS) {
+        QCoreApplication::processEvents();
+    }
+    QObject::disconnect(connection);
+    if (!firstFrame) {
+        *error = "la ventana no ha llegado a pintarse";
+        return false;
+    }
+
+    mAlbumList = mWindow->findChild<QListView*>("albumList");
+    mThumbnailList = mWindow->findChild<QListView*>("thumbnailListView");
+    mNextButton = mWindow->findChild<QPushButton*>("nextButton");
+    mPreviousButton = mWindow->findChild<QPushButton*>("previousButton");
+    mBackButton = mWindow->findChild<QPushButton*>("backButton");
+    mThumbnailModel = mThumbnailList ? dynamic_cast<ThumbnailProxyModel*>(mThumbnailList->model())
+                                     : nullptr;
+    if (!mAlbumList || !mThumbnailList || !mThumbnailModel
+        || !mNextButton || !mPreviousButton || !mBackButton) {
+        *error = "no se encuentran los widgets de la ventana principal";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reproduce un paso y guarda sus muestras en result
+ */
+bool ReplayRunner::runStep(const ScenarioStep& step, StepResult& result, QString* error)
+{
+    const QString& command = step.command;
+    const int count = step.arguments.isEmpty() ? 1 : step.arguments.first().toInt();
+
+    if (command == "open-album") {
+        return openAlbum(step.arguments.first(), result, error);
+    }
+    if (command == "scroll-page") {
+        scrollPages(count, result);
+    } else if (command == "scroll-end") {
+        scrollToEnd(result);
+    } else if (command == "open-picture") {
+        return openPicture(count, result, error);
+    } else if (command == "next") {
+        clickRepeatedly(mNextButton, count, result);
+    } else if (command == "previous") {
+        clickRepeatedly(mPreviousButton, count, result);
+    } else if (command == "back") {
+        mStepTimer.start();
+        mBackButton->click();
+        settle(true, result);
+        result.samplesNs.append(mStepTimer.nsecsElapsed());
+    } else if (command == "wait") {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < count) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, int(count - timer.elapsed()));
+        }
+    }
+    return true;
+}
+
+/**
+ * Selecciona un álbum en la lista, como un clic del usuario
+ * @param album "largest" (el que tiene más imágenes), "first" o un id
+ *
+ * Además de la latencia del paso (hasta la pantalla completa) guarda el
+ * tiempo hasta el primer thumbnail a la vista.
+ */
+bool ReplayRunner::openAlbum(const QString& album, StepResult& result, QString* error)
+{
+    AlbumModel* albumModel = qobject_cast<AlbumModel*>(mAlbumList->model());
+    if (!albumModel) {
+        *error = "la lista de álbumes no tiene un AlbumModel";
+        return false;
+    }
+
+    QModelIndex albumIndex;
+    if (album == "first") {
+        albumIndex = albumModel->index(0, 0);
+    } else if (album == "largest") {
+        QSqlQuery query("SELECT album_id FROM pictures GROUP BY album_id "
+                        "ORDER BY COUNT(*) DESC LIMIT 1");
+        if (query.next()) {
+            albumIndex = albumModel->indexForAlbumId(query.value(0).toInt());
+        }
+    } else {
+        albumIndex = albumModel->indexForAlbumId(album.toInt());
+    }
+    if (!albumIndex.isValid()) {
+        *error = "no existe el álbum '" + album + "'";
+        return false;
+    }
+
+    mStepTimer.start();
+    mAlbumList->selectionModel()->setCurrentIndex(albumIndex, QItemSelectionModel::ClearAndSelect);
+    settle(true, result);
+    result.samplesNs.append(mStepTimer.nsecsElapsed());
+    return true;
+}
+
+/**
+ * Baja una pantalla de thumbnails, count veces (una muestra por pantalla)
+ */
+void ReplayRunner::scrollPages(int count, StepResult& result)
+{
+    QScrollBar* scrollBar = mThumbnailList->verticalScrollBar();
+    for (int page = 0; page < count && !result.timedOut; ++page) {
+        mStepTimer.start();
+        scrollBar->setValue(scrollBar->value() + scrollBar->pageStep());
+        settle(true, result);
+        result.samplesNs.append(mStepTimer.nsecsElapsed());
+    }
+}
+
+/**
+ * Arrastra la barra hasta el final hasta que no quedan páginas por cargar
+ *
+ * Al llegar al final, la vista pide la siguiente página al modelo
+ * (fetchMore), igual que cuando el usuario baja con la rueda.
+ */
+void ReplayRunner::scrollToEnd(StepResult& result)
+{
+    QScrollBar* scrollBar = mThumbnailList->verticalScrollBar();
+    QAbstractItemModel* model = mThumbnailList->model();
+
+    mStepTimer.start();
+    int stableRounds = 0;
+    while (stableRounds < 2 && mStepTimer.elapsed() < STEP_TIMEOUT_MS) {
+        const int maximum = scrollBar->maximum();
+        scrollBar->setValue(maximum);
+        QCoreApplication::processEvents();
+
+        // La vista distribuye las filas nuevas más tarde: el final es firme
+        // cuando el máximo no cambia en dos vueltas y no quedan páginas
+        const bool atEnd = !model->canFetchMore(QModelIndex()) && scrollBar->maximum() == maximum;
+        stableRounds = atEnd ? stableRounds + 1 : 0;
+    }
+    settle(true, result);
+    result.samplesNs.append(mStepTimer.nsecsElapsed());
+}
+
+/**
+ * Abre una imagen de la galería, como un doble clic
+ */
+bool ReplayRunner::openPicture(int row, StepResult& result, QString* error)
+{
+    const QModelIndex index = mThumbnailList->model()->index(row, 0);
+    if (!index.isValid()) {
+        *error = QString("el álbum no tiene la fila %1").arg(row);
+        return false;
+    }
+
+    mStepTimer.start();
+    mThumbnailList->setCurrentIndex(index);
+    emit mThumbnailList->doubleClicked(index);
+    settle(false, result);
+    result.samplesNs.append(mStepTimer.nsecsElapsed());
+    return true;
+}
+
+/**
+ * Pulsa un botón count veces (una muestra por pulsación)
+ */
+void ReplayRunner::clickRepeatedly(QPushButton* button, int count, StepResult& result)
+{
+    for (int click = 0; click < count; ++click) {
+        mStepTimer.start();
+        button->click();
+        settle(false, result);
+        result.samplesNs.append(mStepTimer.nsecsElapsed());
+    }
+}
+
+/**
+ * Deja que la interfaz termine de reaccionar a la acción del paso
+ * @param waitForViewport Esperar a que todos los thumbnails a la vista estén
+ *        en la caché (y apuntar cuándo apareció el primero)
+ * @return false si se ha agotado el tiempo del paso
+ *
+ * Sin esperar a los thumbnails basta con procesar los eventos pendientes,
+ * entre ellos el repintado que ha provocado la acción.
+ */
+bool ReplayRunner::settle(bool waitForViewport, StepResult& result)
+{
+    if (!waitForViewport) {
+        QCoreApplication::sendPostedEvents();
+        QCoreApplication::processEvents();
+        return true;
+    }
+
+    while (mStepTimer.elapsed() < STEP_TIMEOUT_MS) {
+        QCoreApplication::processEvents();
+
+        bool anyCached = false;
+        const bool complete = viewportState(&anyCached);
+        if (anyCached && result.firstThumbnailNs < 0) {
+            result.firstThumbnailNs = mStepTimer.nsecsElapsed();
+        }
+        if (complete) {
+            if (result.fullViewportNs < 0) {
+                result.fullViewportNs = mStepTimer.nsecsElapsed();
+            }
+            return true;
+        }
+    }
+    result.timedOut = true;
+    return false;
+}
+
+/**
+ * Comprueba los thumbnails de las filas a la vista
+ * @param anyCached Recibe si alguno ya está en la caché de memoria
+ * @return true si lo están todos (o el álbum está vacío)
+ */
+bool ReplayRunner::viewportState(bool* anyCached) const
+{
+    *anyCached = false;
+    const QAbstractItemModel* model = mThumbnailList->model();
+    const int rowCount = model->rowCount();
+    if (rowCount == 0) {
+        return true;
+    }
+
+    // Busca una fila a la vista probando puntos repartidos por la pantalla
+    // (entre thumbnails hay espacio vacío); sin ninguna, la vista aún no ha
+    // distribuido las filas
+    const QRect viewport = mThumbnailList->viewport()->rect();
+    QModelIndex visible;
+    for (int y = 0; y < 4 && !visible.isValid(); ++y) {
+        for (int x = 0; x < 4 && !visible.isValid(); ++x) {
+            visible = mThumbnailList->indexAt(QPoint(viewport.width() * (2 * x + 1) / 8,
+                                                     viewport.height() * (2 * y + 1) / 8));
+        }
+    }
+    if (!visible.isValid()) {
+        return false;
+    }
+
+    int first = visible.row();
+    while (first > 0 && mThumbnailList->visualRect(model->index(first - 1, 0)).intersects(viewport)) {
+        --first;
+    }
+    int last = visible.row();
+    while (last + 1 < rowCount && mThumbnailList->visualRect(model->index(last + 1, 0)).intersects(viewport)) {
+        ++last;
+    }
+
+    bool complete = true;
+    for (int row = first; row <= last; ++row) {
+        const QString filePath = model->index(row, 0).data(PictureModel::FilePathRole).toString();
+        if (mThumbnailModel->isThumbnailCached(filePath)) {
+            *anyCached = true;
+        } else {
+            complete = false;
+        }
+    }
+    return complete;
+}
+
+/**
+ * Métricas de la ejecución, en ms (peak-rss-mb en MB)
+ *
+ * first-thumbnail y full-viewport son el peor open-album; las latencias de
+ * cada orden juntan las muestras de todos sus pasos.
+ */
+QMap<QString, double> ReplayRunner::summary() const
+{
+    QMap<QString, double> values;
+    if (mStartupNs >= 0) {
+        values.insert("startup", mStartupNs / 1000000.0);
+    }
+
+    QMap<QString, QVector<qint64>> samplesByCommand;
+    for (const StepResult& result : mResults) {
+        samplesByCommand[result.step.command] += result.samplesNs;
+        if (result.step.command == "open-album") {
+            if (result.firstThumbnailNs >= 0) {
+                values.insert("first-thumbnail", qMax(values.value("first-thumbnail"),
+                                                      result.firstThumbnailNs / 1000000.0));
+            }
+            if (result.fullViewportNs >= 0) {
+                values.insert("full-viewport", qMax(values.value("full-viewport"),
+                                                    result.fullViewportNs / 1000000.0));
+            }
+        }
+    }
+    for (auto it = samplesByCommand.cbegin(); it != samplesByCommand.cend(); ++it) {
+        if (it.value().isEmpty()) {
+            continue;
+        }
+        values.insert(it.key() + ".p50", percentileMs(it.value(), 50));
+        values.insert(it.key() + ".p95", percentileMs(it.value(), 95));
+        values.insert(it.key() + ".max", percentileMs(it.value(), 100));
+    }
+
+    values.insert("peak-rss-mb", peakResidentBytes() / (1024.0 * 1024.0));
+    return values;
+}
+
+/**
+ * Presupuestos superados y pasos que no han terminado a tiempo
+ * @return Vacía si la ejecución cumple todos los presupuestos
+ */
+QStringList ReplayRunner::budgetViolations() const
+{
+    QStringList violations;
+    for (const StepResult& result : mResults) {
+        if (result.timedOut) {
+            violations << QString("línea %1 (%2): no ha terminado en %3 s")
+                              .arg(result.step.line).arg(result.step.command).arg(STEP_TIMEOUT_MS / 1000);
+        }
+    }
+
+    const QMap<QString, double> values = summary();
+    for (auto it = mScenario.budgets.cbegin(); it != mScenario.budgets.cend(); ++it) {
+        if (!values.contains(it.key())) {
+            violations << it.key() + ": el escenario no la mide";
+        } else if (values.value(it.key()) > it.value()) {
+            violations << QString("%1: %2 > %3").arg(it.key())
+                              .arg(values.value(it.key()), 0, 'f', 1).arg(it.value());
+        }
+    }
+    return violations;
+}
+
+/**
+ * Resultados en JSON: pasos, resumen, presupuestos, incumplimientos y las
+ * métricas de la aplicación (ver Metrics) al terminar
+ */
+QJsonObject ReplayRunner::toJson() const
+{
+    QJsonArray steps;
+    for (const StepResult& result : mResults) {
+        QJsonObject step;
+        step.insert("line", result.step.line);
+        step.insert("command", result.step.command);
+        step.insert("arguments", QJsonArray::fromStringList(result.step.arguments));
+        step.insert("samples", int(result.samplesNs.size()));
+        if (!result.samplesNs.isEmpty()) {
+            step.insert("p50Ms", percentileMs(result.samplesNs, 50));
+            step.insert("p95Ms", percentileMs(result.samplesNs, 95));
+            step.insert("maxMs", percentileMs(result.samplesNs, 100));
+        }
+        if (result.firstThumbnailNs >= 0) {
+            step.insert("firstThumbnailMs", result.firstThumbnailNs / 1000000.0);
+        }
+        if (result.fullViewportNs >= 0) {
+            step.insert("fullViewportMs", result.fullViewportNs / 1000000.0);
+        }
+        step.insert("timedOut", result.timedOut);
+        steps.append(step);
+    }
+
+    QJsonObject summaryJson;
+    const QMap<QString, double> values = summary();
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        summaryJson.insert(it.key(), it.value());
+    }
+    QJsonObject budgets;
+    for (auto it = mScenario.budgets.cbegin(); it != mScenario.budgets.cend(); ++it) {
+        budgets.insert(it.key(), it.value());
+    }
+
+    QJsonObject json;
+    json.insert("steps", steps);
+    json.insert("summary", summaryJson);
+    json.insert("budgets", budgets);
+    json.insert("violations", QJsonArray::fromStringList(budgetViolations()));
+    json.insert("metrics", Metrics::instance().toJson());
+    return json;
+}
+
+/**
+ * Escribe un resumen legible: cada paso y cada métrica con su presupuesto
+ */
+void ReplayRunner::printReport(QTextStream& out) const
+{
+    for (const StepResult& result : mResults) {
+        out << QString("%1 %2").arg(result.step.line, 4)
+                   .arg((result.step.command + " " + result.step.arguments.join(' ')).leftJustified(24));
+        if (!result.samplesNs.isEmpty()) {
+            out << QString(" p50 %1 ms  p95 %2 ms  max %3 ms  (%4)")
+                       .arg(percentileMs(result.samplesNs, 50), 8, 'f', 1)
+                       .arg(percentileMs(result.samplesNs, 95), 8, 'f', 1)
+                       .arg(percentileMs(result.samplesNs, 100), 8, 'f', 1)
+                       .arg(result.samplesNs.size());
+        }
+        if (result.timedOut) {
+            out << "  SIN TERMINAR";
+        }
+        out << "\n";
+    }
+
+    out << "\n";
+    const QMap<QString, double> values = summary();
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        out << QString("%1 %2").arg(it.key().leftJustified(20)).arg(it.value(), 10, 'f', 1);
+        if (mScenario.budgets.contains(it.key())) {
+            const double budget = mScenario.budgets.value(it.key());
+            out << QString("  (presupuesto %1%2)").arg(budget).arg(it.value() > budget ? ", SUPERADO" : "");
+        }
+        out << "\n";
+    }
+}
+
+/**
+ * Pico de memoria residente del proceso, en bytes (0 si no se puede saber)
+ */
+qint64 ReplayRunner::peakResidentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(Q_OS_MACOS)
+    return qint64(usage.ru_maxrss);             // En bytes
+#else
+    return qint64(usage.ru_maxrss) * 1024;      // En KB
+#endif
+#else
+    return 0;
+#endif
+}
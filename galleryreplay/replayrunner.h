@@ -0,0 +1,83 @@
+#ifndef REPLAYRUNNER_H
+#define REPLAYRUNNER_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QSize>
+#include <QVector>
+#include "scenario.h"
+
+class MainWindow;
+class QListView;
+class QPushButton;
+class QTextStream;
+class ThumbnailProxyModel;
+
+/**
+ * Resultado de un paso del escenario
+ */
+struct StepResult
+{
+    ScenarioStep step;
+    QVector<qint64> samplesNs;      // Una muestra por repetición (next 100 = 100 muestras)
+    qint64 firstThumbnailNs = -1;   // Solo open-album
+    qint64 fullViewportNs = -1;     // Solo open-album
+    bool timedOut = false;
+};
+
+/**
+ * Reproduce un escenario sobre la ventana principal y mide cada paso
+ *
+ * La ventana se crea y se maneja como lo haría un usuario: seleccionando en
+ * la lista de álbumes, moviendo la barra de desplazamiento y pulsando los
+ * botones de la vista de imagen (los widgets se buscan por su objectName).
+ * Cada paso se mide desde la acción hasta que la interfaz ha terminado de
+ * reaccionar; en los pasos que cambian los thumbnails a la vista, hasta que
+ * todos los visibles están en la caché de memoria.
+ */
+class ReplayRunner
+{
+public:
+    ReplayRunner(const Scenario& scenario, const QSize& windowSize, bool useStartupSnapshot);
+    ~ReplayRunner();
+
+    bool run(QString* error);
+
+    QMap<QString, double> summary() const;
+    QStringList budgetViolations() const;
+    QJsonObject toJson() const;
+    void printReport(QTextStream& out) const;
+
+    static qint64 peakResidentBytes();
+
+private:
+    bool openWindow(QString* error);
+    bool runStep(const ScenarioStep& step, StepResult& result, QString* error);
+    bool openAlbum(const QString& album, StepResult& result, QString* error);
+    void scrollPages(int count, StepResult& result);
+    void scrollToEnd(StepResult& result);
+    bool openPicture(int row, StepResult& result, QString* error);
+    void clickRepeatedly(QPushButton* button, int count, StepResult& result);
+
+    bool settle(bool waitForViewport, StepResult& result);
+    bool viewportState(bool* anyCached) const;
+
+    Scenario mScenario;
+    QSize mWindowSize;
+    bool mUseStartupSnapshot;
+
+    MainWindow* mWindow;
+    QListView* mAlbumList;
+    QListView* mThumbnailList;
+    ThumbnailProxyModel* mThumbnailModel;
+    QPushButton* mNextButton;
+    QPushButton* mPreviousButton;
+    QPushButton* mBackButton;
+
+    QElapsedTimer mStepTimer;
+    qint64 mStartupNs;
+    QVector<StepResult> mResults;
+};
+
+#endif // REPLAYRUNNER_H
@@ -0,0 +1,104 @@
+#include "scenario.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+
+/**
+ * Orden de escenario y cuántos argumentos admite
+ */
+struct CommandSpec
+{
+    const char* name;
+    int minArguments;
+    int maxArguments;
+};
+
+static const CommandSpec COMMANDS[] = {
+    { "open-album", 1, 1 },
+    { "scroll-page", 0, 1 },
+    { "scroll-end", 0, 0 },
+    { "open-picture", 1, 1 },
+    { "next", 0, 1 },
+    { "previous", 0, 1 },
+    { "back", 0, 0 },
+    { "wait", 1, 1 },
+};
+
+/**
+ * Lee un escenario
+ * @param filePath Archivo del escenario
+ * @param error Recibe el motivo si el archivo no es válido
+ * @return false si no se puede leer o tiene alguna línea incorrecta
+ *
+ * Todas las órdenes se comprueban aquí, antes de abrir la ventana: un error
+ * de escritura no debe descubrirse a mitad de una ejecución nocturna.
+ */
+bool Scenario::load(const QString& filePath, QString* error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "No se puede abrir " + filePath;
+        return false;
+    }
+
+    steps.clear();
+    budgets.clear();
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        ++lineNumber;
+        QString line = in.readLine();
+        line = line.left(line.indexOf('#')).trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QStringList words = line.split(QRegularExpression("\\s+"));
+        const QString command = words.takeFirst();
+        const QString where = QString("%1:%2: ").arg(filePath).arg(lineNumber);
+
+        if (command == "budget") {
+            bool ok = false;
+            const double value = words.value(1).toDouble(&ok);
+            if (words.size() != 2 || !ok || value < 0) {
+                *error = where + "se esperaba 'budget <métrica> <valor>'";
+                return false;
+            }
+            budgets.insert(words.first(), value);
+            continue;
+        }
+
+        const CommandSpec* spec = nullptr;
+        for (const CommandSpec& candidate : COMMANDS) {
+            if (command == candidate.name) {
+                spec = &candidate;
+            }
+        }
+        if (!spec) {
+            *error = where + "orden desconocida '" + command + "'";
+            return false;
+        }
+        if (words.size() < spec->minArguments || words.size() > spec->maxArguments) {
+            *error = where + "número de argumentos incorrecto para '" + command + "'";
+            return false;
+        }
+
+        // Los argumentos numéricos (todos menos el álbum) deben serlo
+        if (command != "open-album" && !words.isEmpty()) {
+            bool ok = false;
+            if (words.first().toInt(&ok) < 0 || !ok) {
+                *error = where + "'" + words.first() + "' no es un número válido";
+                return false;
+            }
+        }
+
+        steps.append({ lineNumber, command, words });
+    }
+
+    if (steps.isEmpty()) {
+        *error = filePath + ": el escenario no tiene ningún paso";
+        return false;
+    }
+    return true;
+}
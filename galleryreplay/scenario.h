@@ -0,0 +1,50 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Paso de un escenario: una orden con sus argumentos
+ */
+struct ScenarioStep
+{
+    int line;               // Línea del archivo, para los mensajes
+    QString command;
+    QStringList arguments;
+};
+
+/**
+ * Escenario de uso que galleryreplay reproduce sobre la ventana principal
+ *
+ * Es un archivo de texto con una orden por línea; "#" empieza un comentario.
+ *
+ * Órdenes:
+ *   open-album largest|first|<id>  Selecciona un álbum en la lista
+ *   scroll-page [veces]            Baja una pantalla de thumbnails (cada vez es una muestra)
+ *   scroll-end                     Baja hasta la última imagen (cargando todas las páginas)
+ *   open-picture <fila>            Abre una imagen como con doble clic
+ *   next [veces]                   Botón "siguiente" en la vista de imagen
+ *   previous [veces]               Botón "anterior" en la vista de imagen
+ *   back                           Vuelve a la galería
+ *   wait <ms>                      Deja correr el bucle de eventos
+ *
+ * Presupuestos (en ms, salvo peak-rss-mb): si alguno se supera, galleryreplay
+ * termina con error.
+ *   budget startup <ms>            Hasta el primer frame de la ventana
+ *   budget first-thumbnail <ms>    Peor open-album hasta el primer thumbnail
+ *   budget full-viewport <ms>      Peor open-album hasta la pantalla completa
+ *   budget <orden>.p50|p95|max <ms>  Latencia de los pasos de una orden
+ *   budget peak-rss-mb <MB>        Pico de memoria residente del proceso
+ */
+struct Scenario
+{
+    QVector<ScenarioStep> steps;
+    QMap<QString, double> budgets;
+
+    bool load(const QString& filePath, QString* error);
+};
+
+#endif // SCENARIO_H